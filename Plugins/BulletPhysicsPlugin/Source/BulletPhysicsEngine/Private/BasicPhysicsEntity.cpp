@@ -23,11 +23,23 @@ void ABasicPhysicsEntity::BeginPlay()
 	world = Cast<ATestActor>(worlds[0]);	// this will crash if no bullet world is present
 											// if you ain't crashed, the reference is valid
 	BulletWorld = world;
-	MyRigidBody = world->AddRigidBodyAndReturn(this, 0.2, 0.2, 1);
+	MyRigidBody = world->AddRigidBodyAndReturn(this, 0.2, 0.2, 1, CollisionLayer);
 	if (!MyRigidBody) { GEngine->AddOnScreenDebugMessage(-1, 5.0f, FColor::Red, TEXT("WARNING RigidBody ptr is null")); }
 
 	BulletWorld->ActorToBody.Add(this, MyRigidBody);
 	BulletWorld->BodyToActor.Add(MyRigidBody, this);
+	// whoever fired us (owner2 in shootThing) is never hit
+	if (GetOwner()) { BulletWorld->IgnoreActorCollision(MyRigidBody, GetOwner()); }
+	if (bProjectileCcd) { BulletWorld->EnableProjectileCcd(MyRigidBody, ProjectileRadius); }
+}
+
+void ABasicPhysicsEntity::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// hand the body back to the world so it isn't simulated (or leaked) after we're gone
+	if (BulletWorld && MyRigidBody) { BulletWorld->DestroyRigidBody(MyRigidBody); }
+	MyRigidBody = nullptr;
+
+	Super::EndPlay(EndPlayReason);
 }
 
 void ABasicPhysicsEntity::Tick(float DeltaTime)
@@ -39,18 +39,27 @@ void ABasicPhysicsPawn::BeginPlay()
 	world = Cast<ATestActor>(worlds[0]); // this will crash if no world is present
 										// if you ain't crashed, the reference is valid
 	BulletWorld = world;
-	MyRigidBody = world->AddRigidBodyAndReturn(this, 0.2, 0.2, 1);
+	MyRigidBody = world->AddRigidBodyAndReturn(this, 0.2, 0.2, 1, CollisionLayer);
 	if (!MyRigidBody) { GEngine->AddOnScreenDebugMessage(-1, 5.0f, FColor::Red, TEXT("WARNING RigidBody ptr is null")); }
 
-	if (IsLocallyControlled())
-	{
-		BulletWorld->LocalPawn = this;
-	}
+	UpdateLocalPawn();
 
 	BulletWorld->ActorToBody.Add(this, MyRigidBody);
 	BulletWorld->BodyToActor.Add(MyRigidBody, this);
 }
 
+void ABasicPhysicsPawn::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (BulletWorld)
+	{
+		if (MyRigidBody) { BulletWorld->DestroyRigidBody(MyRigidBody); }
+		if (BulletWorld->LocalPawn == this) { BulletWorld->LocalPawn = nullptr; }
+	}
+	MyRigidBody = nullptr;
+
+	Super::EndPlay(EndPlayReason);
+}
+
 void ABasicPhysicsPawn::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
@@ -60,26 +69,35 @@ void ABasicPhysicsPawn::Tick(float DeltaTime)
 void ABasicPhysicsPawn::AsyncPhysicsTickActor(float DeltaTime, float SimTime)
 {
 	Super::AsyncPhysicsTickActor(DeltaTime, SimTime);
+	// inputs are produced by the world for each tick it simulates, see ProduceInput
+}
 
+void ABasicPhysicsPawn::ProduceInput(int32 Tick)
+{
+	FTWPlayerInput input = FTWPlayerInput();
+	input.MovementInput = CurrentDirectionalInput;
+	input.TurnRight = CurrentTurnRight;
+	input.TurnUp = CurrentTurnUp;
+	input.RollRight = CurrentRollRight;
+	input.BoostInput = CurrentBoostInput;
+	input.Tick = Tick;
+	// input.RotationInput = GetControlRotation(); // depricated
+	BulletWorld->LocalInputBuffer.Push(input);
+	ApplyInputsAndWake(input);
 	// send inputs to the server
-	if (IsLocallyControlled())
-	{
-		FTWPlayerInput input = FTWPlayerInput();
-		input.MovementInput = CurrentDirectionalInput;
-		input.TurnRight = CurrentTurnRight;
-		input.TurnUp = CurrentTurnUp;
-		input.RollRight = CurrentRollRight;
-		input.BoostInput = CurrentBoostInput;
-		// input.RotationInput = GetControlRotation(); // depricated
-		BulletWorld->LocalInputBuffer.Push(input);
-		ApplyInputs(input);
-		if (!HasAuthority()) {SendInputsToServer(this, input);}
-	}
+	if (!HasAuthority()) {SendInputsToServer(this, input);}
 }
 
 // override this function when creating children
 void ABasicPhysicsPawn::ApplyInputs(const FTWPlayerInput& input) {}
 
+void ABasicPhysicsPawn::ApplyInputsAndWake(const FTWPlayerInput& input)
+{
+	// runs on the server, the predicting client and in resims alike, so all of them wake the body on the same frame
+	if (MyRigidBody && !input.IsIdle()) { MyRigidBody->activate(); }
+	ApplyInputs(input);
+}
+
 void ABasicPhysicsPawn::ServerTestSimple_Implementation()
 {
 	GEngine->AddOnScreenDebugMessage(-1, 5.0f, FColor::Green, TEXT("Simple RPC worked!"));
@@ -90,16 +108,36 @@ void ABasicPhysicsPawn::PossessedBy(AController* NewController)
 	Super::PossessedBy(NewController);
 	
 	IsPossessed = true;
-	if (BulletWorld && IsLocallyControlled())
-	{
-		BulletWorld->LocalPawn = this;
-	}
+	UpdateLocalPawn();
 }
 
 void ABasicPhysicsPawn::UnPossessed()
 {
 	Super::UnPossessed();
 	IsPossessed = false;
+	UpdateLocalPawn();
+}
+
+// PossessedBy only runs on the server. The owning client hears about it here, and the controller often replicates
+// after BeginPlay, so the check there comes too early
+void ABasicPhysicsPawn::PawnClientRestart()
+{
+	Super::PawnClientRestart();
+	UpdateLocalPawn();
+}
+
+void ABasicPhysicsPawn::OnRep_Controller()
+{
+	Super::OnRep_Controller();
+	UpdateLocalPawn();
+}
+
+void ABasicPhysicsPawn::UpdateLocalPawn()
+{
+	// the world only produces inputs for its LocalPawn
+	if (!BulletWorld) { return; }
+	if (IsLocallyControlled()) { BulletWorld->LocalPawn = this; }
+	else if (BulletWorld->LocalPawn == this) { BulletWorld->LocalPawn = nullptr; }
 }
 
 void ABasicPhysicsPawn::SetupPlayerInputComponent(class UInputComponent* ThisInputComponent)
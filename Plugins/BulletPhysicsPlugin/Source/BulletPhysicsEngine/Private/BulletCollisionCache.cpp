@@ -0,0 +1,526 @@
+#include "BulletCollisionCache.h"
+
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "UObject/Package.h"
+
+THIRD_PARTY_INCLUDES_START
+PRAGMA_PUSH_PLATFORM_DEFAULT_PACKING
+#include <btBulletCollisionCommon.h>
+#include <LinearMath/btSerializer.h>
+#include <BulletCollision/CollisionShapes/btConvexPolyhedron.h>
+#include <BulletCollision/CollisionShapes/btSdfCollisionShape.h>
+#include <BulletCollision/CollisionShapes/btSdfBrickGrid.h>
+#include <BulletCollision/CollisionDispatch/btCollisionWorldImporter.h>
+PRAGMA_POP_PLATFORM_DEFAULT_PACKING
+THIRD_PARTY_INCLUDES_END
+
+// Bullet doesn't serialize btConvexPolyhedron, so hulls get an extra chunk of our own
+#define BT_COOKED_POLYHEDRON_CODE BT_MAKE_ID('P', 'O', 'L', 'Y')
+// nor btSdfCollisionShape
+#define BT_COOKED_SDF_CODE BT_MAKE_ID('S', 'D', 'F', 'B')
+
+namespace
+{
+	// Followed by vertices, unique edges and face planes (btVector3FloatData each),
+	// then per-face index counts and the flattened face indices
+	struct CookedPolyhedronHeader
+	{
+		void* Hull; // unique pointer of the hull's shape chunk
+		int NumVertices;
+		int NumUniqueEdges;
+		int NumFaces;
+		int NumFaceIndices;
+		btVector3FloatData LocalCenter;
+		btVector3FloatData Extents;
+		btVector3FloatData C;
+		btVector3FloatData E;
+		float Radius;
+		int Padding[3];
+	};
+
+	void WritePolyhedron(btSerializer* Serializer, btConvexHullShape* Hull)
+	{
+		const btConvexPolyhedron* Poly = Hull->getConvexPolyhedron();
+		if (!Poly) return;
+
+		int NumFaceIndices = 0;
+		for (int i = 0; i < Poly->m_faces.size(); i++) NumFaceIndices += Poly->m_faces[i].m_indices.size();
+
+		const int NumVectors = Poly->m_vertices.size() + Poly->m_uniqueEdges.size() + Poly->m_faces.size();
+		int Size = sizeof(CookedPolyhedronHeader) + NumVectors * sizeof(btVector3FloatData)
+			+ (Poly->m_faces.size() + NumFaceIndices) * sizeof(int);
+		Size = (Size + 7) & ~7;
+
+		btChunk* Chunk = Serializer->allocate(Size, 1);
+		uint8* Data = static_cast<uint8*>(Chunk->m_oldPtr);
+		FMemory::Memzero(Data, Size);
+
+		CookedPolyhedronHeader* Header = reinterpret_cast<CookedPolyhedronHeader*>(Data);
+		Header->Hull = Serializer->getUniquePointer(Hull);
+		Header->NumVertices = Poly->m_vertices.size();
+		Header->NumUniqueEdges = Poly->m_uniqueEdges.size();
+		Header->NumFaces = Poly->m_faces.size();
+		Header->NumFaceIndices = NumFaceIndices;
+		Poly->m_localCenter.serializeFloat(Header->LocalCenter);
+		Poly->m_extents.serializeFloat(Header->Extents);
+		Poly->mC.serializeFloat(Header->C);
+		Poly->mE.serializeFloat(Header->E);
+		Header->Radius = Poly->m_radius;
+
+		btVector3FloatData* Vectors = reinterpret_cast<btVector3FloatData*>(Header + 1);
+		for (int i = 0; i < Poly->m_vertices.size(); i++) Poly->m_vertices[i].serializeFloat(*Vectors++);
+		for (int i = 0; i < Poly->m_uniqueEdges.size(); i++) Poly->m_uniqueEdges[i].serializeFloat(*Vectors++);
+		for (int i = 0; i < Poly->m_faces.size(); i++)
+		{
+			for (int k = 0; k < 4; k++) Vectors->m_floats[k] = Poly->m_faces[i].m_plane[k];
+			Vectors++;
+		}
+		int* Ints = reinterpret_cast<int*>(Vectors);
+		for (int i = 0; i < Poly->m_faces.size(); i++) *Ints++ = Poly->m_faces[i].m_indices.size();
+		for (int i = 0; i < Poly->m_faces.size(); i++)
+		{
+			for (int k = 0; k < Poly->m_faces[i].m_indices.size(); k++) *Ints++ = Poly->m_faces[i].m_indices[k];
+		}
+
+		Serializer->finalizeChunk(Chunk, "char", BT_COOKED_POLYHEDRON_CODE, (void*)Poly);
+	}
+
+	void ReadPolyhedron(const CookedPolyhedronHeader* Header, btConvexHullShape* Hull)
+	{
+		btConvexPolyhedron Poly;
+		Poly.m_localCenter.deSerializeFloat(Header->LocalCenter);
+		Poly.m_extents.deSerializeFloat(Header->Extents);
+		Poly.mC.deSerializeFloat(Header->C);
+		Poly.mE.deSerializeFloat(Header->E);
+		Poly.m_radius = Header->Radius;
+
+		const btVector3FloatData* Vectors = reinterpret_cast<const btVector3FloatData*>(Header + 1);
+		Poly.m_vertices.resize(Header->NumVertices);
+		for (int i = 0; i < Header->NumVertices; i++) Poly.m_vertices[i].deSerializeFloat(*Vectors++);
+		Poly.m_uniqueEdges.resize(Header->NumUniqueEdges);
+		for (int i = 0; i < Header->NumUniqueEdges; i++) Poly.m_uniqueEdges[i].deSerializeFloat(*Vectors++);
+		Poly.m_faces.resize(Header->NumFaces);
+		for (int i = 0; i < Header->NumFaces; i++)
+		{
+			for (int k = 0; k < 4; k++) Poly.m_faces[i].m_plane[k] = Vectors->m_floats[k];
+			Vectors++;
+		}
+		const int* Counts = reinterpret_cast<const int*>(Vectors);
+		const int* Indices = Counts + Header->NumFaces;
+		for (int i = 0; i < Header->NumFaces; i++)
+		{
+			Poly.m_faces[i].m_indices.resize(Counts[i]);
+			for (int k = 0; k < Counts[i]; k++) Poly.m_faces[i].m_indices[k] = *Indices++;
+		}
+
+		// adjacency isn't stored, it's cheap to rebuild from the faces
+		Poly.initializeAdjacency();
+		Hull->setPolyhedralFeatures(Poly);
+	}
+
+	// Followed by the name (NameLength bytes plus a terminator, padded to 8), the brick table and the samples
+	struct CookedSdfHeader
+	{
+		int NameLength;
+		int NumBricks[3];
+		btVector3FloatData Origin;
+		float CellSize;
+		float Band;
+		int NumSamples;
+		int Padding;
+	};
+
+	void WriteSdf(btSerializer* Serializer, const TArray<ANSICHAR>& Name, btSdfCollisionShape* Shape)
+	{
+		const btSdfBrickGrid& Grid = Shape->getBrickGrid();
+		if (!Grid.isValid()) return;
+
+		const int NamePadded = (Name.Num() + 7) & ~7;
+		int Size = sizeof(CookedSdfHeader) + NamePadded + Grid.m_bricks.size() * sizeof(int) + Grid.m_samples.size() * sizeof(short);
+		Size = (Size + 7) & ~7;
+
+		btChunk* Chunk = Serializer->allocate(Size, 1);
+		uint8* Data = static_cast<uint8*>(Chunk->m_oldPtr);
+		FMemory::Memzero(Data, Size);
+
+		CookedSdfHeader* Header = reinterpret_cast<CookedSdfHeader*>(Data);
+		Header->NameLength = Name.Num() - 1;
+		for (int a = 0; a < 3; a++) Header->NumBricks[a] = Grid.m_numBricks[a];
+		Grid.m_origin.serializeFloat(Header->Origin);
+		Header->CellSize = Grid.m_cellSize;
+		Header->Band = Grid.m_band;
+		Header->NumSamples = Grid.m_samples.size();
+
+		uint8* Cursor = Data + sizeof(CookedSdfHeader);
+		FMemory::Memcpy(Cursor, Name.GetData(), Name.Num());
+		Cursor += NamePadded;
+		FMemory::Memcpy(Cursor, &Grid.m_bricks[0], Grid.m_bricks.size() * sizeof(int));
+		Cursor += Grid.m_bricks.size() * sizeof(int);
+		if (Grid.m_samples.size()) FMemory::Memcpy(Cursor, &Grid.m_samples[0], Grid.m_samples.size() * sizeof(short));
+
+		Serializer->finalizeChunk(Chunk, "char", BT_COOKED_SDF_CODE, Shape);
+	}
+
+	btSdfCollisionShape* ReadSdf(const CookedSdfHeader* Header, int32 ChunkLength, FString& OutName)
+	{
+		// the blob comes off disk, check everything that sizes or indexes something before trusting it
+		if (ChunkLength < int32(sizeof(CookedSdfHeader))) return nullptr;
+		if (Header->NameLength < 0 || Header->NumSamples < 0 || Header->NumSamples % btSdfBrickGrid::BRICK_SIZE) return nullptr;
+		if (!(Header->CellSize > 0) || !(Header->Band > 0)) return nullptr;
+		int64 NumBricks64 = 1;
+		for (int a = 0; a < 3; a++)
+		{
+			if (Header->NumBricks[a] <= 0) return nullptr;
+			NumBricks64 *= Header->NumBricks[a];
+		}
+		const int64 NamePadded = (int64(Header->NameLength) + 1 + 7) & ~7;
+		const int64 Needed = sizeof(CookedSdfHeader) + NamePadded + NumBricks64 * sizeof(int) + int64(Header->NumSamples) * sizeof(short);
+		if (Needed > ChunkLength) return nullptr;
+		const int NumBricks = int(NumBricks64);
+
+		const int NumSampleBricks = Header->NumSamples / btSdfBrickGrid::BRICK_SIZE;
+		const int* Bricks = reinterpret_cast<const int*>(reinterpret_cast<const uint8*>(Header + 1) + NamePadded);
+		for (int i = 0; i < NumBricks; i++)
+		{
+			const int Brick = Bricks[i];
+			if (Brick != btSdfBrickGrid::BRICK_OUTSIDE && Brick != btSdfBrickGrid::BRICK_INSIDE && (Brick < 0 || Brick >= NumSampleBricks)) return nullptr;
+		}
+
+		const uint8* Cursor = reinterpret_cast<const uint8*>(Header + 1);
+		OutName = FString(Header->NameLength, reinterpret_cast<const ANSICHAR*>(Cursor));
+		Cursor += NamePadded;
+
+		btSdfCollisionShape* Shape = new btSdfCollisionShape();
+		btSdfBrickGrid& Grid = Shape->getBrickGrid();
+		for (int a = 0; a < 3; a++) Grid.m_numBricks[a] = Header->NumBricks[a];
+		Grid.m_origin.deSerializeFloat(Header->Origin);
+		Grid.m_cellSize = Header->CellSize;
+		Grid.m_band = Header->Band;
+		Grid.m_bricks.resize(NumBricks);
+		FMemory::Memcpy(&Grid.m_bricks[0], Cursor, NumBricks * sizeof(int));
+		Cursor += NumBricks * sizeof(int);
+		Grid.m_samples.resize(Header->NumSamples);
+		if (Header->NumSamples) FMemory::Memcpy(&Grid.m_samples[0], Cursor, Header->NumSamples * sizeof(short));
+		return Shape;
+	}
+
+	// a chunk's header fields, with its payload moved to aligned storage
+	struct LoadedChunk
+	{
+		int Code;
+		int Length;
+		uint8* Data;
+	};
+
+	void CollectHulls(btCollisionShape* Shape, TArray<btConvexHullShape*>& OutHulls)
+	{
+		if (Shape->getShapeType() == CONVEX_HULL_SHAPE_PROXYTYPE)
+		{
+			OutHulls.AddUnique(static_cast<btConvexHullShape*>(Shape));
+		}
+		else if (Shape->isCompound())
+		{
+			btCompoundShape* Compound = static_cast<btCompoundShape*>(Shape);
+			for (int i = 0; i < Compound->getNumChildShapes(); i++)
+			{
+				CollectHulls(Compound->getChildShape(i), OutHulls);
+			}
+		}
+	}
+}
+
+class BulletCookedCollisionImporter : public btCollisionWorldImporter
+{
+public:
+	BulletCookedCollisionImporter(btCollisionWorld* World) : btCollisionWorldImporter(World) {}
+
+	btCollisionShape* FindShapeForData(const void* ShapeData)
+	{
+		btCollisionShape** Shape = m_shapeMap.find(btHashPtr(ShapeData));
+		return Shape ? *Shape : nullptr;
+	}
+};
+
+BulletCollisionCache::BulletCollisionCache()
+{
+}
+
+BulletCollisionCache::~BulletCollisionCache()
+{
+	if (Importer)
+	{
+		Importer->deleteAllData();
+		delete Importer;
+	}
+	for (auto& Pair : SdfShapes) delete Pair.Value;
+}
+
+bool BulletCollisionCache::Write(const FString& Path, const TArray<TPair<FString, btCollisionShape*>>& Shapes)
+{
+	btDefaultSerializer Serializer;
+	Serializer.startSerialization();
+
+	// names have to outlive the serializer, the inner arrays don't move when the outer one grows
+	TArray<TArray<ANSICHAR>> Names;
+	TArray<btConvexHullShape*> Hulls;
+	for (const TPair<FString, btCollisionShape*>& Pair : Shapes)
+	{
+		TArray<ANSICHAR>& Name = Names.AddDefaulted_GetRef();
+		const auto Converted = StringCast<ANSICHAR>(*Pair.Key);
+		Name.Append(Converted.Get(), Converted.Length());
+		Name.Add('\0');
+		Serializer.registerNameForPointer(Pair.Value, Name.GetData());
+		CollectHulls(Pair.Value, Hulls);
+	}
+	for (int32 i = 0; i < Shapes.Num(); i++)
+	{
+		btCollisionShape* Shape = Shapes[i].Value;
+		if (Shape->getShapeType() == SDF_SHAPE_PROXYTYPE)
+		{
+			WriteSdf(&Serializer, Names[i], static_cast<btSdfCollisionShape*>(Shape));
+		}
+		else
+		{
+			Shape->serializeSingleShape(&Serializer);
+		}
+	}
+	for (btConvexHullShape* Hull : Hulls)
+	{
+		WritePolyhedron(&Serializer, Hull);
+	}
+	Serializer.finishSerialization();
+
+	return FFileHelper::SaveArrayToFile(
+		TArrayView64<const uint8>(Serializer.getBufferPointer(), Serializer.getCurrentBufferSize()), *Path);
+}
+
+bool BulletCollisionCache::Load(const FString& Path, btCollisionWorld* World)
+{
+	TArray64<uint8> File;
+	if (!FFileHelper::LoadFileToArray(File, *Path, FILEREAD_Silent) || File.Num() < BT_HEADER_LENGTH)
+	{
+		return false;
+	}
+
+	// Chunks are raw memory images, so only accept blobs from a build with the same precision,
+	// pointer size and endianness (the same checks btDefaultSerializer::writeHeader encodes)
+	const int LittleEndian = 1;
+#ifdef BT_USE_DOUBLE_PRECISION
+	char Expected[9] = { 'B', 'U', 'L', 'L', 'E', 'T', 'd' };
+#else
+	char Expected[9] = { 'B', 'U', 'L', 'L', 'E', 'T', 'f' };
+#endif
+	Expected[7] = sizeof(void*) == 8 ? '-' : '_';
+	Expected[8] = reinterpret_cast<const char*>(&LittleEndian)[0] ? 'v' : 'V';
+	if (FMemory::Memcmp(File.GetData(), Expected, sizeof(Expected)) != 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("BulletCollisionCache: %s was cooked for another platform"), *Path);
+		return false;
+	}
+
+	// Chunks are packed back to back after the 12 byte header and payload lengths are whatever the struct or array
+	// needed (names only pad to 4), so there is no fixed shift that aligns them all. Take each payload's offset from its
+	// chunk header and copy it to 16 byte aligned storage, where the structs can be used in place.
+	struct FileChunk
+	{
+		btChunk Header;
+		int64 Offset;
+	};
+	TArray<FileChunk> FileChunks;
+	int64 PayloadSize = 0;
+	int64 Offset = BT_HEADER_LENGTH;
+	while (Offset + (int64)sizeof(btChunk) <= File.Num())
+	{
+		FileChunk& Chunk = FileChunks.AddDefaulted_GetRef();
+		FMemory::Memcpy(&Chunk.Header, File.GetData() + Offset, sizeof(btChunk));
+		Chunk.Offset = Offset + sizeof(btChunk);
+		if (Chunk.Header.m_length < 0 || Chunk.Offset + Chunk.Header.m_length > File.Num())
+		{
+			UE_LOG(LogTemp, Warning, TEXT("BulletCollisionCache: %s is truncated"), *Path);
+			return false;
+		}
+		// DNA is always written last, and we don't need it since layouts match
+		if (Chunk.Header.m_chunkCode == BT_DNA_CODE)
+		{
+			FileChunks.Pop(EAllowShrinking::No);
+			break;
+		}
+		PayloadSize += Align(Chunk.Header.m_length, 16);
+		Offset = Chunk.Offset + Chunk.Header.m_length;
+	}
+
+	TArray<uint8, TAlignedHeapAllocator<16>> Payloads;
+	Payloads.SetNumUninitialized(PayloadSize);
+	TMap<void*, uint8*> Pointers;
+	TArray<LoadedChunk> Chunks;
+	Chunks.Reserve(FileChunks.Num());
+	uint8* Cursor = Payloads.GetData();
+	for (const FileChunk& Chunk : FileChunks)
+	{
+		FMemory::Memcpy(Cursor, File.GetData() + Chunk.Offset, Chunk.Header.m_length);
+		Pointers.Add(Chunk.Header.m_oldPtr, Cursor);
+		Chunks.Add({ Chunk.Header.m_chunkCode, Chunk.Header.m_length, Cursor });
+		Cursor += Align(Chunk.Header.m_length, 16);
+	}
+
+	auto Fix = [&Pointers](auto*& Ptr)
+	{
+		uint8** Found = Pointers.Find(Ptr);
+		Ptr = Found ? reinterpret_cast<std::remove_reference_t<decltype(Ptr)>>(*Found) : nullptr;
+	};
+	// trees and triangle info can be shared between meshes, their pointers must only be patched once
+	TSet<const void*> Patched;
+	auto FixBvh = [&Fix, &Patched](auto*& Bvh)
+	{
+		Fix(Bvh);
+		if (!Bvh) return;
+		bool bAlreadyPatched = false;
+		Patched.Add(Bvh, &bAlreadyPatched);
+		if (bAlreadyPatched) return;
+		Fix(Bvh->m_contiguousNodesPtr);
+		Fix(Bvh->m_quantizedContiguousNodesPtr);
+		Fix(Bvh->m_subTreeInfoPtr);
+	};
+
+	// Second pass: patch the pointers inside the shape structs we know how to cook. Compounds go last so the
+	// importer has converted their children already and shares them instead of converting them again
+	btBulletSerializedArrays Arrays;
+	TArray<btCollisionShapeData*> Compounds;
+	for (const LoadedChunk& Chunk : Chunks)
+	{
+		if (Chunk.Code != BT_SHAPE_CODE) continue;
+
+		btCollisionShapeData* ShapeData = reinterpret_cast<btCollisionShapeData*>(Chunk.Data);
+		Fix(ShapeData->m_name);
+		switch (ShapeData->m_shapeType)
+		{
+		case BOX_SHAPE_PROXYTYPE:
+		case SPHERE_SHAPE_PROXYTYPE:
+		case CAPSULE_SHAPE_PROXYTYPE:
+		case CYLINDER_SHAPE_PROXYTYPE:
+		case CONE_SHAPE_PROXYTYPE:
+			break;
+		case CONVEX_HULL_SHAPE_PROXYTYPE:
+		{
+			btConvexHullShapeData* Hull = reinterpret_cast<btConvexHullShapeData*>(ShapeData);
+			Fix(Hull->m_unscaledPointsFloatPtr);
+			Fix(Hull->m_unscaledPointsDoublePtr);
+			break;
+		}
+		case TRIANGLE_MESH_SHAPE_PROXYTYPE:
+		{
+			btTriangleMeshShapeData* Mesh = reinterpret_cast<btTriangleMeshShapeData*>(ShapeData);
+			btStridingMeshInterfaceData& Interface = Mesh->m_meshInterface;
+			Fix(Interface.m_meshPartsPtr);
+			if (!Interface.m_meshPartsPtr) Interface.m_numMeshParts = 0;
+			for (int i = 0; i < Interface.m_numMeshParts; i++)
+			{
+				btMeshPartData& Part = Interface.m_meshPartsPtr[i];
+				Fix(Part.m_vertices3f);
+				Fix(Part.m_vertices3d);
+				Fix(Part.m_indices32);
+				Fix(Part.m_3indices16);
+				Fix(Part.m_3indices8);
+				Fix(Part.m_indices16);
+			}
+			FixBvh(Mesh->m_quantizedFloatBvh);
+			FixBvh(Mesh->m_quantizedDoubleBvh);
+			Fix(Mesh->m_triangleInfoMap);
+			bool bAlreadyPatched = false;
+			if (Mesh->m_triangleInfoMap) Patched.Add(Mesh->m_triangleInfoMap, &bAlreadyPatched);
+			if (Mesh->m_triangleInfoMap && !bAlreadyPatched)
+			{
+				Fix(Mesh->m_triangleInfoMap->m_hashTablePtr);
+				Fix(Mesh->m_triangleInfoMap->m_nextPtr);
+				Fix(Mesh->m_triangleInfoMap->m_valueArrayPtr);
+				Fix(Mesh->m_triangleInfoMap->m_keyArrayPtr);
+			}
+			break;
+		}
+		case COMPOUND_SHAPE_PROXYTYPE:
+		{
+			btCompoundShapeData* Compound = reinterpret_cast<btCompoundShapeData*>(ShapeData);
+			Fix(Compound->m_childShapePtr);
+			if (!Compound->m_childShapePtr) Compound->m_numChildShapes = 0;
+			for (int i = 0; i < Compound->m_numChildShapes; i++)
+			{
+				Fix(Compound->m_childShapePtr[i].m_childShape);
+			}
+			Compounds.Add(ShapeData);
+			continue;
+		}
+		default:
+			UE_LOG(LogTemp, Warning, TEXT("BulletCollisionCache: %s contains unsupported shape type %d"), *Path, ShapeData->m_shapeType);
+			return false;
+		}
+		Arrays.m_colShapeData.push_back(ShapeData);
+	}
+	for (btCollisionShapeData* Compound : Compounds)
+	{
+		Arrays.m_colShapeData.push_back(Compound);
+	}
+
+	Importer = new BulletCookedCollisionImporter(World);
+	Importer->convertAllObjects(&Arrays);
+
+	for (const LoadedChunk& Chunk : Chunks)
+	{
+		if (Chunk.Code != BT_COOKED_POLYHEDRON_CODE) continue;
+
+		const CookedPolyhedronHeader* Header = reinterpret_cast<const CookedPolyhedronHeader*>(Chunk.Data);
+		uint8** HullData = Pointers.Find(Header->Hull);
+		btCollisionShape* Hull = HullData ? Importer->FindShapeForData(*HullData) : nullptr;
+		if (Hull && Hull->getShapeType() == CONVEX_HULL_SHAPE_PROXYTYPE)
+		{
+			ReadPolyhedron(Header, static_cast<btConvexHullShape*>(Hull));
+		}
+	}
+
+	for (const LoadedChunk& Chunk : Chunks)
+	{
+		if (Chunk.Code != BT_COOKED_SDF_CODE) continue;
+
+		FString Name;
+		btSdfCollisionShape* Sdf = ReadSdf(reinterpret_cast<const CookedSdfHeader*>(Chunk.Data), Chunk.Length, Name);
+		if (!Sdf)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("BulletCollisionCache: %s has a broken distance field"), *Path);
+			continue;
+		}
+		if (btCollisionShape* Old = SdfShapes.FindRef(Name)) delete Old;
+		SdfShapes.Add(Name, Sdf);
+	}
+
+	// the importer copied everything it needs out of the blob
+	return true;
+}
+
+btCollisionShape* BulletCollisionCache::FindShape(const FString& Name) const
+{
+	if (btCollisionShape* const* Sdf = SdfShapes.Find(Name)) return *Sdf;
+	if (!Importer) return nullptr;
+	return Importer->getCollisionShapeByName(TCHAR_TO_ANSI(*Name));
+}
+
+btCollisionShape* BulletCollisionCache::FindSdfByPrefix(const FString& Prefix) const
+{
+	for (const auto& Pair : SdfShapes)
+	{
+		if (Pair.Key.StartsWith(Prefix)) return Pair.Value;
+	}
+	return nullptr;
+}
+
+FString BulletCollisionCache::GetCookedPath(const UObject* Asset)
+{
+	// body setups are named after their mesh, top level assets (meshes, classes) after themselves,
+	// a package's name is a whole content path
+	const UObject* Named = Asset->GetOuter() && !Asset->GetOuter()->IsA<UPackage>() ? Asset->GetOuter() : Asset;
+	return GetCookedDirectory() / FString::Printf(TEXT("%s_%08x.bullet"), *Named->GetName(), GetTypeHash(Asset->GetPathName()));
+}
+
+FString BulletCollisionCache::GetCookedDirectory()
+{
+	return FPaths::ProjectContentDir() / TEXT("BulletCollision");
+}
@@ -0,0 +1,41 @@
+// Bullet itself, compiled from ThirdParty/BulletPhysicsEngineLibrary/src instead of linked from prebuilt libs.
+// That way the library always matches the headers the plugin sees (BT_THREADSAFE, the SSE path in btScalar.h,
+// our own changes to Bullet) on every platform and config, including the Linux server. Bullet's unity files
+// pull in every Bullet TU we use.
+
+#include "CoreMinimal.h"
+
+// Bullet's sources aren't warning clean (the SSE path adds a few more maybe-uninitialized ones) and UE builds
+// with warnings as errors, so everything in here is treated as third party code
+THIRD_PARTY_INCLUDES_START
+PRAGMA_PUSH_PLATFORM_DEFAULT_PACKING
+#if defined(__clang__)
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Weverything"
+#elif defined(_MSC_VER)
+#pragma warning(push, 0)
+#endif
+// no fused multiply-add, the client and server have to round the same way
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(_MSC_VER)
+#pragma fp_contract(off)
+#endif
+#if PLATFORM_WINDOWS
+#include "Windows/AllowWindowsPlatformTypes.h"
+#endif
+
+#include "btLinearMathAll.cpp"
+#include "btBulletCollisionAll.cpp"
+#include "btBulletDynamicsAll.cpp"
+
+#if PLATFORM_WINDOWS
+#include "Windows/HideWindowsPlatformTypes.h"
+#endif
+#if defined(__clang__)
+#pragma clang diagnostic pop
+#elif defined(_MSC_VER)
+#pragma warning(pop)
+#endif
+PRAGMA_POP_PLATFORM_DEFAULT_PACKING
+THIRD_PARTY_INCLUDES_END
@@ -6,6 +6,7 @@
 #include "Interfaces/IPluginManager.h"
 //#include "BulletPhysicsEngineLibrary/"
 #include "ThirdParty/BulletPhysicsEngineLibrary/BulletMinimal.h"
+#include "BulletTaskScheduler.h"
 
 #define LOCTEXT_NAMESPACE "FBulletPhysicsEngineModule"
 
@@ -13,6 +14,10 @@ void FBulletPhysicsEngineModule::StartupModule()
 {
 	// This code will execute after your module is loaded into memory; the exact timing is specified in the .uplugin file per-module
 
+	// Bullet's parallel loops (islands, batching) run on the task graph. Has to be set from the game thread,
+	// Bullet makes whichever thread sets the scheduler first its main thread.
+	btSetTaskScheduler(BulletTaskScheduler::Get());
+
 	// Get the base directory of this plugin
 	FString BaseDir = IPluginManager::Get().FindPlugin("BulletPhysicsEngine")->GetBaseDir();
 
@@ -44,6 +49,8 @@ void FBulletPhysicsEngineModule::ShutdownModule()
 	// This function may be called during shutdown to clean up your module.  For modules that support dynamic reloading,
 	// we call this function before unloading the module.
 
+	btSetTaskScheduler(nullptr);
+
 	// Free the dll handle
 	FPlatformProcess::FreeDllHandle(ExampleLibraryHandle);
 	ExampleLibraryHandle = nullptr;
@@ -0,0 +1,95 @@
+#include "BulletTaskScheduler.h"
+
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
+#include <atomic>
+
+BulletTaskScheduler::BulletTaskScheduler()
+	: btITaskScheduler("UE Task Graph")
+{
+	NumThreads = getMaxNumThreads();
+}
+
+BulletTaskScheduler* BulletTaskScheduler::Get()
+{
+	static BulletTaskScheduler Scheduler;
+	return &Scheduler;
+}
+
+int BulletTaskScheduler::getMaxNumThreads() const
+{
+	// workers plus the thread that starts the loop. Bullet hands out thread indices below BT_MAX_THREAD_COUNT,
+	// the solver pool only uses them to pick a free solver so a worker past that just has to look a bit longer
+	const int Workers = FTaskGraphInterface::IsRunning() ? FTaskGraphInterface::Get().GetNumWorkerThreads() : 0;
+	return FMath::Clamp(Workers + 1, 1, (int)BT_MAX_THREAD_COUNT);
+}
+
+int BulletTaskScheduler::getNumThreads() const
+{
+	return NumThreads;
+}
+
+void BulletTaskScheduler::setNumThreads(int numThreads)
+{
+	NumThreads = FMath::Clamp(numThreads, 1, getMaxNumThreads());
+}
+
+void BulletTaskScheduler::parallelFor(int iBegin, int iEnd, int grainSize, const btIParallelForBody& body)
+{
+	const int Grain = FMath::Max(grainSize, 1);
+	const int NumChunks = (iEnd - iBegin + Grain - 1) / Grain;
+	const int NumTasks = FMath::Min(NumChunks, NumThreads);
+	if (NumTasks <= 1)
+	{
+		if (iEnd > iBegin) body.forLoop(iBegin, iEnd);
+		return;
+	}
+
+	// chunks are claimed in order, whichever task is free takes the next one
+	std::atomic<int> NextChunk(0);
+	btPushThreadsAreRunning();
+	ParallelFor(NumTasks, [&](int32)
+	{
+		for (int Chunk = NextChunk++; Chunk < NumChunks; Chunk = NextChunk++)
+		{
+			const int First = iBegin + Chunk * Grain;
+			body.forLoop(First, FMath::Min(First + Grain, iEnd));
+		}
+	}, EParallelForFlags::Unbalanced);
+	btPopThreadsAreRunning();
+}
+
+btScalar BulletTaskScheduler::parallelSum(int iBegin, int iEnd, int grainSize, const btIParallelSumBody& body)
+{
+	const int Grain = FMath::Max(grainSize, 1);
+	const int NumChunks = (iEnd - iBegin + Grain - 1) / Grain;
+	if (NumChunks <= 0) return 0;
+
+	// always sum per chunk, even on one thread, so the rounding is the same whatever the thread count
+	TArray<btScalar, TInlineAllocator<64>> ChunkSums;
+	ChunkSums.SetNumZeroed(NumChunks);
+	const int NumTasks = FMath::Min(NumChunks, NumThreads);
+	std::atomic<int> NextChunk(0);
+	auto SumChunks = [&](int32)
+	{
+		for (int Chunk = NextChunk++; Chunk < NumChunks; Chunk = NextChunk++)
+		{
+			const int First = iBegin + Chunk * Grain;
+			ChunkSums[Chunk] = body.sumLoop(First, FMath::Min(First + Grain, iEnd));
+		}
+	};
+	if (NumTasks <= 1)
+	{
+		SumChunks(0);
+	}
+	else
+	{
+		btPushThreadsAreRunning();
+		ParallelFor(NumTasks, SumChunks, EParallelForFlags::Unbalanced);
+		btPopThreadsAreRunning();
+	}
+
+	btScalar Sum = 0;
+	for (btScalar ChunkSum : ChunkSums) Sum += ChunkSum;
+	return Sum;
+}
@@ -6,9 +6,54 @@
 #include "BasicPhysicsEntity.h"
 #include "BasicPhysicsPawn.h"
 #include "Projects.h"
-#include "TWPlayerController.h"
+#include "GameFramework/PlayerState.h"
 #include "LevelInstance/LevelInstanceTypes.h"
 #include "Types/AttributeStorage.h"
+#include "Async/Async.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/FileManager.h"
+#include "Misc/Crc.h"
+#include "StaticMeshResources.h"
+#include "BulletTaskScheduler.h"
+
+// Bullet's SIMD types are 16-byte aligned on every platform we ship (Windows client, Linux server),
+// our own structs and containers holding them have to keep that
+static_assert(alignof(btVector3) == 16, "btVector3 must be 16-byte aligned");
+static_assert(alignof(btTransform) == 16, "btTransform must be 16-byte aligned");
+static_assert(alignof(btManifoldPoint) == 16, "contact snapshots copy btManifoldPoint into a TArray");
+static_assert(alignof(ATestActor::ProcMeshCollider) >= 16 && alignof(ATestActor::StaticChunkEntry) >= 16 && alignof(ATestActor::CachedDynamicShapeData) >= 16, "structs holding Bullet math lost their alignment");
+static_assert(__STDCPP_DEFAULT_NEW_ALIGNMENT__ >= 16, "plain new must hand out 16-byte aligned memory for the collider structs");
+
+static FAutoConsoleCommand DeterminismProbeCommand(
+	TEXT("bullet.DeterminismProbe"),
+	TEXT("Runs a fixed Bullet scene and logs a hash of the result. Compare it between the client and server builds. Args: steps, wide solver (1 = wide, 0 = row solver)."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		ATestActor::RunDeterminismProbe(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 600, Args.Num() > 1 ? FCString::Atoi(*Args[1]) != 0 : true);
+	}));
+
+static FAutoConsoleCommand BroadphaseBenchmarkCommand(
+	TEXT("bullet.BroadphaseBenchmark"),
+	TEXT("Times every broadphase on synthetic projectile, fleet and static field scenes and logs ms per step. Args: steps."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		ATestActor::RunBroadphaseBenchmark(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 300);
+	}));
+
+// Layers first, then the ignore lists that IgnoreActorCollision fills in. Also used by the projectile sweeps,
+// which ask the pair cache before testing a candidate.
+class BulletLayerFilter : public btOverlapFilterCallback
+{
+public:
+	virtual bool needBroadphaseCollision(btBroadphaseProxy* Proxy0, btBroadphaseProxy* Proxy1) const override
+	{
+		if (!(Proxy0->m_collisionFilterGroup & Proxy1->m_collisionFilterMask) || !(Proxy1->m_collisionFilterGroup & Proxy0->m_collisionFilterMask))
+			return false;
+		const btCollisionObject* Obj0 = static_cast<const btCollisionObject*>(Proxy0->m_clientObject);
+		const btCollisionObject* Obj1 = static_cast<const btCollisionObject*>(Proxy1->m_clientObject);
+		return Obj0->checkCollideWith(Obj1) && Obj1->checkCollideWith(Obj0);
+	}
+};
 
 // Sets default values
 ATestActor::ATestActor()
@@ -26,24 +71,233 @@ void ATestActor::BeginPlay()
 {
 	Super::BeginPlay();
 
-	BtCollisionConfig = new btDefaultCollisionConfiguration();
+	btDefaultCollisionConstructionInfo CollisionInfo;
+	CollisionInfo.m_defaultMaxPersistentManifoldPoolSize = FMath::Max(ManifoldPoolSize, 16);
+	CollisionInfo.m_defaultMaxCollisionAlgorithmPoolSize = FMath::Max(CollisionAlgorithmPoolSize, 16);
+	CollisionInfo.m_persistentManifoldPoolGrowSize = CollisionInfo.m_defaultMaxPersistentManifoldPoolSize / 4;
+	CollisionInfo.m_collisionAlgorithmPoolGrowSize = CollisionInfo.m_defaultMaxCollisionAlgorithmPoolSize / 4;
+	BtCollisionConfig = new btDefaultCollisionConfiguration(CollisionInfo);
 	BtCollisionDispatcher = new btCollisionDispatcher(BtCollisionConfig);
-	BtBroadphase = new btDbvtBroadphase();
-	mt = new btSequentialImpulseConstraintSolver;
-	mt->setRandSeed(1234);
-	BtConstraintSolver = mt;
-	BtWorld = new btDiscreteDynamicsWorld(BtCollisionDispatcher, BtBroadphase, BtConstraintSolver, BtCollisionConfig);
+	BtBroadphase = CreateBroadphase(BroadphaseType, BroadphaseHalfExtent, bParallelPairFinding);
+	BuildLayerMasks();
+	BtOverlapFilter = new BulletLayerFilter();
+	BtBroadphase->getOverlappingPairCache()->setOverlapFilterCallback(BtOverlapFilter);
+	if (bParallelIslands)
+	{
+		// one solver per thread, a thread grabs whichever one is free. Islands don't share bodies,
+		// so which thread or solver gets an island doesn't matter for the result.
+		TArray<btConstraintSolver*> Solvers;
+		for (int i = 0; i < BulletTaskScheduler::Get()->getNumThreads(); i++)
+		{
+			BtSolvers.Add(CreateSolver());
+			Solvers.Add(BtSolvers.Last());
+		}
+		btConstraintSolverPoolMt* Pool = new btConstraintSolverPoolMt(Solvers.GetData(), Solvers.Num());
+		BtConstraintSolver = Pool;
+		BtWorld = new btDiscreteDynamicsWorldMt(BtCollisionDispatcher, BtBroadphase, Pool, nullptr, BtCollisionConfig);
+	}
+	else
+	{
+		BtSolvers.Add(CreateSolver());
+		BtConstraintSolver = BtSolvers[0];
+		BtWorld = new btDiscreteDynamicsWorld(BtCollisionDispatcher, BtBroadphase, BtConstraintSolver, BtCollisionConfig);
+	}
+	mt = BtSolvers[0];
 	BtWorld->setGravity(btVector3(0, 0, 0));
+	// Bullet keeps the sleep delay in a global, the thresholds are set per body in AddRigidBody
+	gDeactivationTime = SleepDelay;
+	// Only awake bodies get their boxes recomputed, and only the ones that changed reach the broadphase. Static
+	// colliders stay in the dbvt's fixed tree; code that moves one has to call updateSingleAabb (UpdateProcBody does).
+	BtWorld->setForceUpdateAllAabbs(false);
+	BtWorld->getDispatchInfo().m_enableSatConvex = bHullSatContacts;
+	BtWorld->setWorldUserInfo(this);
+	BtWorld->setProjectileHitCallback(&ATestActor::RecordProjectileHit);
+	ContactEventBatch.Reserve(ContactEventCapacity);
+	ProjectileHitBatch.Reserve(ContactEventCapacity);
+	ContactPairs.Reserve(ContactEventCapacity);
+	PreviousContactPairs.Reserve(ContactEventCapacity);
+	ConfigureSolver(BtWorld->getSolverInfo(), SolverIterations, SolverResidualThreshold);
+	if (bParallelIslands)
+	{
+		// the Mt island manager copied the batch size when it was built, and batches tiny islands by body count instead
+		btSimulationIslandManagerMt* IslandManager = static_cast<btSimulationIslandManagerMt*>(BtWorld->getSimulationIslandManager());
+		IslandManager->setMinimumSolverBatchSize(BtWorld->getSolverInfo().m_minimumSolverBatchSize);
+		IslandManager->setBatchIslandMinBodyCount(FMath::Max(IslandBatchMinBodies, 1));
+	}
 	
 	// Gravity vector in our units (1=1cm)
 	//getSimulationIslandManager()->setSplitIslands(false);
 }
 
+void ATestActor::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	Super::EndPlay(EndPlayReason);
+
+	if (!BtWorld) return;
+
+	// The world owns nothing, so tear it down in reverse order of construction
+	FlushPendingDestroys();
+	for (btRigidBody* Body : BtRigidBodies)
+	{
+		BtWorld->removeRigidBody(Body);
+		delete Body->getMotionState();
+		delete Body;
+	}
+	BtRigidBodies.Empty();
+	BodiesById.Empty();
+	FreeBodyIds.Empty();
+	for (auto& Pair : ProcBodies) DestroyProcMeshCollider(Pair.Value);
+	ProcBodies.Empty();
+	for (auto& Pair : HeightfieldBodies) DestroyHeightfieldCollider(Pair.Value);
+	HeightfieldBodies.Empty();
+	BodyToActor.Empty();
+	ActorToBody.Empty();
+
+	for (btCollisionObject* Obj : BtStaticObjects)
+	{
+		BtWorld->removeCollisionObject(Obj);
+		delete Obj;
+	}
+	BtStaticObjects.Empty();
+	DestroyStaticChunks();
+
+	// Shapes are shared between bodies, free them only once the bodies are gone
+	for (const CachedDynamicShapeData& Data : CachedDynamicShapes)
+	{
+		if (Data.bIsCompound && !Data.bCooked) delete Data.Shape;
+	}
+	CachedDynamicShapes.Empty();
+	for (btBoxShape* S : BtBoxCollisionShapes) delete S;
+	BtBoxCollisionShapes.Empty();
+	for (btSphereShape* S : BtSphereCollisionShapes) delete S;
+	BtSphereCollisionShapes.Empty();
+	for (btCapsuleShape* S : BtCapsuleCollisionShapes) delete S;
+	BtCapsuleCollisionShapes.Empty();
+	for (const ConvexHullShapeHolder& H : BtConvexHullCollisionShapes)
+	{
+		if (!H.bCooked) delete H.Shape;
+	}
+	BtConvexHullCollisionShapes.Empty();
+	for (const SdfShapeHolder& H : BtSdfCollisionShapes)
+	{
+		if (!H.bCooked) delete H.Shape;
+	}
+	BtSdfCollisionShapes.Empty();
+	for (auto& Pair : CookedCollision) delete Pair.Value;
+	CookedCollision.Empty();
+
+	for (auto& Pair : InputBuffers) delete Pair.Value;
+	InputBuffers.Empty();
+
+	UpdatePoolStats();
+	if (PoolStats.ManifoldOverflows > 0 || PoolStats.AlgorithmOverflows > 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Bullet pools grew at runtime (manifolds %d times, algorithms %d times). Peaks were %d manifolds and %d algorithms, raise ManifoldPoolSize/CollisionAlgorithmPoolSize to match."),
+			PoolStats.ManifoldOverflows, PoolStats.AlgorithmOverflows, PoolStats.PeakManifolds, PoolStats.PeakAlgorithms);
+	}
+
+	delete BtWorld;
+	BtWorld = nullptr;
+	delete BtConstraintSolver;
+	BtConstraintSolver = nullptr;
+	BtSolvers.Empty();
+	mt = nullptr;
+	delete BtBroadphase;
+	BtBroadphase = nullptr;
+	delete BtOverlapFilter;
+	BtOverlapFilter = nullptr;
+	delete BtCollisionDispatcher;
+	BtCollisionDispatcher = nullptr;
+	delete BtCollisionConfig;
+	BtCollisionConfig = nullptr;
+}
+
+void ATestActor::DestroyRigidBody(btRigidBody* rigidbody)
+{
+	AActor** Actor = BodyToActor.Find(rigidbody);
+	if (!Actor) return; // unknown or already destroyed
+
+	ActorToBody.Remove(*Actor);
+	BodyToActor.Remove(rigidbody);
+	InterpolationErrors.Remove(*Actor);
+	bHasInterpolationError.Remove(*Actor);
+	InterpDeltas.Remove(*Actor);
+	InputSlack.Remove(*Actor);
+	if (TWRingBuffer<FTWPlayerInput>** Buffer = InputBuffers.Find(*Actor))
+	{
+		delete *Buffer;
+		InputBuffers.Remove(*Actor);
+	}
+
+	ForgetContactPairs(rigidbody);
+	// bodies set to ignore this one by IgnoreActorCollision would keep its pointer, and skip whatever gets allocated there next
+	for (btRigidBody* Other : BtRigidBodies)
+	{
+		if (Other != rigidbody && Other->getNumObjectsWithoutCollision() > 0) Other->setIgnoreCollisionCheck(rigidbody, false);
+	}
+
+	// leaves the state snapshots right away, the slot itself is only freed with the body
+	rigidbody->setUserPointer(nullptr);
+	PendingDestroyBodies.AddUnique(rigidbody);
+}
+
+void ATestActor::FlushPendingDestroys()
+{
+	for (btRigidBody* Body : PendingDestroyBodies)
+	{
+		// swap-remove from the dense array and patch the moved body's slot
+		const int32 Index = Body->getUserIndex();
+		if (BtRigidBodies.IsValidIndex(Index) && BtRigidBodies[Index] == Body)
+		{
+			BtRigidBodies.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+			if (BtRigidBodies.IsValidIndex(Index))
+			{
+				BtRigidBodies[Index]->setUserIndex(Index);
+			}
+		}
+		// the Blueprint ID stays put for every other body, this one is handed out again later
+		const int32 Id = Body->getUserIndex3();
+		if (BodiesById.IsValidIndex(Id) && BodiesById[Id] == Body)
+		{
+			BodiesById[Id] = nullptr;
+			FreeBodyIds.Push(Id);
+		}
+
+		if (BtWorld) BtWorld->removeRigidBody(Body);
+		delete Body->getMotionState();
+		delete Body;
+	}
+	PendingDestroyBodies.Reset();
+}
+
 // Called every frame
 void ATestActor::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
 	// Physics networking logic is now in async physics tick
+	DeliverPhysicsEvents();
+}
+
+// the input a client sent for this tick, or its newest earlier one when that is late or lost
+static bool FindInputForTick(const TWRingBuffer<FTWPlayerInput>& Buffer, int32 Tick, FTWPlayerInput& Out)
+{
+	bool bFound = false;
+	for (int32 i = 0; i < Buffer.GetSize(); i++)
+	{
+		const FTWPlayerInput Input = Buffer.Get(i);
+		if (Input.Tick == Tick)
+		{
+			Out = Input;
+			return true;
+		}
+		// unreliable, so not necessarily in order
+		if (Input.Tick < Tick && (!bFound || Input.Tick > Out.Tick))
+		{
+			Out = Input;
+			bFound = true;
+		}
+	}
+	return bFound;
 }
 
 void ATestActor::AsyncPhysicsTickActor(float DeltaTime, float SimTime)
@@ -55,26 +309,61 @@ void ATestActor::AsyncPhysicsTickActor(float DeltaTime, float SimTime)
 	// {
 	// 	ApplyLocalPlayerErrorCorrection(DeltaTime);
 	// }
-	StepPhysics(DeltaTime, 1);
-	randvar = mt->getRandSeed();
-	LocalState = GetCurrentState();
 	if (HasAuthority())
 	{
-		// consume input
-		for (auto& Pair : InputBuffers)
+		// the server's ticks are the clock everyone else follows
+		SimulateTick();
+		return;
+	}
+
+	// clients run their fixed steps a little faster or slower than the physics tick to hold their lead over the server,
+	// now and then that's two steps or none in one physics tick
+	TickBudget += DeltaTime / FixedDeltaTime * TickRate;
+	for (int32 Steps = 0; TickBudget >= 1.0 && Steps < 2; Steps++)
+	{
+		TickBudget -= 1.0;
+		SimulateTick();
+	}
+	TickBudget = FMath::Min(TickBudget, 1.5);
+}
+
+void ATestActor::SimulateTick()
+{
+	if (bStreamStaticGeometry)
+	{
+		if (ticker % FMath::Max(StaticChunkUpdateInterval, 1) == 0) UpdateStaticChunkStreaming();
+		SwapInBuiltStaticChunks();
+	}
+
+	// inputs go in before the step that uses them, the same order Resim replays them in
+	if (LocalPawn && LocalPawn->IsLocallyControlled())
+	{
+		LocalPawn->ProduceInput(ticker);
+	}
+	if (HasAuthority())
+	{
+		for (const auto& Pair : InputBuffers)
 		{
-			AActor* Actor = Pair.Key;
-			auto InputBuf = *Pair.Value;
-			if (!InputBuf.IsEmpty())
+			FTWPlayerInput Input;
+			ABasicPhysicsPawn* Pawn = Cast<ABasicPhysicsPawn>(Pair.Key);
+			if (Pawn && FindInputForTick(*Pair.Value, ticker, Input))
 			{
-				auto pawn = Cast<ABasicPhysicsPawn>(Actor);
-				pawn->ApplyInputs(InputBuf.Get(0));
+				Pawn->ApplyInputsAndWake(Input);
 			}
 		}
-		
+	}
+
+	StepPhysics(FixedDeltaTime, 1);
+	PublishPhysicsEvents();
+	randvar = mt->getRandSeed();
+	ticker += 1;
+
+	if (HasAuthority())
+	{
 		// send state
 		TArray<AActor*> InputActorArray;
 		TArray<FTWPlayerInput> InputArray;
+		TArray<int32> SlackArray;
 
 		// Loop through each actor and get their most recent input
 		for (const auto& Pair : InputBuffers)
@@ -93,13 +382,22 @@ void ATestActor::AsyncPhysicsTickActor(float DeltaTime, float SimTime)
 			{
 				InputArray.Add(FTWPlayerInput()); // Add default input
 			}
+
+			// MAX_int32 when nothing arrived since the last snapshot
+			int32* Slack = InputSlack.Find(Actor);
+			SlackArray.Add(Slack ? *Slack : MAX_int32);
+			if (Slack) *Slack = MAX_int32;
 		}
 
 
+		// converted into the same arrays every tick, so this doesn't allocate once the body count has settled
+		CaptureState(ServerSnapshot);
+		ToUEState(ServerSnapshot, LocalState);
+
 		// TODO: investigate filtering LocalState by proximity/look direction/etc to client to save bandwidth
 		// TODO: Don't send inputs of actors/pawns not being controlled
 		// if (tock) {
-			MC_SendStateToClients(LocalState, InputActorArray, InputArray);
+			MC_SendStateToClients(LocalState, InputActorArray, InputArray, SlackArray);
 		// 	tock = false;
 		// } else {
 		// 	tock = true;
@@ -107,9 +405,50 @@ void ATestActor::AsyncPhysicsTickActor(float DeltaTime, float SimTime)
 		
 	} else // if client
 	{
-		StateHistory.Push(LocalState);
+		CaptureState(StateHistory.PushInPlace());
+		ContactSnapshot& Contacts = ContactHistory.PushInPlace();
+		Contacts.Tick = ticker;
+		SaveContacts(Contacts);
 	}
-	ticker += 1;
+}
+
+void ATestActor::SyncTicks(int32 ServerTick, int32 Slack)
+{
+	if (!bTicksSynced)
+	{
+		// first snapshot: get ahead by a round trip plus the lead, the slack reports take it from there
+		float RttTicks = 0;
+		APlayerController* PC = GetWorld()->GetFirstPlayerController();
+		if (PC && PC->PlayerState)
+		{
+			RttTicks = PC->PlayerState->GetPingInMilliseconds() * 0.001f / FixedDeltaTime;
+		}
+		ticker = ServerTick + FMath::CeilToInt(RttTicks) + TargetInputLead;
+		IgnoreSlackBeforeTick = ticker;
+		bTicksSynced = true;
+		return;
+	}
+
+	// the server reports on inputs it received a round trip ago
+	if (Slack == MAX_int32 || ServerTick < IgnoreSlackBeforeTick)
+	{
+		return;
+	}
+
+	const int32 LeadError = Slack - TargetInputLead;
+	if (FMath::Abs(LeadError) > TickSnapThreshold)
+	{
+		// too far off to drift back in reasonable time, e.g. after a hitch
+		ticker -= LeadError;
+		IgnoreSlackBeforeTick = ticker;
+		SmoothedLeadError = 0;
+		TickRate = 1.f;
+		return;
+	}
+
+	// slack jitters with the network, steer on its average. Inputs arriving too early mean the client is too far ahead
+	SmoothedLeadError = FMath::Lerp(SmoothedLeadError, (float)LeadError, 0.1f);
+	TickRate = 1.f - FMath::Clamp(SmoothedLeadError * TickRateGain, -MaxTickRateAdjust, MaxTickRateAdjust);
 }
 
 
@@ -125,6 +464,10 @@ void ATestActor::SendInputToServer(AActor* actor, FTWPlayerInput input)
     
 	// Access the pointer and use -> to call Push
 	InputBuffers[actor]->Push(input);
+
+	// how many ticks before it's needed this arrived, reported back with the next snapshot
+	int32& Slack = InputSlack.FindOrAdd(actor, MAX_int32);
+	Slack = FMath::Min(Slack, input.Tick - ticker);
 }
 
 void ATestActor::shootThing_Implementation(TSubclassOf<ABasicPhysicsEntity> projectileClass, FRotator direction,
@@ -141,20 +484,16 @@ void ATestActor::shootThing_Implementation(TSubclassOf<ABasicPhysicsEntity> proj
 	// automatically via AddRigidBodyAndReturn
 }
 
-void ATestActor::Resim(FBulletSimulationState ServerState)
+void ATestActor::Resim(const FBulletSimulationState& ServerState)
 {
-	APlayerController* PC = GetWorld()->GetFirstPlayerController();
-	ATWPlayerController* TWPC = Cast<ATWPlayerController>(PC); 
-	if (!TWPC)
+	// the ticks we simulated past the server's state get redone on top of it
+	int framesToRewind = ticker - ServerState.Tick;
+	if (framesToRewind < 0)
 	{
-		return;
+		// the server got ahead of us (e.g. right after a jump), take its state as ours
+		ticker = ServerState.Tick;
+		framesToRewind = 0;
 	}
-
-	// Use synchronized time instead of RTT/2
-	double currentServerTime = TWPC->GetServerTime();
-	double serverStateTime = ServerState.CurrentTime;
-	double timeDifference = currentServerTime - serverStateTime;
-	int framesToRewind = FMath::RoundToInt(timeDifference / FixedDeltaTime);
         
 	// Store current predicted states before correction
 	TMap<AActor*, FBulletObjectState> PredictedStates;
@@ -169,7 +508,7 @@ void ATestActor::Resim(FBulletSimulationState ServerState)
 		AActor* actor = pair.Key;
 		btRigidBody* body = pair.Value;
            
-		FBulletObjectState* SState = ServerState.ObjectStates.FindByPredicate([actor](const FBulletObjectState& state) 
+		const FBulletObjectState* SState = ServerState.ObjectStates.FindByPredicate([actor](const FBulletObjectState& state) 
 		{ 
 			return state.Actor == actor; 
 		});
@@ -179,14 +518,34 @@ void ATestActor::Resim(FBulletSimulationState ServerState)
 			SetBodyState(body, *SState);
 		}
 	}
+
+	// The manifolds still hold the impulses of the newest frame. Put back the contacts we had at the end of the
+	// frame we rewound to, so the resim warm starts the same way the original frames did.
+	if (const ContactSnapshot* Rewound = FindContactsForTick(ServerState.Tick))
+	{
+		RestoreContacts(*Rewound);
+	}
         
-	// Resimulate forward to get corrected prediction
+	// Resimulate forward to get corrected prediction. These frames were stepped before, so the broadphase can skip
+	// rebalancing its trees where that doesn't change the pairs it hands on
+	BtBroadphase->beginReplay();
 	for (int i = 0; i < framesToRewind; i++)
 	{
-		FTWPlayerInput PastInput = LocalInputBuffer.Get(framesToRewind-i);
-		if (LocalPawn) LocalPawn->ApplyInputs(PastInput);
+		// by tick, not by position. After SyncTicks snaps back, ticks get produced (and sent) a second time and the
+		// buffer holds both, newest first. Same lookup the server does, so a missing tick falls back the same way
+		FTWPlayerInput PastInput;
+		if (LocalPawn && FindInputForTick(LocalInputBuffer, ServerState.Tick + i, PastInput))
+		{
+			LocalPawn->ApplyInputsAndWake(PastInput);
+		}
 		StepPhysics(FixedDeltaTime, 1);
+		// the next rollback into this frame should start from the corrected contacts
+		if (ContactSnapshot* Contacts = FindContactsForTick(ServerState.Tick + i + 1))
+		{
+			SaveContacts(*Contacts);
+		}
 	}
+	BtBroadphase->endReplay(BtCollisionDispatcher);
         
 	// Now smooth between old prediction and corrected prediction
 	for (const auto& pair : ActorToBody)
@@ -208,10 +567,145 @@ void ATestActor::Resim(FBulletSimulationState ServerState)
 }
 
 
-void ATestActor::MC_SendStateToClients_Implementation(FBulletSimulationState ServerState, const TArray<AActor*>& InputActors, const TArray<FTWPlayerInput>& PlayerInputs)
+void ATestActor::CaptureState(StateSnapshot& Snapshot) const
+{
+	Snapshot.Tick = ticker;
+	// one pass over the dense body array, each body is read once and written to consecutive slots
+	const int32 NumBodies = BtRigidBodies.Num();
+	Snapshot.Bodies.SetNumUninitialized(NumBodies, EAllowShrinking::No);
+	BodySnapshot* Out = Snapshot.Bodies.GetData();
+	for (int32 i = 0; i < NumBodies; i++)
+	{
+		const btRigidBody* Body = BtRigidBodies[i];
+		Out[i].Transform = Body->getWorldTransform();
+		Out[i].LinearVelocity = Body->getLinearVelocity();
+		Out[i].AngularVelocity = Body->getAngularVelocity();
+		Out[i].DeactivationTime = Body->getDeactivationTime();
+		Out[i].ActivationState = Body->getActivationState();
+		Out[i].Body = BtRigidBodies[i];
+		Out[i].Actor = static_cast<AActor*>(Body->getUserPointer());
+	}
+}
+
+void ATestActor::ToUEState(const StateSnapshot& Snapshot, FBulletSimulationState& State)
+{
+	State.Tick = Snapshot.Tick;
+	// overwrite the existing entries in place, the array only grows when the body count does
+	State.ObjectStates.SetNum(Snapshot.Bodies.Num(), EAllowShrinking::No);
+	const VectorRegister4Double Origin = VectorZeroDouble();
+	int32 NumStates = 0;
+	for (const BodySnapshot& Body : Snapshot.Bodies)
+	{
+		if (!Body.Actor) continue;
+
+		FBulletObjectState& ObjectState = State.ObjectStates[NumStates++];
+		ObjectState.Actor = Body.Actor;
+		ObjectState.Transform = FTransform(BulletHelpers::ToUE(Body.Transform.getRotation()), BulletHelpers::ToUEPosVectorized(Body.Transform.getOrigin(), Origin));
+		ObjectState.Velocity = BulletHelpers::ToUEDirVectorized(Body.LinearVelocity);
+		ObjectState.AngularVelocity = BulletHelpers::ToUEDirVectorized(Body.AngularVelocity);
+		ObjectState.ActivationState = Body.ActivationState;
+		ObjectState.DeactivationTime = Body.DeactivationTime;
+	}
+	State.ObjectStates.SetNum(NumStates, EAllowShrinking::No);
+}
+
+FBulletSimulationState ATestActor::GetCurrentState()
+{
+	StateSnapshot Snapshot;
+	CaptureState(Snapshot);
+	FBulletSimulationState State;
+	ToUEState(Snapshot, State);
+	return State;
+}
+
+// The compound algorithms keep one manifold per child (pair), so the body pair alone doesn't say which one it is.
+// Every point of such a manifold carries the child index on the compound's side, the other side's index can be a
+// triangle that changes from point to point. An empty manifold of a compound can't tell, it returns false.
+static bool GetManifoldChildren(const btPersistentManifold* Manifold, int32& Child0, int32& Child1)
+{
+	const bool bCompound0 = Manifold->getBody0()->getCollisionShape()->isCompound();
+	const bool bCompound1 = Manifold->getBody1()->getCollisionShape()->isCompound();
+	if ((bCompound0 || bCompound1) && Manifold->getNumContacts() == 0) return false;
+	Child0 = bCompound0 ? Manifold->getContactPoint(0).m_index0 : -1;
+	Child1 = bCompound1 ? Manifold->getContactPoint(0).m_index1 : -1;
+	return true;
+}
+
+void ATestActor::SaveContacts(ContactSnapshot& Snapshot) const
+{
+	btDispatcher* Dispatcher = BtWorld->getDispatcher();
+	const int NumManifolds = Dispatcher->getNumManifolds();
+	Snapshot.Manifolds.Reset(NumManifolds);
+	Snapshot.Points.Reset(NumManifolds * 2);
+	for (int i = 0; i < NumManifolds; i++)
+	{
+		const btPersistentManifold* Manifold = Dispatcher->getManifoldByIndexInternal(i);
+		if (Manifold->getNumContacts() == 0) continue;
+
+		ContactSnapshot::Manifold& Entry = Snapshot.Manifolds.AddDefaulted_GetRef();
+		Entry.Body0 = Manifold->getBody0();
+		Entry.Body1 = Manifold->getBody1();
+		GetManifoldChildren(Manifold, Entry.Child0, Entry.Child1);
+		Entry.FirstPoint = Snapshot.Points.Num();
+		Entry.NumPoints = Manifold->getNumContacts();
+		for (int p = 0; p < Entry.NumPoints; p++)
+		{
+			btManifoldPoint& Point = Snapshot.Points.Add_GetRef(Manifold->getContactPoint(p));
+			// owned by the live manifold, the copy must not free it again
+			Point.m_userPersistentData = nullptr;
+		}
+	}
+}
+
+ATestActor::ContactSnapshot* ATestActor::FindContactsForTick(int32 Tick)
+{
+	for (int32 i = 0; i < ContactHistory.GetSize(); i++)
+	{
+		ContactSnapshot* Snapshot = ContactHistory.GetSlot(i);
+		if (Snapshot && Snapshot->Tick == Tick) return Snapshot;
+	}
+	return nullptr;
+}
+
+void ATestActor::RestoreContacts(const ContactSnapshot& Snapshot)
+{
+	typedef TTuple<const btCollisionObject*, const btCollisionObject*, int32, int32> FManifoldKey;
+	TMap<FManifoldKey, int32> ManifoldByKey;
+	ManifoldByKey.Reserve(Snapshot.Manifolds.Num());
+	for (int32 i = 0; i < Snapshot.Manifolds.Num(); i++)
+	{
+		const ContactSnapshot::Manifold& Entry = Snapshot.Manifolds[i];
+		ManifoldByKey.Add(FManifoldKey(Entry.Body0, Entry.Body1, Entry.Child0, Entry.Child1), i);
+	}
+
+	// Only manifolds that still exist can be refilled, they belong to the pair's collision algorithm.
+	// A pair that only touched back then starts cold, a pair that wasn't touching back then starts empty,
+	// and so does a compound child whose manifold is empty now (nothing says which child it is).
+	// The narrowphase refreshes the restored points against the rewound transforms on the next step.
+	btDispatcher* Dispatcher = BtWorld->getDispatcher();
+	for (int i = 0; i < Dispatcher->getNumManifolds(); i++)
+	{
+		btPersistentManifold* Manifold = Dispatcher->getManifoldByIndexInternal(i);
+		int32 Child0, Child1;
+		const bool bKnown = GetManifoldChildren(Manifold, Child0, Child1);
+		Manifold->clearManifold();
+		const int32* Index = bKnown ? ManifoldByKey.Find(FManifoldKey(Manifold->getBody0(), Manifold->getBody1(), Child0, Child1)) : nullptr;
+		if (!Index) continue;
+
+		const ContactSnapshot::Manifold& Entry = Snapshot.Manifolds[*Index];
+		for (int32 p = 0; p < Entry.NumPoints; p++)
+		{
+			Manifold->addManifoldPoint(Snapshot.Points[Entry.FirstPoint + p]);
+		}
+	}
+}
+
+void ATestActor::MC_SendStateToClients_Implementation(const FBulletSimulationState& ServerState, const TArray<AActor*>& InputActors, const TArray<FTWPlayerInput>& PlayerInputs, const TArray<int32>& InputSlacks)
 {
     if (!HasAuthority() ) // TODO remove this testing
     {
+	    const int32 Index = LocalPawn ? InputActors.IndexOfByKey(LocalPawn) : INDEX_NONE;
+	    SyncTicks(ServerState.Tick, InputSlacks.IsValidIndex(Index) ? InputSlacks[Index] : MAX_int32);
 	    Resim(ServerState);
 	    return;
     }
@@ -250,7 +744,7 @@ void ATestActor::SetupStaticGeometryPhysics(TArray<AActor*> Actors, float Fricti
 				// Every sub-collider in the actor is passed to this callback function
 				// We're baking this in world space, so apply actor transform to relative
 				const FTransform FinalXform = RelTransform * Actor->GetActorTransform();
-				AddStaticCollision(Shape, FinalXform, Friction, Restitution, Actor);
+				AddOrStreamStaticCollision(Shape, FinalXform, Friction, Restitution, Actor);
 			});
 	}
 }
@@ -262,123 +756,523 @@ void ATestActor::AddStaticBody(AActor* Body, float Friction, float Restitution,i
 			// Every sub-collider in the actor is passed to this callback function
 			// We're baking this in world space, so apply actor transform to relative
 			const FTransform FinalXform = RelTransform * Body->GetActorTransform();
-			AddStaticCollision(Shape, FinalXform, Friction, Restitution, Body);
+			AddOrStreamStaticCollision(Shape, FinalXform, Friction, Restitution, Body);
 		});
-	ID = BtWorld->getNumCollisionObjects() - 1;
+	// streamed geometry has no stable index in the world
+	ID = bStreamStaticGeometry ? -1 : BtWorld->getNumCollisionObjects() - 1;
 }
 
-void ATestActor::AddProcBody(AActor* Body,  float Friction, TArray<FVector> a, TArray<FVector> b, TArray<FVector> c, TArray<FVector> d, float Restitution, int& ID)
+void ATestActor::AddProcBody(AActor* Body,  float Friction, const TArray<FVector>& a, const TArray<FVector>& b, const TArray<FVector>& c, const TArray<FVector>& d, float Restitution, int& ID)
 {
-	btCollisionShape* Shape = GetTriangleMeshShape(a,b,c,d);
-		const FTransform FinalXform = Body->GetActorTransform();
-	 procbody=	AddStaticCollision(Shape, FinalXform, Friction, Restitution, Body);
-	ID = BtWorld->getNumCollisionObjects() - 1;
+	// one collider per actor, adding again replaces the old one
+	RemoveProcBody(Body);
+	ID = -1;
+	if (a.Num() == 0) return;
+
+	ProcMeshCollider* Proc = new ProcMeshCollider();
+	// Each quad gets its own 4 vertices and is split into (a,b,c) and (a,c,d)
+	Proc->Vertices.resize(a.Num() * 4);
+	Proc->Indices.resize(a.Num() * 6);
+	for (int i = 0; i < a.Num(); i++)
+	{
+		Proc->Vertices[i * 4 + 0] = BulletHelpers::ToBtPos(a[i], FVector::ZeroVector);
+		Proc->Vertices[i * 4 + 1] = BulletHelpers::ToBtPos(b[i], FVector::ZeroVector);
+		Proc->Vertices[i * 4 + 2] = BulletHelpers::ToBtPos(c[i], FVector::ZeroVector);
+		Proc->Vertices[i * 4 + 3] = BulletHelpers::ToBtPos(d[i], FVector::ZeroVector);
+		const int Base = i * 4;
+		const int Tri[6] = { Base, Base + 1, Base + 2, Base, Base + 2, Base + 3 };
+		for (int k = 0; k < 6; k++) Proc->Indices[i * 6 + k] = Tri[k];
+	}
+
+	btIndexedMesh Part;
+	Part.m_numTriangles = a.Num() * 2;
+	Part.m_triangleIndexBase = reinterpret_cast<const unsigned char*>(&Proc->Indices[0]);
+	Part.m_triangleIndexStride = 3 * sizeof(int);
+	Part.m_numVertices = Proc->Vertices.size();
+	Part.m_vertexBase = reinterpret_cast<const unsigned char*>(&Proc->Vertices[0].x());
+	Part.m_vertexStride = sizeof(btVector3);
+	Proc->MeshInterface = new btTriangleIndexVertexArray();
+	Proc->MeshInterface->addIndexedMesh(Part, PHY_INTEGER);
+
+	const btOptimizedBvh* CookedBvh = nullptr;
+	if (bUseCookedCollision)
+	{
+		// keyed by the vertices, so any mesh the class builds that was seen while cooking skips the tree build
+		BulletCollisionCache* Cache = GetCookedCollision(Body->GetClass()->GetDefaultObject());
+		btCollisionShape* Cooked = Cache ? Cache->FindShape(GetCookedProcName(Proc)) : nullptr;
+		if (Cooked && Cooked->getShapeType() == TRIANGLE_MESH_SHAPE_PROXYTYPE)
+		{
+			CookedBvh = static_cast<btBvhTriangleMeshShape*>(Cooked)->getOptimizedBvh();
+		}
+	}
+	BuildProcMeshShape(Proc, CookedBvh);
+	Proc->Object = AddStaticCollision(Proc->Shape, Body->GetActorTransform(), Friction, Restitution, Body);
+	ProcBodies.Add(Body, Proc);
+	ID = Proc->Object->getWorldArrayIndex();
 }
 
-void ATestActor::UpdateProcBody(AActor* Body, float Friction, TArray<FVector> a, TArray<FVector> b, TArray<FVector> c, TArray<FVector> d, float Restitution, int& ID, int PrevID)
+void ATestActor::UpdateProcBody(AActor* Body, float Friction, const TArray<FVector>& a, const TArray<FVector>& b, const TArray<FVector>& c, const TArray<FVector>& d, float Restitution, int& ID, int PrevID)
 {
-	BtWorld->removeCollisionObject(procbody);
-	procbody = nullptr;
+	ProcMeshCollider** Found = ProcBodies.Find(Body);
+	if (!Found || (*Found)->Vertices.size() != a.Num() * 4)
+	{
+		// Topology changed, nothing to refit
+		AddProcBody(Body, Friction, a, b, c, d, Restitution, ID);
+		return;
+	}
+	ProcMeshCollider* Proc = *Found;
+
+	// Write the new vertices in place and collect the bounds of every triangle that moved,
+	// covering both its old and new position so the refit reaches all affected nodes
+	btVector3 DirtyMin(BT_LARGE_FLOAT, BT_LARGE_FLOAT, BT_LARGE_FLOAT);
+	btVector3 DirtyMax(-BT_LARGE_FLOAT, -BT_LARGE_FLOAT, -BT_LARGE_FLOAT);
+	bool bDirty = false;
+	const TArray<FVector>* Corners[4] = { &a, &b, &c, &d };
+	for (int i = 0; i < a.Num(); i++)
+	{
+		for (int k = 0; k < 4; k++)
+		{
+			btVector3& V = Proc->Vertices[i * 4 + k];
+			const btVector3 NewV = BulletHelpers::ToBtPos((*Corners[k])[i], FVector::ZeroVector);
+			if (NewV != V)
+			{
+				DirtyMin.setMin(V);
+				DirtyMax.setMax(V);
+				DirtyMin.setMin(NewV);
+				DirtyMax.setMax(NewV);
+				V = NewV;
+				bDirty = true;
+			}
+		}
+	}
 
-	btCollisionShape* Shape = GetTriangleMeshShape(a, b, c, d);
-	const FTransform FinalXform = Body->GetActorTransform();
-	procbody = AddStaticCollision(Shape, FinalXform, Friction, Restitution, Body);
-	
-	ID = BtWorld->getNumCollisionObjects() - 1;
+	btCollisionObject* Obj = Proc->Object;
+	Obj->setFriction(Friction);
+	Obj->setRestitution(Restitution);
+	const btTransform NewXform = BulletHelpers::ToBt(Body->GetActorTransform(), GetActorLocation());
+	if (bDirty || !(NewXform == Obj->getWorldTransform()))
+	{
+		// the mesh moves under whatever sleeps on it, before a rebuild drops the manifolds that tell us who that is
+		WakeBodiesTouching(Obj);
+	}
+	Obj->setWorldTransform(NewXform);
+
+	if (bDirty)
+	{
+		const bool bInsideQuantization =
+			DirtyMin.x() >= Proc->BvhAabbMin.x() && DirtyMin.y() >= Proc->BvhAabbMin.y() && DirtyMin.z() >= Proc->BvhAabbMin.z() &&
+			DirtyMax.x() <= Proc->BvhAabbMax.x() && DirtyMax.y() <= Proc->BvhAabbMax.y() && DirtyMax.z() <= Proc->BvhAabbMax.z();
+		if (bInsideQuantization)
+		{
+			Proc->Shape->partialRefitTree(DirtyMin, DirtyMax);
+		}
+		else
+		{
+			// Deformed past what the quantized tree can represent, rebuild against the same vertex storage
+			btBvhTriangleMeshShape* OldShape = Proc->Shape;
+			btOptimizedBvh* OldBvh = Proc->CookedBvh;
+			Proc->CookedBvh = nullptr;
+			BuildProcMeshShape(Proc);
+			Obj->setCollisionShape(Proc->Shape);
+			BtWorld->getBroadphase()->getOverlappingPairCache()->cleanProxyFromPairs(Obj->getBroadphaseHandle(), BtWorld->getDispatcher());
+			delete OldShape;
+			delete OldBvh;
+		}
+	}
+	BtWorld->updateSingleAabb(Obj);
+
+	ID = Obj->getWorldArrayIndex();
 }
 
-void ATestActor::AddRigidBody(AActor* actor, float Friction, float Restitution, float mass)
+void ATestActor::RemoveProcBody(AActor* Body)
 {
-	btRigidBody* rb = AddRigidBody(actor, GetCachedDynamicShapeData(actor, mass), Friction, Restitution);
-	BodyToActor.Add(rb, actor);
-	ActorToBody.Add(actor, rb);
-	// add input buffer?
+	ProcMeshCollider* Proc = nullptr;
+	if (ProcBodies.RemoveAndCopyValue(Body, Proc))
+	{
+		DestroyProcMeshCollider(Proc);
+	}
 }
 
-btRigidBody* ATestActor::AddRigidBodyAndReturn(AActor* Body, float Friction, float Restitution, float mass)
+void ATestActor::BuildProcMeshShape(ProcMeshCollider* Proc, const btOptimizedBvh* CookedBvh)
 {
-	btRigidBody* rb = AddRigidBody(Body, GetCachedDynamicShapeData(Body, mass), Friction, Restitution);
-	BodyToActor.Add(rb, Body);
-	ActorToBody.Add(Body, rb);
-	// add input buffer?
-	return rb;
+	if (CookedBvh)
+	{
+		// copied, because refits write into the tree and the cooked one may be handed to another actor later
+		Proc->CookedBvh = new btOptimizedBvh(*CookedBvh);
+		Proc->BvhAabbMin = CookedBvh->getQuantizationAabbMin();
+		Proc->BvhAabbMax = CookedBvh->getQuantizationAabbMax();
+		Proc->Shape = new btBvhTriangleMeshShape(Proc->MeshInterface, true, Proc->BvhAabbMin, Proc->BvhAabbMax, false);
+		Proc->Shape->setOptimizedBvh(Proc->CookedBvh);
+		return;
+	}
+
+	// Quantize over the current bounds plus some slack, so later deformation can be refit in place
+	btVector3 MeshMin, MeshMax;
+	Proc->MeshInterface->calculateAabbBruteForce(MeshMin, MeshMax);
+	const btScalar Slack = BulletHelpers::ToBtSize(ProcMeshBoundsSlack);
+	Proc->BvhAabbMin = MeshMin - btVector3(Slack, Slack, Slack);
+	Proc->BvhAabbMax = MeshMax + btVector3(Slack, Slack, Slack);
+	Proc->Shape = new btBvhTriangleMeshShape(Proc->MeshInterface, true, Proc->BvhAabbMin, Proc->BvhAabbMax);
 }
 
-void ATestActor::UpdatePlayertransform(AActor* player, int ID)
+void ATestActor::DestroyProcMeshCollider(ProcMeshCollider* Proc)
 {
-		BtWorld->getCollisionObjectArray()[ID]->setWorldTransform(BulletHelpers::ToBt(player->GetActorTransform(), GetActorLocation()));
+	if (Proc->Object)
+	{
+		if (BtWorld) BtWorld->removeCollisionObject(Proc->Object);
+		BtStaticObjects.RemoveSingleSwap(Proc->Object, EAllowShrinking::No);
+		ForgetContactPairs(Proc->Object);
+		delete Proc->Object;
+	}
+	delete Proc->Shape;
+	delete Proc->CookedBvh;
+	delete Proc->MeshInterface;
+	delete Proc;
 }
 
-void ATestActor::AddImpulse( int ID, FVector Impulse, FVector Location)
+// lowest and highest sample * HeightScale in [MinX, MaxX] x [MinY, MaxY]
+static void GetHeightfieldRange(const ATestActor::HeightfieldCollider* Field, int32 MinX, int32 MinY, int32 MaxX, int32 MaxY, float& OutMin, float& OutMax)
 {
-	BtRigidBodies[ID]->applyImpulse(BulletHelpers::ToBtDir(Impulse, true), BulletHelpers::ToBtPos(Location, GetActorLocation()));
+	OutMin = TNumericLimits<float>::Max();
+	OutMax = TNumericLimits<float>::Lowest();
+	for (int32 Y = MinY; Y <= MaxY; Y++)
+	{
+		for (int32 X = MinX; X <= MaxX; X++)
+		{
+			const int32 i = Y * Field->SizeX + X;
+			const float H = Field->bQuantized
+				? static_cast<const uint16*>(Field->Samples)[i] * Field->HeightScale
+				: static_cast<const float*>(Field->Samples)[i];
+			OutMin = FMath::Min(OutMin, H);
+			OutMax = FMath::Max(OutMax, H);
+		}
+	}
 }
 
-// these use IDs instead of references and shouldn't be used
-
-void ATestActor::AddForce(int ID, FVector Force, FVector Location)
+static uint16 QuantizeHeight(const ATestActor::HeightfieldCollider* Field, float Height)
 {
-	BtRigidBodies[ID]->applyForce(BulletHelpers::ToBtDir(Force, true), BulletHelpers::ToBtPos(Location, GetActorLocation()));
+	return static_cast<uint16>(FMath::Clamp(FMath::RoundToInt((Height - Field->HeightOffset) / Field->HeightScale), 0, 65535));
 }
 
-void ATestActor::AddCentralForce(int ID, FVector Force)
+btCollisionObject* ATestActor::AddHeightfield(AActor* Body, const uint16* Samples, int32 SizeX, int32 SizeY, float SampleSpacing, float HeightScale, float HeightOffset, float Friction, float Restitution)
 {
-	BtRigidBodies[ID]->applyCentralForce(BulletHelpers::ToBtDir(Force, true));
+	// one collider per actor, adding again replaces the old one
+	RemoveHeightfield(Body);
+	if (!Samples || SizeX < 2 || SizeY < 2 || HeightScale == 0.f) return nullptr;
+
+	HeightfieldCollider* Field = new HeightfieldCollider();
+	Field->Samples = Samples;
+	Field->bQuantized = true;
+	Field->SizeX = SizeX;
+	Field->SizeY = SizeY;
+	Field->SampleSpacing = SampleSpacing;
+	Field->HeightScale = HeightScale;
+	Field->HeightOffset = HeightOffset;
+	return AddHeightfield(Body, Field, Friction, Restitution);
 }
 
-void ATestActor::AddTorque(int ID, FVector Torque)
+btCollisionObject* ATestActor::AddHeightfield(AActor* Body, const float* Samples, int32 SizeX, int32 SizeY, float SampleSpacing, float Friction, float Restitution)
 {
-	BtRigidBodies[ID]->applyTorque(BulletHelpers::ToBtDir(Torque, true));
+	RemoveHeightfield(Body);
+	if (!Samples || SizeX < 2 || SizeY < 2) return nullptr;
+
+	HeightfieldCollider* Field = new HeightfieldCollider();
+	Field->Samples = Samples;
+	Field->SizeX = SizeX;
+	Field->SizeY = SizeY;
+	Field->SampleSpacing = SampleSpacing;
+	return AddHeightfield(Body, Field, Friction, Restitution);
 }
 
-void ATestActor::AddTorqueImpulse(int ID, FVector Torque)
+btCollisionObject* ATestActor::AddHeightfield(AActor* Body, HeightfieldCollider* Field, float Friction, float Restitution)
 {
-	BtRigidBodies[ID]->applyTorqueImpulse(BulletHelpers::ToBtDir(Torque, true));
+	GetHeightfieldRange(Field, 0, 0, Field->SizeX - 1, Field->SizeY - 1, Field->MinHeight, Field->MaxHeight);
+	Field->MinHeight -= HeightfieldHeightSlack;
+	Field->MaxHeight += HeightfieldHeightSlack;
+	BuildHeightfieldShape(Field);
+	Field->Object = AddStaticCollision(Field->Shape, GetHeightfieldTransform(Field, Body), Friction, Restitution, Body);
+	HeightfieldBodies.Add(Body, Field);
+	return Field->Object;
 }
 
-void ATestActor::GetVelocityAtLocation(int ID, FVector Location, FVector&Velocity)
+void ATestActor::AddHeightfieldBody(AActor* Body, const TArray<float>& Heights, int32 SizeX, int32 SizeY, float SampleSpacing, bool bQuantize, float Friction, float Restitution, int& ID)
 {
-	if (BtRigidBodies[ID]) {
-		Velocity = BulletHelpers::ToUEPos(BtRigidBodies[ID]->getVelocityInLocalPoint(BulletHelpers::ToBtPos(Location, GetActorLocation())), FVector(0));
+	RemoveHeightfield(Body);
+	ID = -1;
+	if (SizeX < 2 || SizeY < 2 || Heights.Num() != SizeX * SizeY) return;
+
+	HeightfieldCollider* Field = new HeightfieldCollider();
+	Field->SizeX = SizeX;
+	Field->SizeY = SizeY;
+	Field->SampleSpacing = SampleSpacing;
+	if (bQuantize)
+	{
+		// 16-bit steps over the heights' range plus slack, later edits are clamped to it
+		float Lo = TNumericLimits<float>::Max();
+		float Hi = TNumericLimits<float>::Lowest();
+		for (float H : Heights)
+		{
+			Lo = FMath::Min(Lo, H);
+			Hi = FMath::Max(Hi, H);
+		}
+		Field->HeightOffset = Lo - HeightfieldHeightSlack;
+		Field->HeightScale = FMath::Max((Hi - Lo + 2.f * HeightfieldHeightSlack) / 65535.f, KINDA_SMALL_NUMBER);
+		Field->QuantizedHeights.SetNumUninitialized(Heights.Num());
+		for (int32 i = 0; i < Heights.Num(); i++)
+		{
+			Field->QuantizedHeights[i] = QuantizeHeight(Field, Heights[i]);
+		}
+		Field->Samples = Field->QuantizedHeights.GetData();
+		Field->bQuantized = true;
 	}
+	else
+	{
+		Field->Heights = Heights;
+		Field->Samples = Field->Heights.GetData();
+	}
+	ID = AddHeightfield(Body, Field, Friction, Restitution)->getWorldArrayIndex();
 }
 
-void ATestActor::ExtractPhysicsGeometry(AActor* Actor, PhysicsGeometryCallback CB)
+void ATestActor::UpdateHeightfieldBody(AActor* Body, const TArray<float>& Heights, int32 X, int32 Y, int32 RegionSizeX, int32 RegionSizeY)
 {
-	TInlineComponentArray<UActorComponent*, 20> Components;
-	// Used to easily get a component's transform relative to actor, not parent component
-	const FTransform InvActorTransform = Actor->GetActorTransform().Inverse();
+	HeightfieldCollider** Found = HeightfieldBodies.Find(Body);
+	if (!Found || Heights.Num() != RegionSizeX * RegionSizeY) return;
+	HeightfieldCollider* Field = *Found;
+	// colliders added from C++ read the caller's buffer, that's where their edits go
+	if (Field->Heights.Num() == 0 && Field->QuantizedHeights.Num() == 0) return;
 
-	// Collisions from meshes
-	
-	Actor->GetComponents(UStaticMeshComponent::StaticClass(), Components);
-	for (auto&& Comp : Components)
+	for (int32 j = 0; j < RegionSizeY; j++)
 	{
-		ExtractPhysicsGeometry(Cast<UStaticMeshComponent>(Comp), InvActorTransform, CB);
+		const int32 SampleY = Y + j;
+		if (SampleY < 0 || SampleY >= Field->SizeY) continue;
+		for (int32 i = 0; i < RegionSizeX; i++)
+		{
+			const int32 SampleX = X + i;
+			if (SampleX < 0 || SampleX >= Field->SizeX) continue;
+			const float H = Heights[j * RegionSizeX + i];
+			if (Field->bQuantized) Field->QuantizedHeights[SampleY * Field->SizeX + SampleX] = QuantizeHeight(Field, H);
+			else Field->Heights[SampleY * Field->SizeX + SampleX] = H;
+		}
 	}
-	
-	// Collisions from separate collision components
-	Actor->GetComponents(UShapeComponent::StaticClass(), Components);
-	for (auto&& Comp : Components)
+	UpdateHeightfieldRegion(Body, X, Y, X + RegionSizeX - 1, Y + RegionSizeY - 1);
+}
+
+void ATestActor::UpdateHeightfieldRegion(AActor* Body, int32 MinX, int32 MinY, int32 MaxX, int32 MaxY)
+{
+	HeightfieldCollider** Found = HeightfieldBodies.Find(Body);
+	if (!Found) return;
+	HeightfieldCollider* Field = *Found;
+	MinX = FMath::Max(MinX, 0);
+	MinY = FMath::Max(MinY, 0);
+	MaxX = FMath::Min(MaxX, Field->SizeX - 1);
+	MaxY = FMath::Min(MaxY, Field->SizeY - 1);
+	if (MinX > MaxX || MinY > MaxY) return;
+
+	btCollisionObject* Obj = Field->Object;
+	// the ground moves under whatever sleeps on it
+	WakeBodiesTouching(Obj);
+
+	float RegionMin, RegionMax;
+	GetHeightfieldRange(Field, MinX, MinY, MaxX, MaxY, RegionMin, RegionMax);
+	if (RegionMin >= Field->MinHeight && RegionMax <= Field->MaxHeight)
 	{
-		ExtractPhysicsGeometry(Cast<UShapeComponent>(Comp), InvActorTransform, CB);
+		// the shape reads the samples directly, only the ray test bounds of the touched chunks are stale
+		Field->Shape->updateAccelerator(MinX, MinY, MaxX, MaxY);
+		return;
 	}
+
+	// Edited past the height range the shape was built for. There is no BVH behind it, so just build a new
+	// one over the same samples, it's recentred on the new range so the object moves with it
+	GetHeightfieldRange(Field, 0, 0, Field->SizeX - 1, Field->SizeY - 1, Field->MinHeight, Field->MaxHeight);
+	Field->MinHeight -= HeightfieldHeightSlack;
+	Field->MaxHeight += HeightfieldHeightSlack;
+	btHeightfieldTerrainShape* OldShape = Field->Shape;
+	BuildHeightfieldShape(Field);
+	Obj->setCollisionShape(Field->Shape);
+	Obj->setWorldTransform(BulletHelpers::ToBt(GetHeightfieldTransform(Field, Body), GetActorLocation()));
+	BtWorld->getBroadphase()->getOverlappingPairCache()->cleanProxyFromPairs(Obj->getBroadphaseHandle(), BtWorld->getDispatcher());
+	delete OldShape;
+	BtWorld->updateSingleAabb(Obj);
 }
 
+void ATestActor::RemoveHeightfield(AActor* Body)
+{
+	HeightfieldCollider* Field = nullptr;
+	if (HeightfieldBodies.RemoveAndCopyValue(Body, Field))
+	{
+		DestroyHeightfieldCollider(Field);
+	}
+}
 
-btCollisionObject* ATestActor::AddStaticCollision(btCollisionShape* Shape, const FTransform& Transform, float Friction,
-	float Restitution, AActor* Actor)
+void ATestActor::BuildHeightfieldShape(HeightfieldCollider* Field)
 {
-	btTransform Xform = BulletHelpers::ToBt(Transform, GetActorLocation());
-	btCollisionObject* Obj = new btCollisionObject();
+	if (Field->bQuantized)
+	{
+		Field->Shape = new btHeightfieldTerrainShape(Field->SizeX, Field->SizeY, static_cast<const unsigned short*>(Field->Samples),
+			Field->HeightScale, Field->MinHeight, Field->MaxHeight, 2, false);
+	}
+	else
+	{
+		Field->Shape = new btHeightfieldTerrainShape(Field->SizeX, Field->SizeY, static_cast<const float*>(Field->Samples),
+			Field->MinHeight, Field->MaxHeight, 2, false);
+	}
+	// heights stay in UE units inside the shape, the scaling takes the whole grid to Bullet units
+	const btScalar Spacing = BulletHelpers::ToBtSize(Field->SampleSpacing);
+	Field->Shape->setLocalScaling(btVector3(Spacing, Spacing, BulletHelpers::ToBtSize(1.f)));
+	// per-chunk height bounds, lets ray tests skip whole 16x16 blocks
+	Field->Shape->buildAccelerator(16);
+}
+
+FTransform ATestActor::GetHeightfieldTransform(const HeightfieldCollider* Field, const AActor* Body) const
+{
+	// The shape's origin is the middle of its grid and of its height range. The actor's scale is
+	// already in the spacing and height scale.
+	const FVector LocalCenter(
+		0.5f * (Field->SizeX - 1) * Field->SampleSpacing,
+		0.5f * (Field->SizeY - 1) * Field->SampleSpacing,
+		0.5f * (Field->MinHeight + Field->MaxHeight) + Field->HeightOffset);
+	const FTransform ActorXform(Body->GetActorQuat(), Body->GetActorLocation());
+	return FTransform(ActorXform.GetRotation(), ActorXform.TransformPositionNoScale(LocalCenter));
+}
+
+void ATestActor::DestroyHeightfieldCollider(HeightfieldCollider* Field)
+{
+	if (Field->Object)
+	{
+		if (BtWorld) BtWorld->removeCollisionObject(Field->Object);
+		BtStaticObjects.RemoveSingleSwap(Field->Object, EAllowShrinking::No);
+		ForgetContactPairs(Field->Object);
+		delete Field->Object;
+	}
+	delete Field->Shape;
+	delete Field;
+}
+
+void ATestActor::AddRigidBody(AActor* actor, float Friction, float Restitution, float mass, EBulletCollisionLayer Layer)
+{
+	btRigidBody* rb = AddRigidBody(actor, GetCachedDynamicShapeData(actor, mass), Friction, Restitution, Layer);
+	BodyToActor.Add(rb, actor);
+	ActorToBody.Add(actor, rb);
+	// add input buffer?
+}
+
+btRigidBody* ATestActor::AddRigidBodyAndReturn(AActor* Body, float Friction, float Restitution, float mass, EBulletCollisionLayer Layer)
+{
+	btRigidBody* rb = AddRigidBody(Body, GetCachedDynamicShapeData(Body, mass), Friction, Restitution, Layer);
+	BodyToActor.Add(rb, Body);
+	ActorToBody.Add(Body, rb);
+	// add input buffer?
+	return rb;
+}
+
+void ATestActor::UpdatePlayertransform(AActor* player, int ID)
+{
+		BtWorld->getCollisionObjectArray()[ID]->setWorldTransform(BulletHelpers::ToBt(player->GetActorTransform(), GetActorLocation()));
+		BtWorld->updateSingleAabb(BtWorld->getCollisionObjectArray()[ID]);
+}
+
+btRigidBody* ATestActor::GetBodyById(int ID) const
+{
+	return BodiesById.IsValidIndex(ID) ? BodiesById[ID] : nullptr;
+}
+
+void ATestActor::AddImpulse( int ID, FVector Impulse, FVector Location)
+{
+	btRigidBody* Body = GetBodyById(ID);
+	if (!Body) return;
+	// Bullet doesn't wake bodies for forces or impulses, a sleeping one would just drop them
+	Body->activate();
+	Body->applyImpulse(BulletHelpers::ToBtDir(Impulse, true), BulletHelpers::ToBtPos(Location, GetActorLocation()));
+}
+
+// these use IDs instead of references and shouldn't be used
+
+void ATestActor::AddForce(int ID, FVector Force, FVector Location)
+{
+	btRigidBody* Body = GetBodyById(ID);
+	if (!Body) return;
+	Body->activate();
+	Body->applyForce(BulletHelpers::ToBtDir(Force, true), BulletHelpers::ToBtPos(Location, GetActorLocation()));
+}
+
+void ATestActor::AddCentralForce(int ID, FVector Force)
+{
+	btRigidBody* Body = GetBodyById(ID);
+	if (!Body) return;
+	Body->activate();
+	Body->applyCentralForce(BulletHelpers::ToBtDir(Force, true));
+}
+
+void ATestActor::AddTorque(int ID, FVector Torque)
+{
+	btRigidBody* Body = GetBodyById(ID);
+	if (!Body) return;
+	Body->activate();
+	Body->applyTorque(BulletHelpers::ToBtDir(Torque, true));
+}
+
+void ATestActor::AddTorqueImpulse(int ID, FVector Torque)
+{
+	btRigidBody* Body = GetBodyById(ID);
+	if (!Body) return;
+	Body->activate();
+	Body->applyTorqueImpulse(BulletHelpers::ToBtDir(Torque, true));
+}
+
+void ATestActor::GetVelocityAtLocation(int ID, FVector Location, FVector&Velocity)
+{
+	if (btRigidBody* Body = GetBodyById(ID)) {
+		Velocity = BulletHelpers::ToUEPos(Body->getVelocityInLocalPoint(BulletHelpers::ToBtPos(Location, GetActorLocation())), FVector(0));
+	}
+}
+
+void ATestActor::WakeBodiesTouching(const btCollisionObject* Obj)
+{
+	btDispatcher* Dispatcher = BtWorld->getDispatcher();
+	for (int i = 0; i < Dispatcher->getNumManifolds(); i++)
+	{
+		const btPersistentManifold* Manifold = Dispatcher->getManifoldByIndexInternal(i);
+		if (Manifold->getBody0() == Obj) Manifold->getBody1()->activate();
+		else if (Manifold->getBody1() == Obj) Manifold->getBody0()->activate();
+	}
+}
+
+void ATestActor::ExtractPhysicsGeometry(AActor* Actor, PhysicsGeometryCallback CB)
+{
+	TInlineComponentArray<UActorComponent*, 20> Components;
+	// Used to easily get a component's transform relative to actor, not parent component
+	const FTransform InvActorTransform = Actor->GetActorTransform().Inverse();
+
+	// Collisions from meshes
+	
+	Actor->GetComponents(UStaticMeshComponent::StaticClass(), Components);
+	for (auto&& Comp : Components)
+	{
+		ExtractPhysicsGeometry(Cast<UStaticMeshComponent>(Comp), InvActorTransform, CB);
+	}
+	
+	// Collisions from separate collision components
+	Actor->GetComponents(UShapeComponent::StaticClass(), Components);
+	for (auto&& Comp : Components)
+	{
+		ExtractPhysicsGeometry(Cast<UShapeComponent>(Comp), InvActorTransform, CB);
+	}
+}
+
+
+btCollisionObject* ATestActor::AddStaticCollision(btCollisionShape* Shape, const FTransform& Transform, float Friction,
+	float Restitution, AActor* Actor)
+{
+	btTransform Xform = BulletHelpers::ToBt(Transform, GetActorLocation());
+	btCollisionObject* Obj = new btCollisionObject();
 	Obj->setCollisionShape(Shape);
 	Obj->setWorldTransform(Xform);
 	Obj->setFriction(Friction);
 	Obj->setRestitution(Restitution);
 	Obj->setUserPointer(Actor);
-	Obj->setActivationState(DISABLE_DEACTIVATION);
-	BtWorld->addCollisionObject(Obj);
-	UE_LOG(LogTemp, Warning, TEXT("Static geom added"));
+	// asleep like Bullet's own static bodies: pairs with sleeping bodies and other statics skip the narrowphase
+	Obj->setActivationState(ISLAND_SLEEPING);
+	BtWorld->addCollisionObject(Obj, 1 << (int32)EBulletCollisionLayer::Static, LayerMasks[(int32)EBulletCollisionLayer::Static]);
 	BtStaticObjects.Add(Obj);
 	
 	return Obj;
@@ -388,6 +1282,175 @@ btCollisionObject* ATestActor::AddStaticCollision(btCollisionShape* Shape, const
 
 
 
+void ATestActor::AddOrStreamStaticCollision(btCollisionShape* Shape, const FTransform& Transform, float Friction,
+	float Restitution, AActor* Actor)
+{
+	const btTransform Xform = BulletHelpers::ToBt(Transform, GetActorLocation());
+	btVector3 AabbMin, AabbMax;
+	Shape->getAabb(Xform, AabbMin, AabbMax);
+	const btScalar CellSize = BulletHelpers::ToBtSize(StaticChunkSize);
+	const btVector3 Extent = AabbMax - AabbMin;
+
+	// Huge pieces (floors, skyboxes) would be needed from several cells at once, keep them resident
+	if (!bStreamStaticGeometry || Extent.x() > CellSize || Extent.y() > CellSize || Extent.z() > CellSize)
+	{
+		AddStaticCollision(Shape, Transform, Friction, Restitution, Actor);
+		return;
+	}
+
+	const FIntVector Cell = GetStaticChunkCell((AabbMin + AabbMax) * 0.5f);
+	StaticChunk*& Chunk = StaticChunks.FindOrAdd(Cell);
+	if (!Chunk) Chunk = new StaticChunk();
+
+	// batched per actor too, so hits and contacts on a chunk still report whose geometry it was
+	StaticChunkBatch* Batch = Chunk->Batches.FindByPredicate([Actor, Friction, Restitution](const StaticChunkBatch& B)
+	{
+		return B.Actor == Actor && B.Friction == Friction && B.Restitution == Restitution;
+	});
+	if (!Batch)
+	{
+		Batch = &Chunk->Batches.AddDefaulted_GetRef();
+		Batch->Actor = Actor;
+		Batch->Friction = Friction;
+		Batch->Restitution = Restitution;
+	}
+	Batch->Entries.Add({ Shape, Xform });
+}
+
+FIntVector ATestActor::GetStaticChunkCell(const btVector3& Position) const
+{
+	const btScalar CellSize = BulletHelpers::ToBtSize(StaticChunkSize);
+	return FIntVector(
+		FMath::FloorToInt(Position.x() / CellSize),
+		FMath::FloorToInt(Position.y() / CellSize),
+		FMath::FloorToInt(Position.z() / CellSize));
+}
+
+void ATestActor::UpdateStaticChunkStreaming()
+{
+	// Cells a body is in or near are wanted, cells just beyond that are kept to avoid thrashing at edges
+	TSet<FIntVector> Wanted;
+	TSet<FIntVector> Keep;
+	const int32 R = StaticChunkLoadRadius;
+	for (btRigidBody* Body : BtRigidBodies)
+	{
+		const FIntVector C = GetStaticChunkCell(Body->getWorldTransform().getOrigin());
+		for (int32 X = -R - 1; X <= R + 1; X++)
+		for (int32 Y = -R - 1; Y <= R + 1; Y++)
+		for (int32 Z = -R - 1; Z <= R + 1; Z++)
+		{
+			const FIntVector N = C + FIntVector(X, Y, Z);
+			if (!StaticChunks.Contains(N)) continue;
+			Keep.Add(N);
+			if (FMath::Abs(X) <= R && FMath::Abs(Y) <= R && FMath::Abs(Z) <= R) Wanted.Add(N);
+		}
+	}
+
+	for (auto& Pair : StaticChunks)
+	{
+		if (Wanted.Contains(Pair.Key))
+		{
+			LoadStaticChunk(Pair.Value);
+		}
+		else if (!Keep.Contains(Pair.Key))
+		{
+			UnloadStaticChunk(Pair.Value);
+		}
+	}
+}
+
+void ATestActor::LoadStaticChunk(StaticChunk* Chunk)
+{
+	if (Chunk->bLoaded) return;
+	Chunk->bLoaded = true;
+	// the same tick everywhere, however fast this machine's workers are
+	Chunk->AddTick = ticker + FMath::Max(StaticChunkBuildDelay, 0);
+
+	for (StaticChunkBatch& Batch : Chunk->Batches)
+	{
+		if (Batch.Object || Batch.PendingShape.IsValid()) continue;
+
+		// Child shapes are cached and never mutated, so the compound (and its child tree) can be built
+		// on a worker without touching the world
+		Batch.PendingShape = Async(EAsyncExecution::ThreadPool, [Entries = Batch.Entries]()
+		{
+			btCompoundShape* Compound = new btCompoundShape(true, Entries.Num());
+			for (const StaticChunkEntry& Entry : Entries)
+			{
+				Compound->addChildShape(Entry.Transform, Entry.Shape);
+			}
+			return Compound;
+		});
+	}
+}
+
+void ATestActor::UnloadStaticChunk(StaticChunk* Chunk)
+{
+	if (!Chunk->bLoaded) return;
+	Chunk->bLoaded = false;
+	if (!Chunk->bInWorld) return; // a build still in flight is kept for the next load
+	Chunk->bInWorld = false;
+
+	for (StaticChunkBatch& Batch : Chunk->Batches)
+	{
+		BtWorld->removeCollisionObject(Batch.Object);
+		BtStaticObjects.RemoveSingleSwap(Batch.Object, EAllowShrinking::No);
+	}
+}
+
+void ATestActor::SwapInBuiltStaticChunks()
+{
+	for (auto& Pair : StaticChunks)
+	{
+		StaticChunk* Chunk = Pair.Value;
+		if (!Chunk->bLoaded || Chunk->bInWorld || ticker < Chunk->AddTick) continue;
+
+		for (StaticChunkBatch& Batch : Chunk->Batches)
+		{
+			if (!Batch.Object)
+			{
+				// blocks if the worker is still going, adding it late would desync the tick it appears on
+				Batch.Shape = Batch.PendingShape.Get();
+				Batch.PendingShape.Reset();
+				// Children are already in world space, so the compound sits at the Bullet origin
+				btCollisionObject* Obj = new btCollisionObject();
+				Obj->setCollisionShape(Batch.Shape);
+				Obj->setWorldTransform(btTransform::getIdentity());
+				Obj->setFriction(Batch.Friction);
+				Obj->setRestitution(Batch.Restitution);
+				Obj->setUserPointer(Batch.Actor);
+				Obj->setActivationState(ISLAND_SLEEPING);
+				Batch.Object = Obj;
+			}
+			BtWorld->addCollisionObject(Batch.Object, 1 << (int32)EBulletCollisionLayer::Static, LayerMasks[(int32)EBulletCollisionLayer::Static]);
+			BtStaticObjects.Add(Batch.Object);
+		}
+		Chunk->bInWorld = true;
+	}
+}
+
+void ATestActor::DestroyStaticChunks()
+{
+	for (auto& Pair : StaticChunks)
+	{
+		for (StaticChunkBatch& Batch : Pair.Value->Batches)
+		{
+			if (Batch.PendingShape.IsValid())
+			{
+				delete Batch.PendingShape.Get();
+			}
+			// objects in the world were already removed and freed along with BtStaticObjects
+			if (Batch.Object && !Pair.Value->bInWorld)
+			{
+				delete Batch.Object;
+			}
+			delete Batch.Shape;
+		}
+		delete Pair.Value;
+	}
+	StaticChunks.Empty();
+}
+
 void ATestActor::ExtractPhysicsGeometry(UStaticMeshComponent* SMC, const FTransform& InvActorXform, PhysicsGeometryCallback CB)
 {
 	UStaticMesh* Mesh = SMC->GetStaticMesh();
@@ -396,15 +1459,18 @@ void ATestActor::ExtractPhysicsGeometry(UStaticMeshComponent* SMC, const FTransf
 
 	// We want the complete transform from actor to this component, not just relative to parent
 	FTransform CompFullRelXForm = SMC->GetComponentTransform() * InvActorXform;
-	ExtractPhysicsGeometry(CompFullRelXForm, Mesh->GetBodySetup(), CB);
-
-	// Not supporting complex collision shapes right now
-	// If we did, note that Mesh->ComplexCollisionMesh is WITH_EDITORONLY_DATA so not available at runtime
-	// See StaticMeshRender.cpp, FStaticMeshSceneProxy::GetDynamicMeshElements
-	// Line 1417+, bDrawComplexCollision
-	// Looks like we have to access LODForCollision, RenderData->LODResources
-	// So they use a mesh LOD for collision for complex shapes, never drawn usually?
 
+	// Complex collision goes through a distance field baked from the render data of LODForCollision,
+	// Mesh->ComplexCollisionMesh is WITH_EDITORONLY_DATA so not available at runtime
+	if (SdfStaticActors.Contains(SMC->GetOwner()))
+	{
+		if (btCollisionShape* Sdf = GetSdfCollisionShape(Mesh, CompFullRelXForm.GetScale3D()))
+		{
+			CB(Sdf, CompFullRelXForm);
+			return;
+		}
+	}
+	ExtractPhysicsGeometry(CompFullRelXForm, Mesh->GetBodySetup(), CB);
 }
 
 
@@ -502,6 +1568,11 @@ btCollisionShape* ATestActor::GetSphereCollisionShape(float Radius)
 		}
 	}
 
+	if (SdfStaticActors.Num() > 0 && Radius >= SdfBand)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Sphere radius %.1f cm is past SdfBand (%.1f cm), it only collides with distance fields through a few support points"), Radius, SdfBand);
+	}
+
 	// Not found, create
 	auto S = new btSphereShape(Rad);
 	// Get rid of margins, just cause issues for me
@@ -529,6 +1600,11 @@ btCollisionShape* ATestActor::GetCapsuleCollisionShape(float Radius, float Heigh
 		}
 	}
 
+	if (SdfStaticActors.Num() > 0 && Radius >= SdfBand)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Capsule radius %.1f cm is past SdfBand (%.1f cm), it only collides with distance fields through a few support points"), Radius, SdfBand);
+	}
+
 	// Not found, create
 	auto S = new btCapsuleShape(R, H);
 	BtCapsuleCollisionShapes.Add(S);
@@ -537,7 +1613,7 @@ btCollisionShape* ATestActor::GetCapsuleCollisionShape(float Radius, float Heigh
 
 }
 
-btCollisionShape* ATestActor::GetTriangleMeshShape(TArray<FVector> a, TArray<FVector> b, TArray<FVector> c, TArray<FVector> d)
+btCollisionShape* ATestActor::GetTriangleMeshShape(const TArray<FVector>& a, const TArray<FVector>& b, const TArray<FVector>& c, const TArray<FVector>& d)
 {
 	btTriangleMesh* triangleMesh = new btTriangleMesh();
 
@@ -561,12 +1637,27 @@ btCollisionShape* ATestActor::GetConvexHullCollisionShape(UBodySetup* BodySetup,
 		}
 	}
 
+	if (bUseCookedCollision)
+	{
+		BulletCollisionCache* Cache = GetCookedCollision(BodySetup);
+		// the name carries a hash of the source vertices, so a stale blob just misses here
+		btCollisionShape* Cooked = Cache ? Cache->FindShape(GetCookedHullName(BodySetup, ConvexIndex, Scale)) : nullptr;
+		if (Cooked && Cooked->getShapeType() == CONVEX_HULL_SHAPE_PROXYTYPE)
+		{
+			btConvexHullShape* C = static_cast<btConvexHullShape*>(Cooked);
+			BtConvexHullCollisionShapes.Add({ BodySetup, ConvexIndex, Scale, C, true });
+			return C;
+		}
+	}
+
 	const FKConvexElem& Elem = BodySetup->AggGeom.ConvexElems[ConvexIndex];
 	auto C = new btConvexHullShape();
 	for (auto&& P : Elem.VertexData)
 	{
 		C->addPoint(BulletHelpers::ToBtPos(P, FVector::ZeroVector));
 	}
+	// artist hulls can have hundreds of vertices, every support query and clip walks all of them
+	C->simplifyConvexHull(HullVertexBudget, HullPlanarTolerance / BULLET_TO_WORLD_SCALE);
 	// Very important! Otherwise there's a gap between 
 	C->setMargin(0);
 	// Apparently this is good to call?
@@ -576,17 +1667,340 @@ btCollisionShape* ATestActor::GetConvexHullCollisionShape(UBodySetup* BodySetup,
 		BodySetup,
 		ConvexIndex,
 		Scale,
-		C
+		C,
+		false
 		});
 
 	return C;
 }
 
+FString ATestActor::GetCookedHullName(UBodySetup* BodySetup, int ConvexIndex, const FVector& Scale) const
+{
+	const TArray<FVector>& Verts = BodySetup->AggGeom.ConvexElems[ConvexIndex].VertexData;
+	uint32 SourceHash = FCrc::MemCrc32(Verts.GetData(), Verts.Num() * Verts.GetTypeSize());
+	// blobs cooked with other simplification settings miss too
+	SourceHash = FCrc::MemCrc32(&HullVertexBudget, sizeof(HullVertexBudget), SourceHash);
+	SourceHash = FCrc::MemCrc32(&HullPlanarTolerance, sizeof(HullPlanarTolerance), SourceHash);
+	return FString::Printf(TEXT("Hull_%d_%s_%08x"), ConvexIndex, *Scale.ToCompactString(), SourceHash);
+}
+
+BulletCollisionCache* ATestActor::GetCookedCollision(UObject* Asset)
+{
+	if (!bCookedFilesListed)
+	{
+		TArray<FString> Files;
+		IFileManager::Get().FindFiles(Files, *(BulletCollisionCache::GetCookedDirectory() / TEXT("*.bullet")), true, false);
+		CookedFiles.Append(Files);
+		bCookedFilesListed = true;
+	}
+
+	// Only try each asset's file once, a missing blob is remembered as null
+	if (BulletCollisionCache* const* Found = CookedCollision.Find(Asset)) return *Found;
+
+	const FString Path = BulletCollisionCache::GetCookedPath(Asset);
+	BulletCollisionCache* Loaded = nullptr;
+	if (CookedFiles.Contains(FPaths::GetCleanFilename(Path)))
+	{
+		Loaded = new BulletCollisionCache();
+		if (!Loaded->Load(Path, BtWorld))
+		{
+			delete Loaded;
+			Loaded = nullptr;
+		}
+	}
+	CookedCollision.Add(Asset, Loaded);
+	return Loaded;
+}
+
+btCollisionShape* ATestActor::GetSdfCollisionShape(UStaticMesh* Mesh, const FVector& Scale)
+{
+	for (auto&& S : BtSdfCollisionShapes)
+	{
+		if (S.Mesh == Mesh && S.Scale.Equals(Scale))
+		{
+			return S.Shape;
+		}
+	}
+
+	const FStaticMeshRenderData* RenderData = Mesh->GetRenderData();
+	if (!RenderData || RenderData->LODResources.Num() == 0)
+		return nullptr;
+
+	if (bUseCookedCollision)
+	{
+		BulletCollisionCache* Cache = GetCookedCollision(Mesh);
+		// the name carries a hash of the source mesh when there is one, so a stale blob just misses here
+		const FString Name = GetCookedSdfName(Mesh, Scale);
+		btCollisionShape* Cooked = !Cache ? nullptr : Name.EndsWith(TEXT("_")) ? Cache->FindSdfByPrefix(Name) : Cache->FindShape(Name);
+		if (Cooked && Cooked->getShapeType() == SDF_SHAPE_PROXYTYPE)
+		{
+			btSdfCollisionShape* Sdf = static_cast<btSdfCollisionShape*>(Cooked);
+			BtSdfCollisionShapes.Add({ Mesh, Scale, Sdf, true });
+			return Sdf;
+		}
+	}
+
+	// Baking needs the CPU copy of the mesh, which cooked builds drop unless the mesh allows CPU access
+	const FStaticMeshLODResources& LOD = RenderData->LODResources[FMath::Clamp(Mesh->LODForCollision, 0, RenderData->LODResources.Num() - 1)];
+	const FPositionVertexBuffer& Positions = LOD.VertexBuffers.PositionVertexBuffer;
+	FIndexArrayView Indices = LOD.IndexBuffer.GetArrayView();
+	if (!Positions.GetVertexData() || Indices.Num() < 3)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("No CPU mesh data to bake a distance field for %s, cook it or allow CPU access"), *Mesh->GetName());
+		return nullptr;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	TArray<btVector3> Vertices;
+	Vertices.Reserve(Positions.GetNumVertices());
+	for (uint32 i = 0; i < Positions.GetNumVertices(); i++)
+	{
+		Vertices.Add(BulletHelpers::ToBtPos(FVector(Positions.VertexPosition(i)) * Scale, FVector::ZeroVector));
+	}
+	TArray<int> Triangles;
+	Triangles.SetNumUninitialized(Indices.Num() / 3 * 3);
+	for (int32 i = 0; i < Triangles.Num(); i++) Triangles[i] = Indices[i];
+	// mirrored scales flip the winding, the bake sorts that out from the volume
+
+	FVector Extent = RenderData->Bounds.BoxExtent * Scale.GetAbs() * 2 + 2 * SdfBand;
+	const float CellSize = FMath::Max(SdfCellSize, Extent.GetMax() / FMath::Max(SdfMaxCellsPerAxis, 1));
+
+	btSdfCollisionShape* Sdf = new btSdfCollisionShape();
+	Sdf->getBrickGrid().build(Vertices.GetData(), Vertices.Num(), Triangles.GetData(), Triangles.Num() / 3,
+		BulletHelpers::ToBtSize(CellSize), BulletHelpers::ToBtSize(SdfBand));
+	Sdf->setMargin(0);
+	UE_LOG(LogTemp, Log, TEXT("Baked distance field for %s: %d triangles, %.1f cm cells, %d KB in %.2f s"), *Mesh->GetName(),
+		Triangles.Num() / 3, CellSize, Sdf->getBrickGrid().getMemorySize() / 1024, FPlatformTime::Seconds() - StartTime);
+
+	BtSdfCollisionShapes.Add({ Mesh, Scale, Sdf, false });
+	return Sdf;
+}
+
+FString ATestActor::GetCookedSdfName(UStaticMesh* Mesh, const FVector& Scale) const
+{
+	const FStaticMeshRenderData* RenderData = Mesh->GetRenderData();
+	const FStaticMeshLODResources& LOD = RenderData->LODResources[FMath::Clamp(Mesh->LODForCollision, 0, RenderData->LODResources.Num() - 1)];
+	// blobs baked with other grid settings miss too
+	uint32 SettingsHash = FCrc::MemCrc32(&SdfCellSize, sizeof(SdfCellSize));
+	SettingsHash = FCrc::MemCrc32(&SdfBand, sizeof(SdfBand), SettingsHash);
+	SettingsHash = FCrc::MemCrc32(&SdfMaxCellsPerAxis, sizeof(SdfMaxCellsPerAxis), SettingsHash);
+	const FString Prefix = FString::Printf(TEXT("Sdf_%s_%08x_"), *Scale.ToCompactString(), SettingsHash);
+
+	// Cooked builds drop the CPU copy of the mesh unless it allows CPU access. Then there's nothing to hash, but
+	// nothing to bake from either, and whatever blob got cooked with the build is the one to use
+	const FPositionVertexBuffer& Positions = LOD.VertexBuffers.PositionVertexBuffer;
+	if (!Positions.GetVertexData()) return Prefix;
+
+	uint32 SourceHash = FCrc::MemCrc32(Positions.GetVertexData(), Positions.GetNumVertices() * Positions.GetStride());
+	FIndexArrayView Indices = LOD.IndexBuffer.GetArrayView();
+	TArray<uint32> IndexCopy;
+	IndexCopy.SetNumUninitialized(Indices.Num());
+	for (int32 i = 0; i < Indices.Num(); i++) IndexCopy[i] = Indices[i];
+	SourceHash = FCrc::MemCrc32(IndexCopy.GetData(), IndexCopy.Num() * IndexCopy.GetTypeSize(), SourceHash);
+	return Prefix + FString::Printf(TEXT("%08x"), SourceHash);
+}
+
+void ATestActor::GetDynamicShapeSources(AActor* Actor, DynamicShapeSources& Sources) const
+{
+	// Everything ExtractPhysicsGeometry reads: component transforms relative to the actor and their body setups
+	TInlineComponentArray<UActorComponent*, 20> Components;
+	Actor->GetComponents(UPrimitiveComponent::StaticClass(), Components);
+	const FTransform InvActorTransform = Actor->GetActorTransform().Inverse();
+	Sources.Reset();
+	for (UActorComponent* Comp : Components)
+	{
+		UBodySetup* BodySetup = nullptr;
+		if (UStaticMeshComponent* SMC = Cast<UStaticMeshComponent>(Comp))
+		{
+			BodySetup = SMC->GetStaticMesh() ? SMC->GetStaticMesh()->GetBodySetup() : nullptr;
+		}
+		else if (UShapeComponent* Sc = Cast<UShapeComponent>(Comp))
+		{
+			BodySetup = Sc->ShapeBodySetup;
+		}
+		if (!BodySetup) continue;
+		Sources.Add({ BodySetup, static_cast<UPrimitiveComponent*>(Comp)->GetComponentTransform() * InvActorTransform });
+	}
+}
+
+FString ATestActor::GetCookedCompoundName(UClass* Class, const DynamicShapeSources& Sources) const
+{
+	// the simple collision of each body setup where it sits. Hull vertices are hashed through their own cooked names
+	uint32 Hash = 0;
+	for (const DynamicShapeSource& Source : Sources)
+	{
+		const UBodySetup* BodySetup = Source.BodySetup;
+		const FTransform& Rel = Source.RelTransform;
+		const FVector Parts[3] = { Rel.GetLocation(), Rel.GetRotation().Euler(), Rel.GetScale3D() };
+		Hash = FCrc::MemCrc32(Parts, sizeof(Parts), Hash);
+		for (const FKBoxElem& Box : BodySetup->AggGeom.BoxElems)
+		{
+			const FVector Values[3] = { FVector(Box.X, Box.Y, Box.Z), Box.Center, Box.Rotation.Euler() };
+			Hash = FCrc::MemCrc32(Values, sizeof(Values), Hash);
+		}
+		for (const FKSphereElem& Sphere : BodySetup->AggGeom.SphereElems)
+		{
+			const FVector Values[2] = { FVector(Sphere.Radius), Sphere.Center };
+			Hash = FCrc::MemCrc32(Values, sizeof(Values), Hash);
+		}
+		for (const FKSphylElem& Capsule : BodySetup->AggGeom.SphylElems)
+		{
+			const FVector Values[3] = { FVector(Capsule.Radius, Capsule.Length, 0), Capsule.Center, Capsule.Rotation.Euler() };
+			Hash = FCrc::MemCrc32(Values, sizeof(Values), Hash);
+		}
+		for (int32 i = 0; i < BodySetup->AggGeom.ConvexElems.Num(); i++)
+		{
+			const FString HullName = GetCookedHullName(Source.BodySetup, i, Rel.GetScale3D());
+			Hash = FCrc::StrCrc32(*HullName, Hash);
+		}
+	}
+	return FString::Printf(TEXT("Compound_%s_%08x"), *Class->GetName(), Hash);
+}
+
+FString ATestActor::GetCookedProcName(const ProcMeshCollider* Proc) const
+{
+	// the tree depends on the vertices and on how much slack it was quantized with
+	uint32 Hash = FCrc::MemCrc32(&Proc->Vertices[0], Proc->Vertices.size() * sizeof(btVector3));
+	Hash = FCrc::MemCrc32(&ProcMeshBoundsSlack, sizeof(ProcMeshBoundsSlack), Hash);
+	return FString::Printf(TEXT("Proc_%d_%08x"), Proc->Vertices.size() / 4, Hash);
+}
+
+void ATestActor::CookCollisionData()
+{
+	if (BtWorld)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("CookCollisionData: run this from the editor, not during play"));
+		return;
+	}
+
+	// Build everything through the normal runtime path, ignoring any blobs that already exist
+	TGuardValue<bool> NoCooked(bUseCookedCollision, false);
+	TArray<AActor*> Actors = PhysicsStaticActors1;
+	Actors.Append(DynamicActors);
+	for (AActor* Actor : SdfStaticActors) Actors.AddUnique(Actor);
+	for (AActor* Actor : Actors)
+	{
+		if (Actor) ExtractPhysicsGeometry(Actor, [](btCollisionShape*, const FTransform&) {});
+	}
+
+	TMap<UObject*, TArray<TPair<FString, btCollisionShape*>>> PerAsset;
+	for (const ConvexHullShapeHolder& H : BtConvexHullCollisionShapes)
+	{
+		PerAsset.FindOrAdd(H.BodySetup).Add({ GetCookedHullName(H.BodySetup, H.HullIndex, H.Scale), H.Shape });
+	}
+	for (const SdfShapeHolder& H : BtSdfCollisionShapes)
+	{
+		PerAsset.FindOrAdd(H.Mesh).Add({ GetCookedSdfName(H.Mesh, H.Scale), H.Shape });
+	}
+	// whole compounds per dynamic class, which carry their own copies of the children
+	for (AActor* Actor : DynamicActors)
+	{
+		if (!Actor) continue;
+		const CachedDynamicShapeData& Data = GetCachedDynamicShapeData(Actor, 1);
+		if (!Data.bIsCompound) continue;
+		TArray<TPair<FString, btCollisionShape*>>& Shapes = PerAsset.FindOrAdd(Actor->GetClass());
+		if (!Shapes.ContainsByPredicate([&Data](const TPair<FString, btCollisionShape*>& P) { return P.Key == Data.Name; }))
+		{
+			Shapes.Add({ Data.Name, Data.Shape });
+		}
+	}
+	for (const auto& Pair : PerAsset)
+	{
+		const FString Path = BulletCollisionCache::GetCookedPath(Pair.Key);
+		if (BulletCollisionCache::Write(Path, Pair.Value))
+		{
+			UE_LOG(LogTemp, Log, TEXT("Cooked %d shapes to %s"), Pair.Value.Num(), *Path);
+		}
+	}
+
+	// The editor instance never simulates, don't keep the shapes around
+	for (const CachedDynamicShapeData& Data : CachedDynamicShapes)
+	{
+		if (Data.bIsCompound) delete Data.Shape;
+	}
+	CachedDynamicShapes.Empty();
+	for (const ConvexHullShapeHolder& H : BtConvexHullCollisionShapes) delete H.Shape;
+	BtConvexHullCollisionShapes.Empty();
+	for (const SdfShapeHolder& H : BtSdfCollisionShapes) delete H.Shape;
+	BtSdfCollisionShapes.Empty();
+	for (btBoxShape* S : BtBoxCollisionShapes) delete S;
+	BtBoxCollisionShapes.Empty();
+	for (btSphereShape* S : BtSphereCollisionShapes) delete S;
+	BtSphereCollisionShapes.Empty();
+	for (btCapsuleShape* S : BtCapsuleCollisionShapes) delete S;
+	BtCapsuleCollisionShapes.Empty();
+}
+
+void ATestActor::CookProcMeshCollision()
+{
+	if (!BtWorld)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("CookProcMeshCollision: run this while playing, once the procedural meshes exist"));
+		return;
+	}
+
+	TMap<UObject*, TArray<TPair<FString, btCollisionShape*>>> PerClass;
+	for (const auto& Pair : ProcBodies)
+	{
+		TArray<TPair<FString, btCollisionShape*>>& Shapes = PerClass.FindOrAdd(Pair.Key->GetClass()->GetDefaultObject());
+		const FString Name = GetCookedProcName(Pair.Value);
+		if (!Shapes.ContainsByPredicate([&Name](const TPair<FString, btCollisionShape*>& P) { return P.Key == Name; }))
+		{
+			Shapes.Add({ Name, Pair.Value->Shape });
+		}
+	}
+	for (const auto& Pair : PerClass)
+	{
+		const FString Path = BulletCollisionCache::GetCookedPath(Pair.Key);
+		if (BulletCollisionCache::Write(Path, Pair.Value))
+		{
+			UE_LOG(LogTemp, Log, TEXT("Cooked %d procedural meshes to %s"), Pair.Value.Num(), *Path);
+		}
+	}
+}
+
 
 const ATestActor::CachedDynamicShapeData& ATestActor::GetCachedDynamicShapeData(AActor* Actor, float Mass)
 {
-	// We re-use compound shapes based on (leaf) BP class
-	const FName ClassName = Actor->GetClass()->GetFName();
+	// We re-use compound shapes based on what they're built from, so same-class actors share them. Every projectile
+	// spawn comes through here, so the lookup only compares body setups and transforms, the geometry is hashed once
+	UClass* Class = Actor->GetClass();
+	DynamicShapeSources Sources;
+	GetDynamicShapeSources(Actor, Sources);
+	for (const CachedDynamicShapeData& Cached : CachedDynamicShapes)
+	{
+		if (Cached.Class != Class || Cached.Mass != Mass || Cached.Sources.Num() != Sources.Num()) continue;
+		bool bSame = true;
+		for (int32 i = 0; bSame && i < Sources.Num(); i++)
+		{
+			// relative transforms come out of the actor's world transform, so they carry a little float noise
+			bSame = Cached.Sources[i].BodySetup == Sources[i].BodySetup && Cached.Sources[i].RelTransform.Equals(Sources[i].RelTransform, 1e-3);
+		}
+		if (bSame) return Cached;
+	}
+
+	CachedDynamicShapeData ShapeData;
+	ShapeData.Class = Class;
+	ShapeData.Sources.Append(Sources);
+	ShapeData.Name = GetCookedCompoundName(Class, Sources);
+	ShapeData.Mass = Mass;
+	const FString& Name = ShapeData.Name;
+
+	if (bUseCookedCollision)
+	{
+		// the whole compound, children and child tree included, without extracting anything
+		BulletCollisionCache* Cache = GetCookedCollision(Actor->GetClass());
+		btCollisionShape* Cooked = Cache ? Cache->FindShape(Name) : nullptr;
+		if (Cooked && Cooked->isCompound())
+		{
+			ShapeData.Shape = Cooked;
+			ShapeData.bIsCompound = true;
+			ShapeData.bCooked = true;
+			ShapeData.Shape->calculateLocalInertia(Mass, ShapeData.Inertia);
+			CachedDynamicShapes.Add(ShapeData);
+			return CachedDynamicShapes.Last();
+		}
+	}
 
 	// Because we want to support compound colliders, we need to extract all colliders first before
 	// constructing the final body.
@@ -600,9 +2014,6 @@ const ATestActor::CachedDynamicShapeData& ATestActor::GetCachedDynamicShapeData(
 		});
 
 
-	CachedDynamicShapeData ShapeData;
-	ShapeData.ClassName = ClassName;
-
 	// Single shape with no transform is simplest
 	if (ShapeRelXforms.Num() == 1 &&
 		ShapeRelXforms[0].EqualsNoScale(FTransform::Identity))
@@ -627,7 +2038,6 @@ const ATestActor::CachedDynamicShapeData& ATestActor::GetCachedDynamicShapeData(
 	}
 
 	// Calculate Inertia
-	ShapeData.Mass = Mass;
 	ShapeData.Shape->calculateLocalInertia(Mass, ShapeData.Inertia);
 
 	// Cache for future use
@@ -636,11 +2046,11 @@ const ATestActor::CachedDynamicShapeData& ATestActor::GetCachedDynamicShapeData(
 	return CachedDynamicShapes.Last();
 }
 
-btRigidBody* ATestActor::AddRigidBody(AActor* Actor, const ATestActor::CachedDynamicShapeData& ShapeData, float Friction, float Restitution)
+btRigidBody* ATestActor::AddRigidBody(AActor* Actor, const ATestActor::CachedDynamicShapeData& ShapeData, float Friction, float Restitution, EBulletCollisionLayer Layer)
 {
-	return AddRigidBody(Actor, ShapeData.Shape, ShapeData.Inertia, ShapeData.Mass, Friction, Restitution);
+	return AddRigidBody(Actor, ShapeData.Shape, ShapeData.Inertia, ShapeData.Mass, Friction, Restitution, Layer);
 }
-btRigidBody* ATestActor::AddRigidBody(AActor* Actor, btCollisionShape* CollisionShape, btVector3 Inertia, float Mass, float Friction, float Restitution)
+btRigidBody* ATestActor::AddRigidBody(AActor* Actor, btCollisionShape* CollisionShape, btVector3 Inertia, float Mass, float Friction, float Restitution, EBulletCollisionLayer Layer)
 {
 	// GEngine->AddOnScreenDebugMessage(        -1,          // Key: Unique identifier for the message, -1 to display multiple times
 	// 	5.0f,        // Duration: Time in seconds the message stays on screen
@@ -652,64 +2062,596 @@ btRigidBody* ATestActor::AddRigidBody(AActor* Actor, btCollisionShape* Collision
 	const btRigidBody::btRigidBodyConstructionInfo rbInfo(Mass*10, MotionState, CollisionShape, Inertia*10);
 	btRigidBody* Body = new btRigidBody(rbInfo);
 	Body->setUserPointer(Actor);
-	Body->setActivationState(DISABLE_DEACTIVATION); // changed from ACTIVE_TAG, change back after the freezing is resolved - Gage
+	// The old freeze was Bullet's default thresholds (0.8 m/s) putting slow ships to sleep with no gravity to wake them,
+	// and input forces being dropped on sleeping bodies. Pawns wake themselves through ApplyInputsAndWake now.
+	Body->setSleepingThresholds(BulletHelpers::ToBtSize(SleepLinearVelocity), SleepAngularVelocity);
+	Body->forceActivationState(bAllowSleeping ? ACTIVE_TAG : DISABLE_DEACTIVATION);
 	Body->setDeactivationTime(0);
+	// kept on the body so a resim can put it back with the same filter
+	Body->setUserIndex2((int32)Layer);
 
-	if (BtWorld) BtWorld->addRigidBody(Body); // redundant error checking?
-	BtRigidBodies.Add(Body);
+	if (BtWorld) AddBodyToWorld(Body); // redundant error checking?
+	Body->setUserIndex(BtRigidBodies.Add(Body));
+	const int32 Id = FreeBodyIds.Num() > 0 ? FreeBodyIds.Pop(EAllowShrinking::No) : BodiesById.AddDefaulted();
+	BodiesById[Id] = Body;
+	Body->setUserIndex3(Id);
 
 	return Body;
 }
 
 void ATestActor::StepPhysics(float DeltaSeconds, int substeps)
 {
-	if (BtWorld) BtWorld->stepSimulation(DeltaSeconds, substeps, 1. / 60);
+	if (!BtWorld) return;
+	// bodies can only be freed while the world isn't mid-step
+	FlushPendingDestroys();
+	ProjectileHits.Reset();
+	BtWorld->stepSimulation(DeltaSeconds, substeps, 1. / 60);
+	UpdateSolverStats();
+	UpdatePoolStats();
+	BroadphaseStats.AabbUpdates = BtWorld->getNumAabbUpdates();
+	BroadphaseStats.AabbSkips = BtWorld->getNumAabbSkips();
+	BroadphaseStats.OverlappingPairs = BtWorld->getPairCache()->getNumOverlappingPairs();
+}
+
+void ATestActor::BuildLayerMasks()
+{
+	for (int32& Mask : LayerMasks) Mask = -1;
+	for (const FBulletLayerPair& Pair : IgnoredLayerPairs)
+	{
+		LayerMasks[(int32)Pair.A] &= ~(1 << (int32)Pair.B);
+		LayerMasks[(int32)Pair.B] &= ~(1 << (int32)Pair.A);
+	}
+}
+
+void ATestActor::AddBodyToWorld(btRigidBody* Body)
+{
+	const int32 Layer = Body->getUserIndex2();
+	BtWorld->addRigidBody(Body, 1 << Layer, LayerMasks[Layer]);
+}
+
+void ATestActor::IgnoreActorCollision(btRigidBody* Body, AActor* IgnoredActor)
+{
+	if (!Body) return;
+	if (btRigidBody** Ignored = ActorToBody.Find(IgnoredActor))
+	{
+		// Bullet doesn't check for duplicates, and DestroyRigidBody only takes one entry back out
+		for (int i = 0; i < Body->getNumObjectsWithoutCollision(); i++)
+		{
+			if (Body->getObjectWithoutCollision(i) == *Ignored) return;
+		}
+		Body->setIgnoreCollisionCheck(*Ignored, true);
+	}
+}
+
+void ATestActor::EnableProjectileCcd(btRigidBody* Body, float Radius)
+{
+	if (!Body) return;
+	const btScalar BtRadius = BulletHelpers::ToBtSize(Radius);
+	Body->setFlags(Body->getFlags() | BT_ENABLE_PROJECTILE_CCD);
+	Body->setCcdSweptSphereRadius(BtRadius);
+	// only sweep when it moves further than its own radius in a step, slower shots can't skip anything
+	Body->setCcdMotionThreshold(BtRadius);
+}
+
+void ATestActor::RecordProjectileHit(btDynamicsWorld* World, const btProjectileHit& Hit)
+{
+	ATestActor* Self = static_cast<ATestActor*>(World->getWorldUserInfo());
+	FBulletProjectileHit& Out = Self->ProjectileHits.AddDefaulted_GetRef();
+	Out.Projectile = static_cast<AActor*>(Hit.m_projectile->getUserPointer());
+	Out.HitActor = static_cast<AActor*>(Hit.m_hitObject->getUserPointer());
+	Out.Location = BulletHelpers::ToUEPos(Hit.m_hitPointWorld, Self->GetActorLocation());
+	Out.Normal = BulletHelpers::ToUEDir(Hit.m_hitNormalWorld, false);
+	Out.Time = Hit.m_hitFraction;
+}
+
+// Pairs are ordered by the bodies' world array indices, not their addresses, so the events come out in the same
+// order on every machine
+static bool ContactPairLess(const ATestActor::ContactPair& L, const ATestActor::ContactPair& R)
+{
+	return L.KeyA != R.KeyA ? L.KeyA < R.KeyA : L.KeyB < R.KeyB;
+}
+
+void ATestActor::ForgetContactPairs(const btCollisionObject* Object)
+{
+	// ContactPairs is what the next step compares against
+	ContactPairs.RemoveAll([Object](const ContactPair& Pair) { return Pair.A == Object || Pair.B == Object; });
+}
+
+void ATestActor::GatherContactEvents()
+{
+	Swap(ContactPairs, PreviousContactPairs);
+	ContactPairs.Reset();
+
+	// removing an object moves the last one into its slot, so key the last step's pairs again with today's indices.
+	// Freed objects were dropped already, unloaded ones are at -1 and just end
+	bool bRekeyed = false;
+	for (ContactPair& Pair : PreviousContactPairs)
+	{
+		const int32 KeyA = Pair.A->getWorldArrayIndex();
+		const int32 KeyB = Pair.B->getWorldArrayIndex();
+		if (KeyA == Pair.KeyA && KeyB == Pair.KeyB) continue;
+		bRekeyed = true;
+		if (KeyB < KeyA)
+		{
+			Swap(Pair.A, Pair.B);
+			Swap(Pair.ActorA, Pair.ActorB);
+			Pair.Normal = -Pair.Normal;
+		}
+		Pair.KeyA = FMath::Min(KeyA, KeyB);
+		Pair.KeyB = FMath::Max(KeyA, KeyB);
+	}
+	if (bRekeyed) PreviousContactPairs.Sort(&ContactPairLess);
+
+	// one entry per touching pair of bodies, with the deepest point and the impulse of all its manifolds
+	btDispatcher* Dispatcher = BtWorld->getDispatcher();
+	const int NumManifolds = Dispatcher->getNumManifolds();
+	for (int i = 0; i < NumManifolds; i++)
+	{
+		const btPersistentManifold* Manifold = Dispatcher->getManifoldByIndexInternal(i);
+		const int NumPoints = Manifold->getNumContacts();
+		if (NumPoints == 0) continue;
+
+		const btCollisionObject* Body0 = Manifold->getBody0();
+		const btCollisionObject* Body1 = Manifold->getBody1();
+		const int Groups = Body0->getBroadphaseHandle()->m_collisionFilterGroup | Body1->getBroadphaseHandle()->m_collisionFilterGroup;
+		if (!(Groups & ContactEventGroups)) continue;
+
+		int Deepest = 0;
+		btScalar Impulse = 0;
+		for (int p = 0; p < NumPoints; p++)
+		{
+			const btManifoldPoint& Point = Manifold->getContactPoint(p);
+			Impulse += Point.getAppliedImpulse();
+			if (Point.getDistance() < Manifold->getContactPoint(Deepest).getDistance()) Deepest = p;
+		}
+		const btManifoldPoint& Point = Manifold->getContactPoint(Deepest);
+
+		// the lower index is A, so a pair has the same key every tick
+		const int32 Key0 = Body0->getWorldArrayIndex();
+		const int32 Key1 = Body1->getWorldArrayIndex();
+		const bool bSwap = Key1 < Key0;
+		ContactPair& Pair = ContactPairs.AddDefaulted_GetRef();
+		Pair.A = bSwap ? Body1 : Body0;
+		Pair.B = bSwap ? Body0 : Body1;
+		Pair.KeyA = bSwap ? Key1 : Key0;
+		Pair.KeyB = bSwap ? Key0 : Key1;
+		Pair.ActorA = static_cast<AActor*>(Pair.A->getUserPointer());
+		Pair.ActorB = static_cast<AActor*>(Pair.B->getUserPointer());
+		Pair.Point = bSwap ? Point.getPositionWorldOnA() : Point.getPositionWorldOnB();
+		Pair.Normal = bSwap ? -Point.m_normalWorldOnB : Point.m_normalWorldOnB;
+		Pair.Impulse = Impulse;
+		Pair.Distance = Point.getDistance();
+	}
+
+	// compounds and meshes can have several manifolds for the same two bodies
+	ContactPairs.Sort(&ContactPairLess);
+	int32 NumPairs = 0;
+	for (int32 i = 0; i < ContactPairs.Num(); i++)
+	{
+		ContactPair& Pair = ContactPairs[i];
+		if (NumPairs > 0 && ContactPairs[NumPairs - 1].KeyA == Pair.KeyA && ContactPairs[NumPairs - 1].KeyB == Pair.KeyB)
+		{
+			ContactPair& Merged = ContactPairs[NumPairs - 1];
+			const btScalar Impulse = Merged.Impulse + Pair.Impulse;
+			if (Pair.Distance < Merged.Distance) Merged = Pair;
+			Merged.Impulse = Impulse;
+			continue;
+		}
+		ContactPairs[NumPairs++] = Pair;
+	}
+	ContactPairs.SetNum(NumPairs, EAllowShrinking::No);
+
+	// both lists are sorted, so one walk over them finds what started, went on and ended
+	const FVector Origin = GetActorLocation();
+	auto Emit = [this, &Origin](EBulletContactPhase Phase, const ContactPair& Pair)
+	{
+		FBulletContactEvent* Event = ContactEventBatch.Add();
+		if (!Event) return;
+		Event->Phase = Phase;
+		Event->ActorA = Pair.ActorA;
+		Event->ActorB = Pair.ActorB;
+		Event->Location = BulletHelpers::ToUEPos(Pair.Point, Origin);
+		Event->Normal = BulletHelpers::ToUEDir(Pair.Normal, false);
+		Event->Impulse = Phase == EBulletContactPhase::End ? 0.f : Pair.Impulse * BULLET_TO_WORLD_SCALE;
+	};
+	int32 Cur = 0;
+	int32 Prev = 0;
+	while (Cur < ContactPairs.Num() || Prev < PreviousContactPairs.Num())
+	{
+		if (Prev == PreviousContactPairs.Num() || (Cur < ContactPairs.Num() && ContactPairLess(ContactPairs[Cur], PreviousContactPairs[Prev])))
+		{
+			Emit(EBulletContactPhase::Begin, ContactPairs[Cur++]);
+		}
+		else if (Cur == ContactPairs.Num() || ContactPairLess(PreviousContactPairs[Prev], ContactPairs[Cur]))
+		{
+			Emit(EBulletContactPhase::End, PreviousContactPairs[Prev++]);
+		}
+		else
+		{
+			if (bContactPersistEvents) Emit(EBulletContactPhase::Persist, ContactPairs[Cur]);
+			Cur++;
+			Prev++;
+		}
+	}
+}
+
+void ATestActor::PublishPhysicsEvents()
+{
+	for (const FBulletProjectileHit& Hit : ProjectileHits)
+	{
+		if (FBulletProjectileHit* Out = ProjectileHitBatch.Add()) *Out = Hit;
+	}
+	ProjectileHitBatch.Publish();
+	GatherContactEvents();
+	ContactEventBatch.Publish();
+}
+
+void ATestActor::DeliverPhysicsEvents()
+{
+	int32 Dropped = 0;
+	for (const FBulletProjectileHit& Hit : ProjectileHitBatch.Take(Dropped))
+	{
+		OnProjectileHit.Broadcast(Hit);
+	}
+	const TArray<FBulletContactEvent>& Events = ContactEventBatch.Take(DroppedContactEvents);
+	if (Events.Num() > 0) OnContactEvents.Broadcast(Events);
+}
+
+void ATestActor::UpdatePoolStats()
+{
+	const btPoolAllocator* Manifolds = BtCollisionConfig->getPersistentManifoldPool();
+	const btPoolAllocator* Algorithms = BtCollisionConfig->getCollisionAlgorithmPool();
+	PoolStats.Manifolds = Manifolds->getUsedCount();
+	PoolStats.PeakManifolds = Manifolds->getPeakUsedCount();
+	PoolStats.ManifoldCapacity = Manifolds->getMaxCount();
+	PoolStats.ManifoldOverflows = Manifolds->getOverflowCount();
+	PoolStats.Algorithms = Algorithms->getUsedCount();
+	PoolStats.PeakAlgorithms = Algorithms->getPeakUsedCount();
+	PoolStats.AlgorithmCapacity = Algorithms->getMaxCount();
+	PoolStats.AlgorithmOverflows = Algorithms->getOverflowCount();
+}
+
+void ATestActor::ConfigureSolver(btContactSolverInfo& SolverInfo, int32 Iterations, float ResidualThreshold)
+{
+	SolverInfo.m_numIterations = FMath::Max(Iterations, 1);
+	SolverInfo.m_leastSquaresResidualThreshold = ResidualThreshold;
+	// solve every island on its own so a resting or free-floating ship stops after one iteration
+	// instead of waiting for whatever it got batched with
+	SolverInfo.m_minimumSolverBatchSize = 1;
+	SolverInfo.m_reportSolverAnalytics |= 1;
+}
+
+void ATestActor::UpdateSolverStats()
+{
+	btAlignedObjectArray<btSolverAnalyticsData> IslandData;
+	BtWorld->getAnalyticsData(IslandData);
+	const int Cap = BtWorld->getSolverInfo().m_numIterations;
+
+	SolverStats = FBulletSolverStats();
+	for (int i = 0; i < IslandData.size(); i++)
+	{
+		const btSolverAnalyticsData& Island = IslandData[i];
+		SolverStats.Islands++;
+		SolverStats.Iterations += Island.m_numIterationsUsed;
+		SolverStats.MaxIterations = FMath::Max(SolverStats.MaxIterations, Island.m_numIterationsUsed);
+		if (Island.m_numIterationsUsed >= Cap && Island.m_remainingLeastSquaresResidual > BtWorld->getSolverInfo().m_leastSquaresResidualThreshold)
+		{
+			SolverStats.IslandsAtCap++;
+		}
+		SolverStats.MaxResidual = FMath::Max(SolverStats.MaxResidual, (float)Island.m_remainingLeastSquaresResidual);
+	}
 }
 
 void ATestActor::SetPhysicsState(int ID, FTransform transforms, FVector Velocity, FVector AngularVelocity, FVector& Force)
 {
 	
-	if (BtRigidBodies[ID]) {
-		BtRigidBodies[ID]->setWorldTransform(BulletHelpers::ToBt(transforms, GetActorLocation()));
-		BtRigidBodies[ID]->setLinearVelocity(BulletHelpers::ToBtPos(Velocity, GetActorLocation()));
-		BtRigidBodies[ID]->setAngularVelocity(BulletHelpers::ToBtPos(AngularVelocity, FVector(0)));
-		//BtRigidBodies[ID]->apply(BulletHelpers::ToBtPos(Velocity, GetActorLocation()));
+	if (btRigidBody* Body = GetBodyById(ID)) {
+		Body->activate();
+		Body->setWorldTransform(BulletHelpers::ToBt(transforms, GetActorLocation()));
+		Body->setLinearVelocity(BulletHelpers::ToBtPos(Velocity, GetActorLocation()));
+		Body->setAngularVelocity(BulletHelpers::ToBtPos(AngularVelocity, FVector(0)));
+		//Body->apply(BulletHelpers::ToBtPos(Velocity, GetActorLocation()));
 	}
 }
 
 void ATestActor::GetPhysicsState(int ID, FTransform& transforms, FVector& Velocity, FVector& AngularVelocity, FVector& Force)
 {
-	if (BtRigidBodies[ID]) {
+	if (btRigidBody* Body = GetBodyById(ID)) {
 		// Debug output
 		UE_LOG(LogTemp, Warning, TEXT("Raw Bullet Velocity: %f,%f,%f"), 
-			BtRigidBodies[ID]->getLinearVelocity().x(),
-			BtRigidBodies[ID]->getLinearVelocity().y(),
-			BtRigidBodies[ID]->getLinearVelocity().z());
-
-		transforms = BulletHelpers::ToUE(BtRigidBodies[ID]->getWorldTransform(), GetActorLocation());
-		Velocity = BulletHelpers::ToUEDir(BtRigidBodies[ID]->getLinearVelocity(), true);
-		AngularVelocity = BulletHelpers::ToUEDir(BtRigidBodies[ID]->getAngularVelocity(), true);
-		Force = BulletHelpers::ToUEDir(BtRigidBodies[ID]->getTotalForce(), true);
+			Body->getLinearVelocity().x(),
+			Body->getLinearVelocity().y(),
+			Body->getLinearVelocity().z());
+
+		transforms = BulletHelpers::ToUE(Body->getWorldTransform(), GetActorLocation());
+		Velocity = BulletHelpers::ToUEDir(Body->getLinearVelocity(), true);
+		AngularVelocity = BulletHelpers::ToUEDir(Body->getAngularVelocity(), true);
+		Force = BulletHelpers::ToUEDir(Body->getTotalForce(), true);
 	}
 }
 
 void ATestActor::ResetSim()
 {
-	
-	for (int i = 0; i < BtRigidBodies.Num(); i++)
+	if (!BtWorld) return;
+	FlushPendingDestroys();
+
+	// Removing the bodies drops their proxies, pairs and manifolds, but the world, broadphase,
+	// dispatcher pools and solver keep their allocations for the next round
+	for (btRigidBody* Body : BtRigidBodies)
 	{
-		BtWorld->removeRigidBody(BtRigidBodies[i]);
-		BtRigidBodies[i]->setActivationState(ACTIVE_TAG);
-		BtRigidBodies[i]->setDeactivationTime(0);
-		BtRigidBodies[i]->clearForces();
+		BtWorld->removeRigidBody(Body);
+		Body->forceActivationState(bAllowSleeping ? ACTIVE_TAG : DISABLE_DEACTIVATION);
+		Body->setDeactivationTime(0);
+		Body->clearForces();
 	}
-	
-	BtWorld = new btDiscreteDynamicsWorld(BtCollisionDispatcher, BtBroadphase, BtConstraintSolver, BtCollisionConfig);
-	BtWorld->setGravity(btVector3(0, 0, 0));
+
 	BtBroadphase->resetPool(BtCollisionDispatcher);
 	BtConstraintSolver->reset();
-	for (int i = 0; i < BtRigidBodies.Num(); i++)
+	for (btSequentialImpulseConstraintSolver* Solver : BtSolvers)
+	{
+		Solver->setRandSeed(1234);
+	}
+	for (btRigidBody* Body : BtRigidBodies)
+	{
+		AddBodyToWorld(Body);
+	}
+}
+
+btBroadphaseInterface* ATestActor::CreateBroadphase(EBulletBroadphase Type, float HalfExtent, bool bParallelPairs)
+{
+	switch (Type)
+	{
+	case EBulletBroadphase::AxisSweep:
+	{
+		const btScalar Extent = BulletHelpers::ToBtSize(HalfExtent);
+		// the 32-bit version, the 16-bit one runs out of precision over a level-sized box
+		return new bt32BitAxisSweep3(btVector3(-Extent, -Extent, -Extent), btVector3(Extent, Extent, Extent), 65536);
+	}
+	case EBulletBroadphase::Sap:
+		// statics go to a set of their own that's only sorted again when one of them changes
+		return new btSapBroadphase(1 << (int32)EBulletCollisionLayer::Static);
+	default:
 	{
-		BtWorld->addRigidBody(BtRigidBodies[i]);
+		btDbvtBroadphase* Dbvt = new btDbvtBroadphase();
+		Dbvt->setParallelCollide(bParallelPairs);
+		return Dbvt;
+	}
+	}
+}
+
+btSequentialImpulseConstraintSolver* ATestActor::CreateSolver() const
+{
+	btSequentialImpulseConstraintSolver* Solver;
+	if (bWideContactSolver)
+	{
+		Solver = new btSequentialImpulseConstraintSolverWide;
+	}
+	else
+	{
+		Solver = new btSequentialImpulseConstraintSolver;
+	}
+	Solver->setRandSeed(1234);
+	PinSolverRows(Solver);
+	return Solver;
+}
+
+void ATestActor::PinSolverRows(btSequentialImpulseConstraintSolver* Solver)
+{
+#ifdef USE_SIMD
+	// Bullet picks the SSE4.1/FMA3 rows at runtime when the CPU has them, which rounds differently.
+	// Always use the SSE2 rows so every client and the server solve contacts the same way.
+	Solver->setConstraintRowSolverGeneric(Solver->getSSE2ConstraintRowSolverGeneric());
+	Solver->setConstraintRowSolverLowerLimit(Solver->getSSE2ConstraintRowSolverLowerLimit());
+#endif
+}
+
+int32 ATestActor::RunDeterminismProbe(int32 Steps, bool bWideSolver)
+{
+	btDefaultCollisionConfiguration Config;
+	btCollisionDispatcher Dispatcher(&Config);
+	btDbvtBroadphase Broadphase;
+	btSequentialImpulseConstraintSolver RowSolver;
+	btSequentialImpulseConstraintSolverWide WideSolver;
+	btSequentialImpulseConstraintSolver& Solver = bWideSolver ? WideSolver : RowSolver;
+	// the lattice is small, batch it anyway so the wide kernels actually run
+	WideSolver.m_minBatchedRows = 0;
+	Solver.setRandSeed(1234);
+	PinSolverRows(&Solver);
+	btDiscreteDynamicsWorld World(&Dispatcher, &Broadphase, &Solver, &Config);
+	World.setGravity(btVector3(0, 0, 0));
+	// same early-out as the game so a threshold comparison that goes the other way shows up too
+	const ATestActor* Defaults = GetDefault<ATestActor>();
+	ConfigureSolver(World.getSolverInfo(), Defaults->SolverIterations, Defaults->SolverResidualThreshold);
+	World.getDispatchInfo().m_enableSatConvex = Defaults->bHullSatContacts;
+
+	btBoxShape Box(btVector3(0.5, 0.5, 0.5));
+	btSphereShape Sphere(0.6);
+	btCapsuleShape Capsule(0.4, 1.0);
+	btConvexHullShape Hull;
+	for (int i = 0; i < 8; i++)
+	{
+		Hull.addPoint(btVector3(i & 1 ? 0.7 : -0.7, i & 2 ? 0.5 : -0.5, i & 4 ? 0.9 : -0.9), false);
+	}
+	Hull.recalcLocalAabb();
+	Hull.initializePolyhedralFeatures();
+	btCollisionShape* Shapes[] = {&Box, &Sphere, &Capsule, &Hull};
+
+	// a lattice of mixed shapes thrown at each other and spinning, so every shape pair and the solver get exercised
+	TArray<btRigidBody*> Bodies;
+	for (int x = 0; x < 4; x++)
+	{
+		for (int y = 0; y < 4; y++)
+		{
+			for (int z = 0; z < 4; z++)
+			{
+				btCollisionShape* Shape = Shapes[(x + y + z) % 4];
+				btVector3 Inertia(0, 0, 0);
+				Shape->calculateLocalInertia(1, Inertia);
+				btRigidBody::btRigidBodyConstructionInfo Info(1, nullptr, Shape, Inertia);
+				Info.m_startWorldTransform.setOrigin(btVector3(x * 2.5 - 3.75, y * 2.5 - 3.75, z * 2.5 - 3.75));
+				Info.m_startWorldTransform.setRotation(btQuaternion(btVector3(x + 1, y + 1, z + 1).normalized(), 0.3 * (x + y * 4 + z * 16)));
+				Info.m_friction = 0.6;
+				Info.m_restitution = 0.2;
+				btRigidBody* Body = new btRigidBody(Info);
+				Body->setLinearVelocity(-Info.m_startWorldTransform.getOrigin() * 0.8);
+				Body->setAngularVelocity(btVector3(z - 1.5, x - 1.5, y - 1.5));
+				Body->setActivationState(DISABLE_DEACTIVATION);
+				World.addRigidBody(Body);
+				Bodies.Add(Body);
+			}
+		}
+	}
+
+	for (int i = 0; i < Steps; i++)
+	{
+		World.stepSimulation(1. / 60, 0, 1. / 60);
+	}
+
+	// hash the raw Bullet floats, any rounding difference between builds changes it
+	uint32 Hash = 0;
+	for (btRigidBody* Body : Bodies)
+	{
+		const btTransform& T = Body->getWorldTransform();
+		btScalar State[18];
+		for (int r = 0; r < 3; r++)
+		{
+			for (int c = 0; c < 3; c++)
+			{
+				State[r * 3 + c] = T.getBasis()[r][c];
+			}
+			State[9 + r] = T.getOrigin()[r];
+			State[12 + r] = Body->getLinearVelocity()[r];
+			State[15 + r] = Body->getAngularVelocity()[r];
+		}
+		Hash = FCrc::MemCrc32(State, sizeof(State), Hash);
+	}
+
+	for (btRigidBody* Body : Bodies)
+	{
+		World.removeRigidBody(Body);
+		delete Body;
+	}
+
+#if defined(BT_USE_SSE_IN_API)
+	const TCHAR* MathPath = TEXT("SSE (in API)");
+#elif defined(BT_USE_SSE)
+	const TCHAR* MathPath = TEXT("SSE");
+#else
+	const TCHAR* MathPath = TEXT("scalar");
+#endif
+	const int32 Width = bWideSolver ? WideSolver.getSimdWidth() : 1;
+	// the hash has to match whatever kernel ran the bundles
+	const TCHAR* KernelNames[] = {TEXT("scalar"), TEXT("SSE2"), TEXT("AVX2")};
+	const TCHAR* Kernel = bWideSolver ? KernelNames[WideSolver.getWideKernel()] : TEXT("rows");
+	UE_LOG(LogTemp, Log, TEXT("Bullet determinism probe: %s %s math, solver width %d (%s), %d steps, hash %08x"), ANSI_TO_TCHAR(FPlatformProperties::IniPlatformName()), MathPath, Width, Kernel, Steps, Hash);
+	return (int32)Hash;
+}
+
+void ATestActor::RunBroadphaseBenchmark(int32 Steps)
+{
+	Steps = FMath::Max(Steps, 1);
+	const TCHAR* SceneNames[] = {TEXT("projectile arena"), TEXT("fleet"), TEXT("static field")};
+	const TCHAR* VariantNames[] = {TEXT("Dbvt"), TEXT("Dbvt parallel"), TEXT("AxisSweep"), TEXT("Sap")};
+	const EBulletBroadphase VariantTypes[] = {EBulletBroadphase::Dbvt, EBulletBroadphase::Dbvt, EBulletBroadphase::AxisSweep, EBulletBroadphase::Sap};
+	const int32 StaticGroup = 1 << (int32)EBulletCollisionLayer::Static;
+	const int32 ShipGroup = 1 << (int32)EBulletCollisionLayer::Ship;
+	const int32 ProjectileGroup = 1 << (int32)EBulletCollisionLayer::Projectile;
+
+	btSphereShape Shot(0.1);
+	btBoxShape Ship(btVector3(3, 1.5, 6));
+	btBoxShape Rock(btVector3(4, 4, 4));
+
+	for (int32 Scene = 0; Scene < 3; Scene++)
+	{
+		// meters, same counts for every broadphase so only the broadphase changes
+		const float Arena = Scene == 1 ? 400.f : 150.f;
+		const int32 NumShots = Scene == 0 ? 1500 : Scene == 1 ? 0 : 500;
+		const int32 NumShips = Scene == 0 ? 60 : Scene == 1 ? 400 : 200;
+		const int32 NumRocks = Scene == 2 ? 6000 : Scene == 0 ? 200 : 0;
+
+		for (int32 Variant = 0; Variant < 4; Variant++)
+		{
+			btDefaultCollisionConfiguration Config;
+			btCollisionDispatcher Dispatcher(&Config);
+			btBroadphaseInterface* Broadphase = CreateBroadphase(VariantTypes[Variant], 2 * Arena * BULLET_TO_WORLD_SCALE, Variant == 1);
+			btCollisionWorld World(&Dispatcher, Broadphase, &Config);
+			World.setForceUpdateAllAabbs(false);
+
+			FRandomStream Random(4242);
+			auto RandomPoint = [&Random]() { return btVector3(Random.FRandRange(-1, 1), Random.FRandRange(-1, 1), Random.FRandRange(-1, 1)); };
+			TArray<btCollisionObject*> Objects;
+			TArray<btVector3> Velocities;
+			auto AddObject = [&](btCollisionShape* Shape, const btVector3& Pos, int32 Group, int32 Mask, bool bStatic)
+			{
+				btCollisionObject* Object = new btCollisionObject();
+				Object->setCollisionFlags(bStatic ? btCollisionObject::CF_STATIC_OBJECT : 0);
+				Object->setCollisionShape(Shape);
+				Object->setWorldTransform(btTransform(btQuaternion::getIdentity(), Pos));
+				if (!bStatic)
+				{
+					Object->setActivationState(DISABLE_DEACTIVATION);
+				}
+				World.addCollisionObject(Object, Group, Mask);
+				Objects.Add(Object);
+			};
+			for (int32 i = 0; i < NumRocks; i++)
+			{
+				AddObject(&Rock, RandomPoint() * Arena, StaticGroup, ~StaticGroup, true);
+			}
+			const int32 FirstMover = Objects.Num();
+			for (int32 i = 0; i < NumShips; i++)
+			{
+				// the fleet flies in four tight groups, everywhere else ships are spread out
+				btVector3 Pos = RandomPoint();
+				if (Scene == 1)
+				{
+					Pos = Pos * 0.3f + btVector3((i % 4) * 0.5f - 0.75f, 0, 0);
+				}
+				AddObject(&Ship, Pos * Arena, ShipGroup, -1, false);
+				Velocities.Add(RandomPoint() * 20);
+			}
+			for (int32 i = 0; i < NumShots; i++)
+			{
+				AddObject(&Shot, RandomPoint() * Arena, ProjectileGroup, ~ProjectileGroup, false);
+				Velocities.Add(RandomPoint().safeNormalize() * Random.FRandRange(50, 150));
+			}
+
+			const btScalar Dt = 1.0 / 60.0;
+			double Seconds = 0;
+			for (int32 Step = 0; Step < Steps + 10; Step++)
+			{
+				for (int32 i = FirstMover; i < Objects.Num(); i++)
+				{
+					btVector3& Velocity = Velocities[i - FirstMover];
+					btVector3 Pos = Objects[i]->getWorldTransform().getOrigin() + Velocity * Dt;
+					for (int32 Axis = 0; Axis < 3; Axis++)
+					{
+						if (FMath::Abs(Pos[Axis]) > Arena)
+						{
+							Velocity[Axis] = -Velocity[Axis];
+							Pos[Axis] = btClamped<btScalar>(Pos[Axis], -Arena, Arena);
+						}
+					}
+					Objects[i]->getWorldTransform().setOrigin(Pos);
+				}
+				// first few steps fill the pair cache and warm up the sort
+				const double Start = FPlatformTime::Seconds();
+				World.updateAabbs();
+				Broadphase->calculateOverlappingPairs(&Dispatcher);
+				if (Step >= 10)
+				{
+					Seconds += FPlatformTime::Seconds() - Start;
+				}
+			}
+			const int32 NumPairs = Broadphase->getOverlappingPairCache()->getNumOverlappingPairs();
+			UE_LOG(LogTemp, Log, TEXT("Bullet broadphase benchmark: %s, %d bodies, %s %.3f ms/step, %d pairs"), SceneNames[Scene], Objects.Num(), VariantNames[Variant], Seconds * 1000.0 / Steps, NumPairs);
+
+			for (btCollisionObject* Object : Objects)
+			{
+				World.removeCollisionObject(Object);
+				delete Object;
+			}
+			delete Broadphase;
+		}
 	}
 }
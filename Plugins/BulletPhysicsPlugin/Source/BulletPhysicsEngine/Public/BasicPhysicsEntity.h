@@ -11,6 +11,7 @@ class BULLETPHYSICSENGINE_API ABasicPhysicsEntity : public AActor
 public:
 	ABasicPhysicsEntity();
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	virtual void Tick(float DeltaTime) override;
 	virtual void AsyncPhysicsTickActor(float DeltaTime, float SimTime) override;
 	
@@ -21,6 +22,17 @@ public:
 
 	UPROPERTY(EditDefaultsOnly)
 	UStaticMeshComponent* StaticMesh;
+
+	// Projectile for shots, which then never collide with each other (see ATestActor::IgnoredLayerPairs)
+	UPROPERTY(EditDefaultsOnly)
+	EBulletCollisionLayer CollisionLayer = EBulletCollisionLayer::Default;
+
+	// fast shots: swept against everything every step so they can't pass through thin hulls
+	UPROPERTY(EditDefaultsOnly)
+	bool bProjectileCcd = false;
+	// cm, the sweep uses a sphere of this size instead of the mesh
+	UPROPERTY(EditDefaultsOnly)
+	float ProjectileRadius = 10.f;
 private:
 protected:
 	UPROPERTY(EditDefaultsOnly)
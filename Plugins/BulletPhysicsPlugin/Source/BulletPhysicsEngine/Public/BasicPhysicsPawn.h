@@ -35,9 +35,12 @@ public:
 	
 	virtual void SetupPlayerInputComponent(class UInputComponent* InputComponent) override;
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	virtual void GetLifetimeReplicatedProps(TArray<class FLifetimeProperty>& OutLifetimeProps) const override;
 	virtual void PossessedBy(AController* NewController) override;
 	virtual void UnPossessed() override;
+	virtual void PawnClientRestart() override;
+	virtual void OnRep_Controller() override;
 	
 	FVector CurrentDirectionalInput = FVector(0, 0, 0);
 	bool CurrentPrimaryInput = false;
@@ -54,6 +57,9 @@ public:
 	UPROPERTY(EditAnywhere)
 	ATestActor* BulletWorld = nullptr;
 
+	UPROPERTY(EditDefaultsOnly)
+	EBulletCollisionLayer CollisionLayer = EBulletCollisionLayer::Ship;
+
 	// DEPRECATED MAYBE
 	// this is marked false when the pawn should not send or receive input
 	// i.e. an inactive vehicle or dead player
@@ -62,6 +68,14 @@ public:
 
 	UFUNCTION()
 	virtual void ApplyInputs(const FTWPlayerInput& input); // virtual keyword needs to be present to make a function overridable
+	// wakes the body unless the input is idle, then applies it. Call this instead of ApplyInputs,
+	// forces on a sleeping body are dropped
+	void ApplyInputsAndWake(const FTWPlayerInput& input);
+	// samples the current input for a tick, applies it, keeps it for resims and sends it to the server.
+	// The world calls this on the locally controlled pawn right before it steps that tick
+	void ProduceInput(int32 Tick);
+	// makes this the world's LocalPawn while it is locally controlled, and stops being it when it isn't anymore
+	void UpdateLocalPawn();
 	
 	UFUNCTION(Server, Reliable)
 	void ServerTestSimple();
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ThirdParty/BulletPhysicsEngineLibrary/BulletMinimal.h"
+
+class btCollisionWorld;
+class btConvexHullShape;
+class BulletCookedCollisionImporter;
+
+/**
+ * Pre-cooked Bullet collision shapes for one asset.
+ * Cooking serializes built shapes (plus their polyhedral features, which Bullet doesn't serialize)
+ * with btDefaultSerializer: hulls, BVH triangle meshes with their quantized trees, and compounds. Loading copies
+ * the chunk payloads into one aligned allocation, patches the chunk pointers in place and hands the chunks to
+ * btCollisionWorldImporter, so no hull or tree is rebuilt.
+ * Distance fields aren't Bullet-serializable at all and get a chunk of their own, loaded straight into
+ * a btSdfCollisionShape.
+ * Blobs are only valid for the platform/precision that wrote them.
+ */
+class BULLETPHYSICSENGINE_API BulletCollisionCache
+{
+public:
+	BulletCollisionCache();
+	~BulletCollisionCache();
+
+	// Serialize named shapes into a blob at Path. Hulls should already have polyhedral features.
+	static bool Write(const FString& Path, const TArray<TPair<FString, btCollisionShape*>>& Shapes);
+
+	// Read and fix up a blob written by Write, returns false if missing or from another platform
+	bool Load(const FString& Path, btCollisionWorld* World);
+
+	// Shapes are owned by the cache and live until it is destroyed
+	btCollisionShape* FindShape(const FString& Name) const;
+	// First distance field whose name starts with Prefix, for when the source hash part can't be computed
+	btCollisionShape* FindSdfByPrefix(const FString& Prefix) const;
+
+	// Where the cooked blob for an asset lives; packaged builds need this folder staged as non-asset content
+	static FString GetCookedPath(const UObject* Asset);
+	static FString GetCookedDirectory();
+
+private:
+	BulletCookedCollisionImporter* Importer = nullptr;
+	TMap<FString, btCollisionShape*> SdfShapes;
+};
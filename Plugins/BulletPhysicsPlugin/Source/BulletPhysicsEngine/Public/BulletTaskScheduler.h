@@ -0,0 +1,34 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ThirdParty/BulletPhysicsEngineLibrary/BulletMinimal.h"
+
+THIRD_PARTY_INCLUDES_START
+PRAGMA_PUSH_PLATFORM_DEFAULT_PACKING
+#include <LinearMath/btThreads.h>
+PRAGMA_POP_PLATFORM_DEFAULT_PACKING
+THIRD_PARTY_INCLUDES_END
+
+/**
+ * Runs Bullet's btParallelFor/btParallelSum on the UE task graph instead of Bullet's own thread pool.
+ * A loop is cut into grain sized chunks and up to NumThreads tasks pull the next chunk off a shared counter,
+ * so an idle worker always grabs more work and the biggest islands (Bullet sorts them first) start first.
+ * Sums are added up chunk by chunk in order, so the result doesn't depend on the thread count or timing.
+ * Bullet only allows one scheduler at a time, the module installs this one at startup.
+ */
+class BULLETPHYSICSENGINE_API BulletTaskScheduler : public btITaskScheduler
+{
+public:
+	BulletTaskScheduler();
+
+	static BulletTaskScheduler* Get();
+
+	virtual int getMaxNumThreads() const override;
+	virtual int getNumThreads() const override;
+	virtual void setNumThreads(int numThreads) override;
+	virtual void parallelFor(int iBegin, int iEnd, int grainSize, const btIParallelForBody& body) override;
+	virtual btScalar parallelSum(int iBegin, int iEnd, int grainSize, const btIParallelSumBody& body) override;
+
+private:
+	int NumThreads = 1;
+};
@@ -0,0 +1,76 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "Misc/ScopeLock.h"
+
+/**
+ * Hands events from the physics thread to the game thread in batches.
+ * The physics thread fills the staging array during a tick and publishes it at the end,
+ * the game thread takes everything published since its last call in one go.
+ * The three arrays are reserved once and only swapped afterwards, events past the capacity are dropped and counted.
+ */
+template<typename T>
+class TWEventBatch
+{
+public:
+    void Reserve(int32 InCapacity)
+    {
+        Capacity = FMath::Max(InCapacity, 1);
+        Staging.Reserve(Capacity);
+        FScopeLock Lock(&Mutex);
+        Pending.Reserve(Capacity);
+        Delivered.Reserve(Capacity);
+    }
+
+    /** Physics thread: slot for one more event, or null once this tick's batch is full */
+    T* Add()
+    {
+        if (Staging.Num() >= Capacity)
+        {
+            StagingDropped++;
+            return nullptr;
+        }
+        return &Staging.AddDefaulted_GetRef();
+    }
+
+    /** Physics thread: makes this tick's events visible to Take and starts a new batch */
+    void Publish()
+    {
+        FScopeLock Lock(&Mutex);
+        if (Pending.IsEmpty())
+        {
+            Swap(Staging, Pending);
+        }
+        else
+        {
+            // the game thread hasn't picked up the last tick yet, keep whatever still fits
+            const int32 NumFit = FMath::Min(Staging.Num(), Capacity - Pending.Num());
+            Pending.Append(Staging.GetData(), NumFit);
+            StagingDropped += Staging.Num() - NumFit;
+        }
+        Dropped += StagingDropped;
+        StagingDropped = 0;
+        Staging.Reset();
+    }
+
+    /** Game thread: the events published since the last call, valid until the next one */
+    const TArray<T>& Take(int32& OutDropped)
+    {
+        Delivered.Reset();
+        FScopeLock Lock(&Mutex);
+        Swap(Pending, Delivered);
+        OutDropped = Dropped;
+        Dropped = 0;
+        return Delivered;
+    }
+
+private:
+    TArray<T> Staging;
+    TArray<T> Pending;
+    TArray<T> Delivered;
+    int32 Capacity = 1;
+    int32 StagingDropped = 0;
+    int32 Dropped = 0;
+    FCriticalSection Mutex;
+};
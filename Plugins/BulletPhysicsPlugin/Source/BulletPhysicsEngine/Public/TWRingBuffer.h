@@ -42,6 +42,24 @@ public:
         if (Size < Capacity) { Size++; }
     }
 
+    /**
+     * Push by filling the new slot in place. The slot still holds the item it evicts (or a default one),
+     * so arrays inside it keep their allocations. The reference is valid until the next push.
+     */
+    T& PushInPlace()
+    {
+        if (Buffer.Num() <= Head)
+        {
+            Buffer.AddDefaulted(1);
+        }
+
+        T& Slot = Buffer[Head];
+        Head = (Head + 1) % Capacity;
+
+        if (Size < Capacity) { Size++; }
+        return Slot;
+    }
+
     /** Get item at position (0 is most recent, 1 is one before that, etc.) */
     T Get(int32 Position) const
     {
@@ -67,6 +85,39 @@ public:
         return Buffer[Index];
     }
 
+    /** The item at position in place (0 is most recent), nullptr if there is none. Valid until the next push */
+    T* GetSlot(int32 Position)
+    {
+        if (Position >= Size || Position < 0 || Buffer.Num() == 0)
+        {
+            return nullptr;
+        }
+
+        int32 Index = (Head - 1 - Position);
+        if (Index < 0)
+        {
+            Index += Capacity;
+        }
+        return Index < Buffer.Num() ? &Buffer[Index] : nullptr;
+    }
+
+    /** Overwrite the item at position (0 is most recent), e.g. with a corrected frame after a resim */
+    void Set(int32 Position, const T& Item)
+    {
+        if (Position >= Size || Position < 0 || Buffer.Num() == 0)
+        {
+            UE_LOG(LogTemp, Error, TEXT("TWRingBuffer::Set: Invalid Position"));
+            return;
+        }
+
+        int32 Index = (Head - 1 - Position);
+        if (Index < 0)
+        {
+            Index += Capacity;
+        }
+        Buffer[Index] = Item;
+    }
+
     /** Get the oldest item in the buffer */
     T GetOldest() const
     {
@@ -25,8 +25,13 @@ class ABasicPhysicsPawn; // forward declaration
 #include "GameFramework/PlayerState.h"
 #include "GameFramework/GameState.h"
 #include "TWRingBuffer.h"
+#include "TWEventBatch.h"
+#include "BulletCollisionCache.h"
 #include "TestActor.generated.h"
 
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnBulletProjectileHit, const FBulletProjectileHit&, Hit);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnBulletContactEvents, const TArray<FBulletContactEvent>&, Events);
+
 UCLASS()
 class BULLETPHYSICSENGINE_API ATestActor : public AActor
 {
@@ -54,20 +59,95 @@ This has been an absolutely wild ride and I'm beyond hyped this finally works. O
 I'll post some more progress, a guide to the codebase, etc etc onboarding/learning stuff for whoever wants to help develop this.
 */
 
+	// the state the server last sent, in UE units. Clients keep theirs in StateHistory instead
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	FBulletSimulationState LocalState;
 
-	// Server-only state buffer
-	// UPROPERTY(EditAnywhere, BlueprintReadWrite)
-	TWRingBuffer<FBulletSimulationState> StateHistory;
+	// Every dynamic body at the end of a tick, in Bullet units and BtRigidBodies order. Captured straight from
+	// the bodies with no conversion; only what goes over the network or to Blueprint is turned into UE units.
+	struct BodySnapshot
+	{
+		btTransform Transform;
+		btVector3 LinearVelocity;
+		btVector3 AngularVelocity;
+		btScalar DeactivationTime;
+		int32 ActivationState;
+		btRigidBody* Body;
+		// null while the body waits in PendingDestroyBodies
+		AActor* Actor;
+	};
+	struct StateSnapshot
+	{
+		TArray<BodySnapshot> Bodies;
+		// the tick that starts from this state
+		int32 Tick = 0;
+	};
+	// Client state buffer, filled in place so each slot's array is reused once the ring has wrapped
+	TWRingBuffer<StateSnapshot> StateHistory;
+	// server's capture for the tick being sent
+	StateSnapshot ServerSnapshot;
+	void CaptureState(StateSnapshot& Snapshot) const;
+	static void ToUEState(const StateSnapshot& Snapshot, FBulletSimulationState& State);
+	// Contact points of every manifold at the end of a tick, pushed next to StateHistory. Rewinding restores them
+	// so the resimulated frames warm start (applied impulses, friction directions) like the original frames did.
+	// Looked up by tick: SyncTicks can move ticker without a push, so ring positions don't map to ticks.
+	struct ContactSnapshot
+	{
+		struct Manifold
+		{
+			const btCollisionObject* Body0;
+			const btCollisionObject* Body1;
+			// child shape on each side for compounds (one manifold per child pair), -1 otherwise
+			int32 Child0;
+			int32 Child1;
+			int32 FirstPoint;
+			int32 NumPoints;
+		};
+		TArray<Manifold> Manifolds;
+		TArray<btManifoldPoint> Points;
+		// the tick these contacts go into, i.e. ticker right after the step that made them
+		int32 Tick = 0;
+	};
+	// filled in place like StateHistory, so the arrays of each slot are reused once the ring has wrapped
+	TWRingBuffer<ContactSnapshot> ContactHistory = TWRingBuffer<ContactSnapshot>(64);
+	// newest snapshot for the tick, ticks repeat after SyncTicks snaps back. nullptr if there is none
+	ContactSnapshot* FindContactsForTick(int32 Tick);
+	void SaveContacts(ContactSnapshot& Snapshot) const;
+	void RestoreContacts(const ContactSnapshot& Snapshot);
 	
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
-	ABasicPhysicsPawn* LocalPawn; // this is set on PossessedBy
+	ABasicPhysicsPawn* LocalPawn; // the locally controlled pawn, see ABasicPhysicsPawn::UpdateLocalPawn
 	
-	// non-replicated number, incremented every tick
-	// e.g. for only resimulating every x ticks
+	// the next tick to simulate. Clients number their ticks like the server and run ahead of it, see SyncTicks
 	int ticker;
 
+	// ticks a client's input should reach the server before the tick that uses it
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Bullet Physics|Tick Sync")
+	int32 TargetInputLead = 2;
+	// most a client ticks faster or slower than real time to hold the lead, 0.05 = 5%
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Bullet Physics|Tick Sync")
+	float MaxTickRateAdjust = 0.05f;
+	// tick rate change per tick of lead error
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Bullet Physics|Tick Sync")
+	float TickRateGain = 0.01f;
+	// lead errors past this many ticks jump the tick count instead of drifting there
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Bullet Physics|Tick Sync")
+	int32 TickSnapThreshold = 16;
+	// client's current tick rate relative to real time
+	UPROPERTY(BlueprintReadOnly, Category = "Bullet Physics|Tick Sync")
+	float TickRate = 1.f;
+	// ticks owed to the client's accumulator, starts half way so a tick rate of 1 steps once per physics tick
+	double TickBudget = 0.5;
+	bool bTicksSynced = false;
+	// slack reports of inputs sent before the last jump are stale
+	int32 IgnoreSlackBeforeTick = 0;
+	float SmoothedLeadError = 0;
+	// server: fewest ticks each client's inputs arrived early by since the last snapshot, negative when late
+	TMap<AActor*, int32> InputSlack;
+	void SimulateTick();
+	// client: line the tick count up with a snapshot and steer the tick rate so inputs arrive TargetInputLead early
+	void SyncTicks(int32 ServerTick, int32 Slack);
+
 	// Frames
 	// UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	// int32 CurrentFrameNumber = 0;	// Global current frame number
@@ -93,28 +173,10 @@ I'll post some more progress, a guide to the codebase, etc etc onboarding/learni
 
 	UFUNCTION()
 	void SendInputToServer(AActor* actor, FTWPlayerInput input);
-	void Resim(FBulletSimulationState ServerState);
+	void Resim(const FBulletSimulationState& ServerState);
 
 	UFUNCTION(BlueprintCallable)
-	FBulletSimulationState GetCurrentState()
-	{
-		FBulletSimulationState thisState;
-		// thisState.FrameNumber = CurrentFrameNumber;
-		thisState.CurrentTime = FPlatformTime::Seconds();
-		// construct and add all object states
-		for (const auto& tuple : BodyToActor)
-		{
-			FBulletObjectState os;
-			btRigidBody* body = tuple.Key;
-			os.Actor = tuple.Value;
-			os.Transform = BulletHelpers::ToUE(body->getWorldTransform(), {0,0,0});
-			os.Velocity = BulletHelpers::ToUEDir(body->getLinearVelocity(), true);
-			os.AngularVelocity = BulletHelpers::ToUEDir(body->getAngularVelocity(), true);
-	
-			thisState.ObjectStates.Add(os);
-		}
-		return thisState;
-	}
+	FBulletSimulationState GetCurrentState();
 
 	FBulletObjectState GetObjectState(btRigidBody* body)
 	{
@@ -122,6 +184,8 @@ I'll post some more progress, a guide to the codebase, etc etc onboarding/learni
 		os.Transform = BulletHelpers::ToUE(body->getWorldTransform(), {0,0,0});
 		os.Velocity = BulletHelpers::ToUEDir(body->getLinearVelocity(), true);
 		os.AngularVelocity = BulletHelpers::ToUEDir(body->getAngularVelocity(), true);
+		os.ActivationState = body->getActivationState();
+		os.DeactivationTime = body->getDeactivationTime();
 		os.Actor = BodyToActor[body];
 
 		return os;
@@ -162,18 +226,30 @@ I'll post some more progress, a guide to the codebase, etc etc onboarding/learni
 		state.Transform = BulletHelpers::ToUE(body->getWorldTransform(), GetActorLocation());
 		state.Velocity = BulletHelpers::ToUEDir(body->getLinearVelocity(), true);
 		state.AngularVelocity = BulletHelpers::ToUEDir(body->getAngularVelocity(), true);
+		state.ActivationState = body->getActivationState();
+		state.DeactivationTime = body->getDeactivationTime();
 		return state;
 	}
 	void SetBodyState(btRigidBody* body, const FBulletObjectState& state) const
 	{
-		body->setWorldTransform(BulletHelpers::ToBt(state.Transform, GetActorLocation()));
+		// setCenterOfMassTransform also resets the interpolation transform and the world inertia tensor,
+		// with setWorldTransform alone the first step after a rewind would still use the newest frame's
+		body->setCenterOfMassTransform(BulletHelpers::ToBt(state.Transform, GetActorLocation()));
 		body->setLinearVelocity(BulletHelpers::ToBtDir(state.Velocity, true));
 		body->setAngularVelocity(BulletHelpers::ToBtDir(state.AngularVelocity, true));
+		body->setInterpolationLinearVelocity(body->getLinearVelocity());
+		body->setInterpolationAngularVelocity(body->getAngularVelocity());
+		// forced, setActivationState won't let a body out of DISABLE_DEACTIVATION or back to sleep on its own
+		body->forceActivationState(state.ActivationState);
+		body->setDeactivationTime(state.DeactivationTime);
+		// updateAabbs skips sleeping bodies, one that is put back to sleep somewhere else needs its box moved here
+		BtWorld->updateSingleAabb(body);
 	}
 	
 	// send state and actors' last input
+	// and how early each actor's inputs arrive (InputSlack)
 	UFUNCTION(BlueprintCallable, NetMulticast, Unreliable)
-	void MC_SendStateToClients(FBulletSimulationState ServerState, const TArray<AActor*>& PlayerInputs, const TArray<FTWPlayerInput>& PlayerInputss);
+	void MC_SendStateToClients(const FBulletSimulationState& ServerState, const TArray<AActor*>& PlayerInputs, const TArray<FTWPlayerInput>& PlayerInputss, const TArray<int32>& InputSlacks);
 
 	UFUNCTION(Server, Reliable)
 	void shootThing(TSubclassOf<ABasicPhysicsEntity> projectileClass, FRotator direction, FVector inheritedVelocity, FVector location, AActor* owner2);
@@ -182,6 +258,7 @@ I'll post some more progress, a guide to the codebase, etc etc onboarding/learni
 	btCollisionConfiguration* BtCollisionConfig;
 	btCollisionDispatcher* BtCollisionDispatcher;
 	btBroadphaseInterface* BtBroadphase;
+	btOverlapFilterCallback* BtOverlapFilter;
 	btConstraintSolver* BtConstraintSolver;
 	btDiscreteDynamicsWorld* BtWorld;
 	BulletHelpers* BulletHelpers;
@@ -190,28 +267,299 @@ I'll post some more progress, a guide to the codebase, etc etc onboarding/learni
 	// Custom debug interface
 	btIDebugDraw* BtDebugDraw;
 	// Dynamic bodies
+	// Dense array, each body's slot is stored in its user index so removal is an O(1) swap
 	TArray<btRigidBody*> BtRigidBodies;
+	// The int IDs Blueprint uses, stored in each body's user index 3. An ID stays with its body for the body's
+	// whole life, freed IDs are null here until FreeBodyIds hands them to a new body
+	TArray<btRigidBody*> BodiesById;
+	TArray<int32> FreeBodyIds;
+	// Bodies waiting to be removed and freed outside of the step
+	TArray<btRigidBody*> PendingDestroyBodies;
 	// Static colliders
 	TArray<btCollisionObject*> BtStaticObjects;
-	btCollisionObject* procbody;
+	// Procedural triangle-mesh colliders, one per actor. The vertex/index storage is owned here and
+	// referenced in place by the mesh interface, so updates only move vertices and refit the BVH.
+	struct ProcMeshCollider
+	{
+		btAlignedObjectArray<btVector3> Vertices;
+		btAlignedObjectArray<int> Indices;
+		btTriangleIndexVertexArray* MeshInterface = nullptr;
+		btBvhTriangleMeshShape* Shape = nullptr;
+		btCollisionObject* Object = nullptr;
+		// quantization bounds the BVH was built with; refits must stay inside them
+		btVector3 BvhAabbMin;
+		btVector3 BvhAabbMax;
+		// our copy of a cooked tree, the shape doesn't own it and refits write into it
+		btOptimizedBvh* CookedBvh = nullptr;
+	};
+	TMap<AActor*, ProcMeshCollider*> ProcBodies;
+	// how far (in UE units) a procedural mesh may deform past its original bounds before a full rebuild
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Bullet Physics|Objects")
+	float ProcMeshBoundsSlack = 500.f;
+	// Heightfield terrain, one per actor. btHeightfieldTerrainShape reads the samples in place, no triangles or BVH,
+	// either from the caller's buffer or from the copy kept here. Sample (0,0) sits at the actor's origin, rows run along Y.
+	struct HeightfieldCollider
+	{
+		// owned samples when the heights came in through Blueprint, empty when the caller keeps the buffer
+		TArray<float> Heights;
+		TArray<uint16> QuantizedHeights;
+		const void* Samples = nullptr;
+		bool bQuantized = false;
+		int32 SizeX = 0;
+		int32 SizeY = 0;
+		// UE units, height = sample * HeightScale + HeightOffset
+		float SampleSpacing = 100.f;
+		float HeightScale = 1.f;
+		float HeightOffset = 0.f;
+		// range of sample * HeightScale the shape was built for, float samples edited past it rebuild the shape
+		float MinHeight = 0.f;
+		float MaxHeight = 0.f;
+		btHeightfieldTerrainShape* Shape = nullptr;
+		btCollisionObject* Object = nullptr;
+	};
+	TMap<AActor*, HeightfieldCollider*> HeightfieldBodies;
+	// height range (in UE units) added above and below a heightfield's samples, so edits rarely rebuild the shape
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Bullet Physics|Objects")
+	float HeightfieldHeightSlack = 1000.f;
+	// Streamed static geometry. Static colliders are bucketed into cubic cells; a cell is only in the
+	// world while a dynamic body is nearby. Each cell is baked into one compound per actor and material
+	// off-thread, and goes into the world StaticChunkBuildDelay ticks after it was asked for.
+	struct StaticChunkEntry
+	{
+		btCollisionShape* Shape;
+		btTransform Transform;
+	};
+	struct StaticChunkBatch
+	{
+		AActor* Actor = nullptr;
+		float Friction;
+		float Restitution;
+		TArray<StaticChunkEntry> Entries;
+		btCompoundShape* Shape = nullptr;
+		btCollisionObject* Object = nullptr;
+		TFuture<btCompoundShape*> PendingShape;
+	};
+	struct StaticChunk
+	{
+		TArray<StaticChunkBatch> Batches;
+		bool bLoaded = false;
+		// a loaded chunk that isn't in the world yet goes in on AddTick
+		bool bInWorld = false;
+		int32 AddTick = 0;
+	};
+	TMap<FIntVector, StaticChunk*> StaticChunks;
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Bullet Physics|Streaming")
+	bool bStreamStaticGeometry = false;
+	// edge length of a cell in UE units; shapes bigger than a cell are never streamed
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Bullet Physics|Streaming")
+	float StaticChunkSize = 20000.f;
+	// cells within this many cells of a dynamic body are loaded, cells one further out are kept
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Bullet Physics|Streaming")
+	int32 StaticChunkLoadRadius = 1;
+	// how often (in ticks) the set of loaded cells is re-evaluated
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Bullet Physics|Streaming")
+	int32 StaticChunkUpdateInterval = 10;
+	// ticks between a cell being wanted and its colliders entering the world. Fixed so the server and every client add
+	// them on the same tick; a build that isn't done by then is waited for
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Bullet Physics|Streaming")
+	int32 StaticChunkBuildDelay = 4;
 	// Re-usable collision shapes
 	TArray<btBoxShape*> BtBoxCollisionShapes;
 	TArray<btSphereShape*> BtSphereCollisionShapes;
 	TArray<btCapsuleShape*> BtCapsuleCollisionShapes;
 	btSequentialImpulseConstraintSolver* mt;
+	// every solver the world uses (one, or one per thread in the pool), owned by BtConstraintSolver
+	TArray<btSequentialImpulseConstraintSolver*> BtSolvers;
+	// solve contacts and friction 8 rows at a time (AVX2, or two SSE2 halves), same result on every CPU.
+	// Off by default: the iterations are faster but building the bundles costs about as much, so it only
+	// pays off for big piles or many iterations. Server and clients have to agree on this, it changes the
+	// simulation compared to the row-by-row solver.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Bullet Physics|Solver")
+	bool bWideContactSolver = false;
+	// solve islands in parallel on the task graph (btDiscreteDynamicsWorldMt), largest first. Islands with fewer than
+	// IslandBatchMinBodies bodies are solved together as one batch, which changes the result compared to the serial
+	// world, so server and clients have to agree on both. The thread count doesn't change anything.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Bullet Physics|Solver")
+	bool bParallelIslands = true;
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Bullet Physics|Solver")
+	int32 IslandBatchMinBodies = 32;
+	btSequentialImpulseConstraintSolver* CreateSolver() const;
+	// Contact manifolds and collision algorithms come from pools that grow by a quarter of their size when used up,
+	// so pair spikes don't hit the heap in the narrowphase. Set these to the peaks in PoolStats to never grow at all.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Bullet Physics|Memory")
+	int32 ManifoldPoolSize = 4096;
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Bullet Physics|Memory")
+	int32 CollisionAlgorithmPoolSize = 4096;
+	UPROPERTY(BlueprintReadOnly, Category = "Bullet Physics|Memory")
+	FBulletPoolStats PoolStats;
+	void UpdatePoolStats();
+	// Bodies that stay below both velocities for SleepDelay seconds (with everything they touch) go to sleep: they
+	// are no longer integrated or solved until a contact with an awake body, input or an Add* call wakes them.
+	// Sleep state is part of every snapshot, server and clients have to use the same values.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Bullet Physics|Sleeping")
+	bool bAllowSleeping = true;
+	// cm/s, low because there is no gravity: anything slower is stopped dead when it falls asleep
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Bullet Physics|Sleeping")
+	float SleepLinearVelocity = 5.f;
+	// rad/s
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Bullet Physics|Sleeping")
+	float SleepAngularVelocity = 0.05f;
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Bullet Physics|Sleeping")
+	float SleepDelay = 2.f;
+	UPROPERTY(BlueprintReadOnly, Category = "Bullet Physics|Broadphase")
+	FBulletBroadphaseStats BroadphaseStats;
+	// Server and clients have to use the same one, each finds pairs in its own order and that changes the solve order
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Bullet Physics|Broadphase")
+	EBulletBroadphase BroadphaseType = EBulletBroadphase::Dbvt;
+	// cm, AxisSweep only: everything has to stay within this distance of the actor on each axis
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Bullet Physics|Broadphase")
+	float BroadphaseHalfExtent = 1000000.f;
+	// Dbvt only: find pairs on worker threads once per step instead of one moved body at a time. Also changes the pair order,
+	// so server and clients have to agree on this one too
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Bullet Physics|Broadphase")
+	bool bParallelPairFinding = true;
+	static btBroadphaseInterface* CreateBroadphase(EBulletBroadphase Type, float HalfExtent, bool bParallelPairs);
+	// Projectile bodies skip the regular integration: each step all of them sweep a sphere along their motion in one
+	// batched broadphase query and stop at the first thing they would pass through. Hits of the real steps (not of
+	// resims) are broadcast on the game thread.
+	UPROPERTY(BlueprintAssignable, Category = "Bullet Physics|Projectiles")
+	FOnBulletProjectileHit OnProjectileHit;
+	TArray<FBulletProjectileHit> ProjectileHits;
+	TWEventBatch<FBulletProjectileHit> ProjectileHitBatch;
+	// After every real step (not resims) the manifolds are walked once and each touching pair of bodies becomes a
+	// Begin, Persist or End event. The game thread gets everything since its last frame in one OnContactEvents call.
+	UPROPERTY(BlueprintAssignable, Category = "Bullet Physics|Contacts")
+	FOnBulletContactEvents OnContactEvents;
+	// only pairs where one of the bodies is in one of these layers are reported
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Bullet Physics|Contacts", meta = (Bitmask, BitmaskEnum = "/Script/BulletPhysicsEngine.EBulletCollisionLayer"))
+	int32 ContactEventGroups = -1;
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Bullet Physics|Contacts")
+	bool bContactPersistEvents = true;
+	// events per frame, the buffers are allocated once with this size and anything past it is dropped
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Bullet Physics|Contacts")
+	int32 ContactEventCapacity = 1024;
+	UPROPERTY(BlueprintReadOnly, Category = "Bullet Physics|Contacts")
+	int32 DroppedContactEvents = 0;
+	struct ContactPair
+	{
+		const btCollisionObject* A;
+		const btCollisionObject* B;
+		AActor* ActorA;
+		AActor* ActorB;
+		btVector3 Point;
+		btVector3 Normal;
+		btScalar Impulse;
+		btScalar Distance;
+		// world array indices of A and B, A has the lower one
+		int32 KeyA;
+		int32 KeyB;
+	};
+	// touching pairs of this and the last real step, sorted by (KeyA, KeyB)
+	TArray<ContactPair> ContactPairs;
+	TArray<ContactPair> PreviousContactPairs;
+	TWEventBatch<FBulletContactEvent> ContactEventBatch;
+	void GatherContactEvents();
+	// drops the pairs of an object that is about to be freed, it won't get an End event
+	void ForgetContactPairs(const btCollisionObject* Object);
+	void PublishPhysicsEvents();
+	void DeliverPhysicsEvents();
+	// Radius in cm
+	void EnableProjectileCcd(btRigidBody* Body, float Radius);
+	// Body and the actor's body never become a pair, e.g. a shot and whoever fired it. Has to be called before the
+	// next step, pairs that already exist aren't removed.
+	void IgnoreActorCollision(btRigidBody* Body, AActor* IgnoredActor);
+	// Layer pairs that are filtered out in the broadphase, so they never get a pair, an algorithm or a manifold.
+	// Read at BeginPlay.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Bullet Physics|Layers")
+	TArray<FBulletLayerPair> IgnoredLayerPairs = {
+		FBulletLayerPair(EBulletCollisionLayer::Projectile, EBulletCollisionLayer::Projectile),
+		FBulletLayerPair(EBulletCollisionLayer::Static, EBulletCollisionLayer::Static) };
+	// broadphase mask of each layer, the group is just the layer's bit
+	int32 LayerMasks[(int32)EBulletCollisionLayer::MAX];
+	void BuildLayerMasks();
+	void AddBodyToWorld(btRigidBody* Body);
+	static void RecordProjectileHit(btDynamicsWorld* World, const btProjectileHit& Hit);
+	// hard cap on solver iterations per island
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Bullet Physics|Solver")
+	int32 SolverIterations = 10;
+	// an island stops iterating once no row needed a velocity correction bigger than sqrt(this) (cm/s),
+	// 0 always runs every iteration. Server and clients have to use the same value.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Bullet Physics|Solver")
+	float SolverResidualThreshold = 0.01f;
+	UPROPERTY(BlueprintReadOnly, Category = "Bullet Physics|Solver")
+	FBulletSolverStats SolverStats;
+	static void ConfigureSolver(btContactSolverInfo& SolverInfo, int32 Iterations, float ResidualThreshold);
+	void UpdateSolverStats();
 	struct ConvexHullShapeHolder
 	{
 		UBodySetup* BodySetup;
 		int HullIndex;
 		FVector Scale;
 		btConvexHullShape* Shape;
+		// owned by a BulletCollisionCache rather than by us
+		bool bCooked;
 	};
 	TArray<ConvexHullShapeHolder> BtConvexHullCollisionShapes;
+	struct SdfShapeHolder
+	{
+		UStaticMesh* Mesh;
+		FVector Scale;
+		btSdfCollisionShape* Shape;
+		// owned by a BulletCollisionCache rather than by us
+		bool bCooked;
+	};
+	TArray<SdfShapeHolder> BtSdfCollisionShapes;
+	// Loaded cooked collision per asset (body setup for hulls, static mesh for distance fields),
+	// null when an asset has no (valid) cooked blob
+	TMap<UObject*, BulletCollisionCache*> CookedCollision;
+	// file names in the cooked collision folder, listed once so assets without a blob never touch the disk
+	TSet<FString> CookedFiles;
+	bool bCookedFilesListed = false;
+	// use blobs written by CookCollisionData instead of building hulls at BeginPlay
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Bullet Physics|Cooking")
+	bool bUseCookedCollision = true;
+	// hulls are cut down to this many vertices when they're built, 0 keeps every vertex the asset has
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Bullet Physics|Hulls")
+	int32 HullVertexBudget = 32;
+	// cm, vertices that stick out less than this over their neighbors are dropped, which merges nearly flat faces
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Bullet Physics|Hulls")
+	float HullPlanarTolerance = 0.5f;
+	// hull-hull contacts from a separating axis test instead of GJK. Exact face contacts, but slower even with the
+	// hill climbing, so only worth it when hulls stack badly
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Bullet Physics|Hulls")
+	bool bHullSatContacts = false;
+	// Static actors whose meshes collide through a distance field baked from the render mesh (LODForCollision)
+	// instead of their simple collision. They still have to be set up as statics the usual way.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Bullet Physics|SDF")
+	TArray<AActor*> SdfStaticActors;
+	// cm, trilinear error is roughly a tenth of this on curved surfaces
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Bullet Physics|SDF")
+	float SdfCellSize = 10.f;
+	// cm, distances are only stored this close to the surface. Should cover the biggest sphere/capsule radius,
+	// wider ones fall back to a few support points (and log a warning)
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Bullet Physics|SDF")
+	float SdfBand = 100.f;
+	// big meshes get coarser cells rather than a grid bigger than this along any axis
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Bullet Physics|SDF")
+	int32 SdfMaxCellsPerAxis = 512;
+	// one collision source of a dynamic actor: a body setup and where it sits relative to the actor
+	struct DynamicShapeSource
+	{
+		UBodySetup* BodySetup;
+		FTransform RelTransform;
+	};
+	typedef TArray<DynamicShapeSource, TInlineAllocator<20>> DynamicShapeSources;
 	struct CachedDynamicShapeData
 	{
-		FName ClassName;
+		// what the shape was built from, compared on every spawn instead of hashing the geometry again
+		UClass* Class;
+		TArray<DynamicShapeSource> Sources;
+		// GetCookedCompoundName of the actors using it, the key into cooked blobs
+		FString Name;
 		btCollisionShape* Shape;
 		bool bIsCompound;
+		// owned by a BulletCollisionCache rather than by us
+		bool bCooked = false;
 		btScalar Mass;
 		btVector3 Inertia;
 	};
@@ -239,29 +587,48 @@ public:
 	void ApplyLocalPlayerErrorCorrection(float DeltaTime);
 	virtual void AsyncPhysicsTickActor(float DeltaTime, float SimTime) override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	// use this to completely remove the body and references to it
 	// E.g. when destroying an actor
-	void DestroyRigidBody(btRigidBody* rigidbody)
-	{
-		BodyToActor.Remove(rigidbody);
-		ActorToBody.Remove(*BodyToActor.Find(rigidbody));
-		BtWorld->removeRigidBody(rigidbody);
-	}
+	// The actor mappings are dropped immediately, the body itself is freed at the next step boundary
+	void DestroyRigidBody(btRigidBody* rigidbody);
+	// frees every body queued by DestroyRigidBody; only call outside of stepSimulation
+	void FlushPendingDestroys();
 	
 	// THESE FUNCTIONS ARE PART OF THE API AND LARGELY SHOULDN'T BE TOUCHED
 	void SetupStaticGeometryPhysics(TArray<AActor*> Actors, float Friction, float Restitution);
 	UFUNCTION(BlueprintCallable)
 	void AddStaticBody(AActor* player, float Friction, float Restitution,int &ID);
 	UFUNCTION(BlueprintCallable)
-	void AddProcBody(AActor* Body,  float Friction, TArray<FVector> a, TArray<FVector> b, TArray<FVector> c, TArray<FVector> d, float Restitution, int& ID);
+	void AddProcBody(AActor* Body,  float Friction, const TArray<FVector>& a, const TArray<FVector>& b, const TArray<FVector>& c, const TArray<FVector>& d, float Restitution, int& ID);
+	UFUNCTION(BlueprintCallable)
+	void UpdateProcBody(AActor* Body, float Friction, const TArray<FVector>& a, const TArray<FVector>& b, const TArray<FVector>& c, const TArray<FVector>& d, float Restitution, int& ID, int PrevID);
+	UFUNCTION(BlueprintCallable)
+	void RemoveProcBody(AActor* Body);
+	// Heightfields read the caller's samples in place (row-major, SizeX per row), the buffer has to outlive the collider.
+	// Edit it and call UpdateHeightfieldRegion. Landscape heights go straight in as uint16 with
+	// HeightScale = LANDSCAPE_ZSCALE * scale Z and HeightOffset = -32768 * HeightScale.
+	btCollisionObject* AddHeightfield(AActor* Body, const uint16* Samples, int32 SizeX, int32 SizeY, float SampleSpacing, float HeightScale, float HeightOffset, float Friction, float Restitution);
+	btCollisionObject* AddHeightfield(AActor* Body, const float* Samples, int32 SizeX, int32 SizeY, float SampleSpacing, float Friction, float Restitution);
+	// samples [MinX, MaxX] x [MinY, MaxY] were changed in place
+	void UpdateHeightfieldRegion(AActor* Body, int32 MinX, int32 MinY, int32 MaxX, int32 MaxY);
+	// Blueprint version, keeps its own copy of the heights, 16-bit quantized over their range (plus slack) if asked
+	UFUNCTION(BlueprintCallable)
+	void AddHeightfieldBody(AActor* Body, const TArray<float>& Heights, int32 SizeX, int32 SizeY, float SampleSpacing, bool bQuantize, float Friction, float Restitution, int& ID);
+	// writes a RegionSizeX x RegionSizeY block of heights with its first sample at (X, Y)
+	UFUNCTION(BlueprintCallable)
+	void UpdateHeightfieldBody(AActor* Body, const TArray<float>& Heights, int32 X, int32 Y, int32 RegionSizeX, int32 RegionSizeY);
 	UFUNCTION(BlueprintCallable)
-	void UpdateProcBody(AActor* Body, float Friction, TArray<FVector> a, TArray<FVector> b, TArray<FVector> c, TArray<FVector> d, float Restitution, int& ID, int PrevID);
+	void RemoveHeightfield(AActor* Body);
 	UFUNCTION(BlueprintCallable)
-	void AddRigidBody(AActor* Body, float Friction, float Restitution,float mass);
+	void AddRigidBody(AActor* Body, float Friction, float Restitution,float mass, EBulletCollisionLayer Layer = EBulletCollisionLayer::Default);
 	// new function, no ufunction macro because btRigidBody can't be in BP
-	btRigidBody* AddRigidBodyAndReturn(AActor* Body, float Friction, float Restitution, float mass);
+	btRigidBody* AddRigidBodyAndReturn(AActor* Body, float Friction, float Restitution, float mass, EBulletCollisionLayer Layer = EBulletCollisionLayer::Default);
 	UFUNCTION(BlueprintCallable)
 	void UpdatePlayertransform(AActor* player, int ID);
+	// null for IDs that were never handed out or whose body is gone
+	btRigidBody* GetBodyById(int ID) const;
 	UFUNCTION(BlueprintCallable)
 	void AddImpulse( int ID, FVector Impulse, FVector Location);
 	typedef const std::function<void(btCollisionShape* /*SingleShape*/, const FTransform& /*RelativeXform*/)>& PhysicsGeometryCallback;
@@ -276,27 +643,71 @@ public:
 	typedef const std::function<void(btCollisionShape* /*SingleShape*/, const FTransform& /*RelativeXform*/)>& PhysicsGeometryCallback;
 	void ExtractPhysicsGeometry(AActor* Actor, PhysicsGeometryCallback CB);
 	btCollisionObject* AddStaticCollision(btCollisionShape* Shape, const FTransform& Transform, float Friction, float Restitution, AActor* Actor);
+	// routes through the chunk streamer when enabled, otherwise bakes straight into the world
+	void AddOrStreamStaticCollision(btCollisionShape* Shape, const FTransform& Transform, float Friction, float Restitution, AActor* Actor);
+	FIntVector GetStaticChunkCell(const btVector3& Position) const;
+	void UpdateStaticChunkStreaming();
+	void LoadStaticChunk(StaticChunk* Chunk);
+	void UnloadStaticChunk(StaticChunk* Chunk);
+	void SwapInBuiltStaticChunks();
+	void DestroyStaticChunks();
 	void ExtractPhysicsGeometry(UStaticMeshComponent* SMC, const FTransform& InvActorXform, PhysicsGeometryCallback CB);
 	void ExtractPhysicsGeometry(UShapeComponent* Sc, const FTransform& InvActorXform, PhysicsGeometryCallback CB);
 	void ExtractPhysicsGeometry(const FTransform& XformSoFar, UBodySetup* BodySetup, PhysicsGeometryCallback CB);
 	btCollisionShape* GetBoxCollisionShape(const FVector& Dimensions);
 	btCollisionShape* GetSphereCollisionShape(float Radius);
 	btCollisionShape* GetCapsuleCollisionShape(float Radius, float Height);
-	btCollisionShape* GetTriangleMeshShape(TArray<FVector> a, TArray<FVector> b, TArray<FVector> c, TArray<FVector> d);
+	btCollisionShape* GetTriangleMeshShape(const TArray<FVector>& a, const TArray<FVector>& b, const TArray<FVector>& c, const TArray<FVector>& d);
+	// builds the BVH, or takes a copy of a cooked one made from the same vertices
+	void BuildProcMeshShape(ProcMeshCollider* Proc, const btOptimizedBvh* CookedBvh = nullptr);
+	FString GetCookedProcName(const ProcMeshCollider* Proc) const;
+	void DestroyProcMeshCollider(ProcMeshCollider* Proc);
+	btCollisionObject* AddHeightfield(AActor* Body, HeightfieldCollider* Field, float Friction, float Restitution);
+	void BuildHeightfieldShape(HeightfieldCollider* Field);
+	FTransform GetHeightfieldTransform(const HeightfieldCollider* Field, const AActor* Body) const;
+	void DestroyHeightfieldCollider(HeightfieldCollider* Field);
 	btCollisionShape* GetConvexHullCollisionShape(UBodySetup* BodySetup, int ConvexIndex, const FVector& Scale);
+	FString GetCookedHullName(UBodySetup* BodySetup, int ConvexIndex, const FVector& Scale) const;
+	btCollisionShape* GetSdfCollisionShape(UStaticMesh* Mesh, const FVector& Scale);
+	FString GetCookedSdfName(UStaticMesh* Mesh, const FVector& Scale) const;
+	void GetDynamicShapeSources(AActor* Actor, DynamicShapeSources& Sources) const;
+	// hash of everything a dynamic actor's collision is built from, without building it. Hashes hull vertices, so
+	// only worth it when the shape isn't cached yet
+	FString GetCookedCompoundName(UClass* Class, const DynamicShapeSources& Sources) const;
+	BulletCollisionCache* GetCookedCollision(UObject* Asset);
+	// Builds the collision of every static and dynamic actor listed on this actor and writes one blob per asset
+	UFUNCTION(CallInEditor, Category = "Bullet Physics|Cooking")
+	void CookCollisionData();
+	// Procedural meshes only exist once Blueprints made them, so these are cooked from a running (PIE) session,
+	// one blob per actor class keyed by the mesh's vertices
+	UFUNCTION(CallInEditor, Category = "Bullet Physics|Cooking")
+	void CookProcMeshCollision();
 	const ATestActor::CachedDynamicShapeData& GetCachedDynamicShapeData(AActor* Actor, float Mass);
-	btRigidBody* AddRigidBody(AActor* Actor, const ATestActor::CachedDynamicShapeData& ShapeData, float Friction, float Restitution);
-	btRigidBody* AddRigidBody(AActor* Actor, btCollisionShape* CollisionShape, btVector3 Inertia, float Mass, float Friction, float Restitution);
+	btRigidBody* AddRigidBody(AActor* Actor, const ATestActor::CachedDynamicShapeData& ShapeData, float Friction, float Restitution, EBulletCollisionLayer Layer);
+	btRigidBody* AddRigidBody(AActor* Actor, btCollisionShape* CollisionShape, btVector3 Inertia, float Mass, float Friction, float Restitution, EBulletCollisionLayer Layer);
 	UFUNCTION(BlueprintCallable)
 	void StepPhysics(float DeltaSeconds, int substeps);
 	UFUNCTION(BlueprintCallable)
 	void SetPhysicsState(int ID, FTransform transforms, FVector Velocity, FVector AngularVelocity,FVector& Force);
 	UFUNCTION(BlueprintCallable)
 	void GetPhysicsState(int ID, FTransform& transforms, FVector& Velocity, FVector& AngularVelocity, FVector& Force);
+	// wakes every body with a contact manifold against Obj, e.g. when static geometry moves under sleeping bodies
+	void WakeBodiesTouching(const btCollisionObject* Obj);
 	UFUNCTION(BlueprintCallable)
 	void GetVelocityAtLocation(int ID, FVector Location, FVector& Velocity);
 	UFUNCTION(BlueprintCallable)
 	void ResetSim();
+	// Runs a fixed scene in a scratch world and returns a hash of the end state; the Windows client and
+	// Linux server must log the same value (also available as the bullet.DeterminismProbe console command).
+	// bWideSolver picks the wide contact solver instead of the row-by-row one.
+	UFUNCTION(BlueprintCallable, Category = "Bullet Physics|Determinism")
+	static int32 RunDeterminismProbe(int32 Steps = 600, bool bWideSolver = true);
+	static void PinSolverRows(btSequentialImpulseConstraintSolver* Solver);
+	// Times box updates and pair finding of every broadphase type on a few synthetic scenes shaped like ours
+	// (projectiles in an arena, a fleet, ships in a static field) and logs the results. Also the
+	// bullet.BroadphaseBenchmark console command.
+	UFUNCTION(BlueprintCallable, Category = "Bullet Physics|Broadphase")
+	static void RunBroadphaseBenchmark(int32 Steps = 300);
 };
 
 
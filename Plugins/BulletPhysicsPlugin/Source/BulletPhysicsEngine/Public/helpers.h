@@ -43,6 +43,16 @@ struct FTWPlayerInput
 
 	UPROPERTY(BlueprintReadWrite)
 	AActor* Player = nullptr;
+
+	// the tick this input is for, numbered like the server's ticks
+	UPROPERTY()
+	int32 Tick = 0;
+
+	// true when nothing here pushes the body, so a sleeping pawn can stay asleep
+	bool IsIdle() const
+	{
+		return MovementInput.IsZero() && TurnRight == 0 && TurnUp == 0 && RollRight == 0 && !BoostInput;
+	}
 };
 
 USTRUCT(BlueprintType) // A FBulletObjectState is the instantaneous state of one object in a frame
@@ -62,6 +72,14 @@ struct FBulletObjectState
 	UPROPERTY(BlueprintReadWrite)
 	FVector AngularVelocity;
 
+	// Bullet's activation state (1 active, 2 island sleeping, 3 wants deactivation, 4 never sleeps) and how long
+	// the body has been below its sleeping thresholds, so a rewind puts bodies to sleep on the same frame again
+	UPROPERTY()
+	uint8 ActivationState = 1;
+
+	UPROPERTY()
+	float DeactivationTime = 0;
+
 	// used for getting state error
 	// Update your operator- to be const-correct
 	FBulletObjectState operator-(const FBulletObjectState& other) const
@@ -97,8 +115,175 @@ struct FBulletSimulationState
 	UPROPERTY()
 	TArray<FBulletObjectState> ObjectStates = TArray<FBulletObjectState>();
 
+	// the server tick that starts from this state
 	UPROPERTY()
-	double CurrentTime = 0;
+	int32 Tick = 0;
+};
+
+USTRUCT(BlueprintType) // Solver statistics of the last simulation step, over every island that was solved
+struct FBulletSolverStats
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 Islands = 0;
+
+	// summed over all islands
+	UPROPERTY(BlueprintReadOnly)
+	int32 Iterations = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 MaxIterations = 0;
+
+	// islands that ran into the iteration cap without converging
+	UPROPERTY(BlueprintReadOnly)
+	int32 IslandsAtCap = 0;
+
+	// largest squared velocity correction left when an island stopped
+	UPROPERTY(BlueprintReadOnly)
+	float MaxResidual = 0;
+};
+
+USTRUCT(BlueprintType) // Usage of the contact manifold and collision algorithm pools
+struct FBulletPoolStats
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 Manifolds = 0;
+
+	// most manifolds alive at once so far, what ManifoldPoolSize should be
+	UPROPERTY(BlueprintReadOnly)
+	int32 PeakManifolds = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 ManifoldCapacity = 0;
+
+	// times the manifold pool was used up and had to grow
+	UPROPERTY(BlueprintReadOnly)
+	int32 ManifoldOverflows = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 Algorithms = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 PeakAlgorithms = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 AlgorithmCapacity = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 AlgorithmOverflows = 0;
+};
+
+UENUM(BlueprintType)
+enum class EBulletBroadphase : uint8
+{
+	Dbvt,		// Bullet's dynamic AABB trees, updated incrementally
+	AxisSweep,	// Bullet's incremental sweep and prune over a fixed world box
+	Sap			// sorts and sweeps every moving box each step, in parallel. Made for lots of small fast bodies
+};
+
+USTRUCT(BlueprintType) // Broadphase work of the last simulation step
+struct FBulletBroadphaseStats
+{
+	GENERATED_BODY()
+
+	// proxies whose box was pushed into the broadphase
+	UPROPERTY(BlueprintReadOnly)
+	int32 AabbUpdates = 0;
+
+	// static, sleeping and unmoved objects that were left alone
+	UPROPERTY(BlueprintReadOnly)
+	int32 AabbSkips = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 OverlappingPairs = 0;
+};
+
+USTRUCT(BlueprintType) // A projectile's swept sphere stopped at something during a step
+struct FBulletProjectileHit
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly)
+	AActor* Projectile = nullptr;
+
+	// null for colliders that don't belong to an actor
+	UPROPERTY(BlueprintReadOnly)
+	AActor* HitActor = nullptr;
+
+	UPROPERTY(BlueprintReadOnly)
+	FVector Location = FVector::ZeroVector;
+
+	UPROPERTY(BlueprintReadOnly)
+	FVector Normal = FVector::ZeroVector;
+
+	// how far into the step the hit happened, 0..1
+	UPROPERTY(BlueprintReadOnly)
+	float Time = 0;
+};
+
+UENUM(BlueprintType, meta = (Bitflags)) // Each layer is one bit of the broadphase group, at most 16 of them
+enum class EBulletCollisionLayer : uint8
+{
+	Default,
+	Static,		// every static collider, proc meshes and heightfields included
+	Ship,
+	Projectile,
+	Debris,
+	MAX UMETA(Hidden)
+};
+
+USTRUCT(BlueprintType) // Two layers whose bodies never collide, the same layer twice for bodies within a layer
+struct FBulletLayerPair
+{
+	GENERATED_BODY()
+
+	FBulletLayerPair() {}
+	FBulletLayerPair(EBulletCollisionLayer InA, EBulletCollisionLayer InB) : A(InA), B(InB) {}
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	EBulletCollisionLayer A = EBulletCollisionLayer::Default;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	EBulletCollisionLayer B = EBulletCollisionLayer::Default;
+};
+
+UENUM(BlueprintType)
+enum class EBulletContactPhase : uint8
+{
+	Begin,		// first tick the pair touches
+	Persist,	// still touching
+	End			// touched last tick, doesn't anymore
+};
+
+USTRUCT(BlueprintType) // One touching pair of bodies at the end of a tick
+struct FBulletContactEvent
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly)
+	EBulletContactPhase Phase = EBulletContactPhase::Begin;
+
+	// either can be null for colliders that don't belong to an actor
+	UPROPERTY(BlueprintReadOnly)
+	AActor* ActorA = nullptr;
+
+	UPROPERTY(BlueprintReadOnly)
+	AActor* ActorB = nullptr;
+
+	// deepest point of the pair, on B. Stays at the last touching point for End
+	UPROPERTY(BlueprintReadOnly)
+	FVector Location = FVector::ZeroVector;
+
+	// points from B towards A
+	UPROPERTY(BlueprintReadOnly)
+	FVector Normal = FVector::ZeroVector;
+
+	// total impulse the solver applied along the normals this tick (kg cm/s), 0 for End
+	UPROPERTY(BlueprintReadOnly)
+	float Impulse = 0;
 };
 
 static FBulletObjectState InterpolateObjectStates(const FBulletObjectState& a, const FBulletObjectState& b, float alpha)
@@ -10,23 +10,14 @@ public class BulletPhysicsEngineLibrary : ModuleRules
 		Type = ModuleType.External;
 
 
-		   bool bDebug = Target.Configuration == UnrealTargetConfiguration.Debug || Target.Configuration == UnrealTargetConfiguration.DebugGame;
-        bool bDevelopment = Target.Configuration == UnrealTargetConfiguration.Development;
-
-        string BuildFolder = bDebug ? "Debug":
-            bDevelopment ? "RelWithDebInfo" : "Release";
-        string BuildSuffix = bDebug ? "_Debug":
-            bDevelopment ? "_RelWithDebugInfo" : "";
-
-        // Library path
-        string LibrariesPath = Path.Combine(ModuleDirectory, "lib", BuildFolder);
-        PublicAdditionalLibraries.Add(Path.Combine(LibrariesPath, "BulletCollision" + BuildSuffix + ".lib")); 
-        PublicAdditionalLibraries.Add(Path.Combine(LibrariesPath, "BulletDynamics" + BuildSuffix + ".lib")); 
-        PublicAdditionalLibraries.Add(Path.Combine(LibrariesPath, "LinearMath" + BuildSuffix + ".lib")); 
+        // No prebuilt libs: Bullet is compiled from src by BulletPhysicsEngine (Private/BulletLibrary.cpp), so
+        // the library always matches these headers and definitions on every platform and config.
 
         // Include path (I'm just using the source here since Bullet has mixed src & headers)
        PublicIncludePaths.Add( Path.Combine( ModuleDirectory, "src" ) );
        PublicDefinitions.Add("WITH_BULLET_BINDING=1");
+       // islands are solved on the task graph
+       PublicDefinitions.Add("BT_THREADSAFE=1");
 			
 			
 			
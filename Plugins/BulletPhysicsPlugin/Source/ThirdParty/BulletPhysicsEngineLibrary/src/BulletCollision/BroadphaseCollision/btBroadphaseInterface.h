@@ -28,6 +28,13 @@ struct btBroadphaseAabbCallback
 	virtual bool process(const btBroadphaseProxy* proxy) = 0;
 };
 
+///reports every (query box, proxy) overlap of btBroadphaseInterface::aabbTestBatch
+struct btBroadphaseAabbBatchCallback
+{
+	virtual ~btBroadphaseAabbBatchCallback() {}
+	virtual void process(int aabbIndex, const btBroadphaseProxy* proxy) = 0;
+};
+
 struct btBroadphaseRayCallback : public btBroadphaseAabbCallback
 {
 	///added some cached data to accelerate ray-AABB tests
@@ -56,10 +63,42 @@ public:
 	virtual void setAabb(btBroadphaseProxy* proxy, const btVector3& aabbMin, const btVector3& aabbMax, btDispatcher* dispatcher) = 0;
 	virtual void getAabb(btBroadphaseProxy* proxy, btVector3& aabbMin, btVector3& aabbMax) const = 0;
 
+	///false if setAabb with this box would not change any pair, so btCollisionWorld can skip the call
+	virtual bool needsAabbUpdate(const btBroadphaseProxy* proxy, const btVector3& aabbMin, const btVector3& aabbMax) const
+	{
+		(void)proxy;
+		(void)aabbMin;
+		(void)aabbMax;
+		return true;
+	}
+
 	virtual void rayTest(const btVector3& rayFrom, const btVector3& rayTo, btBroadphaseRayCallback& rayCallback, const btVector3& aabbMin = btVector3(0, 0, 0), const btVector3& aabbMax = btVector3(0, 0, 0)) = 0;
 
 	virtual void aabbTest(const btVector3& aabbMin, const btVector3& aabbMax, btBroadphaseAabbCallback& callback) = 0;
 
+	///aabbTest for many boxes at once, a broadphase can override this to share the traversal between the boxes.
+	///The order in which overlaps are reported is up to the broadphase.
+	virtual void aabbTestBatch(const btVector3* aabbMins, const btVector3* aabbMaxs, int numAabbs, btBroadphaseAabbBatchCallback& callback)
+	{
+		struct SingleAabbCallback : public btBroadphaseAabbCallback
+		{
+			btBroadphaseAabbBatchCallback& m_callback;
+			int m_aabbIndex;
+			SingleAabbCallback(btBroadphaseAabbBatchCallback& callback) : m_callback(callback), m_aabbIndex(0) {}
+			virtual bool process(const btBroadphaseProxy* proxy)
+			{
+				m_callback.process(m_aabbIndex, proxy);
+				return true;
+			}
+		};
+		SingleAabbCallback single(callback);
+		for (int i = 0; i < numAabbs; i++)
+		{
+			single.m_aabbIndex = i;
+			aabbTest(aabbMins[i], aabbMaxs[i], single);
+		}
+	}
+
 	///calculateOverlappingPairs is optional: incremental algorithms (sweep and prune) might do it during the set aabb
 	virtual void calculateOverlappingPairs(btDispatcher* dispatcher) = 0;
 
@@ -73,6 +112,11 @@ public:
 	///reset broadphase internal structures, to ensure determinism/reproducability
 	virtual void resetPool(btDispatcher* dispatcher) { (void)dispatcher; };
 
+	///Steps between beginReplay and endReplay repeat frames that were simulated before (rollback). A broadphase may skip
+	///tree maintenance there, but only where it can't change the pairs, their order or anything else the step sees.
+	virtual void beginReplay() {}
+	virtual void endReplay(btDispatcher* dispatcher) { (void)dispatcher; }
+
 	virtual void printStats() = 0;
 };
 
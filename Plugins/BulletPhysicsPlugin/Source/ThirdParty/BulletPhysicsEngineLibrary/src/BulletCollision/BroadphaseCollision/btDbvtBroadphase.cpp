@@ -123,6 +123,46 @@ struct btDbvtTreeCollider : btDbvt::ICollide
 	}
 };
 
+/* Parallel tree collider, keeps the pairs the cache doesn't have yet	*/
+struct btDbvtParallelCollider : btDbvt::ICollide
+{
+	btOverlappingPairCache* paircache;
+	btBroadphasePairArray* pairs;
+	int found;
+	void Process(const btDbvtNode* na, const btDbvtNode* nb)
+	{
+		if (na != nb)
+		{
+			btDbvtProxy* pa = (btDbvtProxy*)na->data;
+			btDbvtProxy* pb = (btDbvtProxy*)nb->data;
+			++found;
+			if (paircache->needsBroadphaseCollision(pa, pb) && !paircache->findPair(pa, pb))
+			{
+				pairs->push_back(btBroadphasePair(*pa, *pb));
+			}
+		}
+	}
+};
+
+struct btDbvtCollideBody : btIParallelForBody
+{
+	btDbvtBroadphase* pbp;
+	void forLoop(int iBegin, int iEnd) const
+	{
+		btDbvtParallelCollider collider;
+		collider.paircache = pbp->m_paircache;
+		for (int i = iBegin; i < iEnd; ++i)
+		{
+			const btDbvt::sStkNN& task = pbp->m_collidetasks[i];
+			collider.pairs = &pbp->m_collidepairs[i];
+			collider.pairs->resizeNoInitialize(0);
+			collider.found = 0;
+			pbp->m_sets[0].collideTT(task.a, task.b, collider);
+			pbp->m_collidefound[i] = collider.found;
+		}
+	}
+};
+
 //
 // btDbvtBroadphase
 //
@@ -131,6 +171,8 @@ struct btDbvtTreeCollider : btDbvt::ICollide
 btDbvtBroadphase::btDbvtBroadphase(btOverlappingPairCache* paircache)
 {
 	m_deferedcollide = false;
+	m_parallelcollide = false;
+	m_replay = false;
 	m_needcleanup = true;
 	m_releasepaircache = (paircache != 0) ? false : true;
 	m_prediction = 0;
@@ -307,6 +349,51 @@ void btDbvtBroadphase::aabbTest(const btVector3& aabbMin, const btVector3& aabbM
 	m_sets[1].collideTV(m_sets[1].m_root, bounds, callback);
 }
 
+struct BroadphaseAabbBatchTester : btDbvt::ICollide
+{
+	btBroadphaseAabbBatchCallback& m_aabbCallback;
+	BroadphaseAabbBatchTester(btBroadphaseAabbBatchCallback& orgCallback)
+		: m_aabbCallback(orgCallback)
+	{
+	}
+	void Process(const btDbvtNode* proxyLeaf, const btDbvtNode* queryLeaf)
+	{
+		m_aabbCallback.process((int)(size_t)queryLeaf->data, (btDbvtProxy*)proxyLeaf->data);
+	}
+};
+
+// the query boxes get a tree of their own, so both sets are walked once for all of them instead of once per box
+void btDbvtBroadphase::aabbTestBatch(const btVector3* aabbMins, const btVector3* aabbMaxs, int numAabbs, btBroadphaseAabbBatchCallback& aabbCallback)
+{
+	if (numAabbs <= 0)
+		return;
+	if (numAabbs == 1)
+	{
+		struct SingleAabbCallback : public btBroadphaseAabbCallback
+		{
+			btBroadphaseAabbBatchCallback& m_callback;
+			SingleAabbCallback(btBroadphaseAabbBatchCallback& callback) : m_callback(callback) {}
+			virtual bool process(const btBroadphaseProxy* proxy)
+			{
+				m_callback.process(0, proxy);
+				return true;
+			}
+		};
+		SingleAabbCallback single(aabbCallback);
+		aabbTest(aabbMins[0], aabbMaxs[0], single);
+		return;
+	}
+
+	btDbvt queries;
+	for (int i = 0; i < numAabbs; i++)
+	{
+		queries.insert(btDbvtVolume::FromMM(aabbMins[i], aabbMaxs[i]), (void*)(size_t)i);
+	}
+	BroadphaseAabbBatchTester callback(aabbCallback);
+	m_sets[0].collideTTpersistentStack(m_sets[0].m_root, queries.m_root, callback);
+	m_sets[1].collideTTpersistentStack(m_sets[1].m_root, queries.m_root, callback);
+}
+
 //
 void btDbvtBroadphase::setAabb(btBroadphaseProxy* absproxy,
 							   const btVector3& aabbMin,
@@ -372,6 +459,24 @@ void btDbvtBroadphase::setAabb(btBroadphaseProxy* absproxy,
 	}
 }
 
+//
+bool btDbvtBroadphase::needsAabbUpdate(const btBroadphaseProxy* absproxy,
+									   const btVector3& aabbMin,
+									   const btVector3& aabbMax) const
+{
+	const btDbvtProxy* proxy = (const btDbvtProxy*)absproxy;
+	if (proxy->stage == STAGECOUNT)
+	{ /* fixed set: the pairs only depend on the leaf volume, which still covers the box */
+		ATTRIBUTE_ALIGNED16(btDbvtVolume)
+		aabb = btDbvtVolume::FromMM(aabbMin, aabbMax);
+		return !proxy->leaf->volume.Contain(aabb);
+	}
+	/* dynamic set: leave an unchanged box alone so the proxy ages into the fixed set, like a sleeping body.
+	A box that moves inside its fattened volume still goes through setAabb, that's the cheap path there
+	and skipping it would only bounce the proxy between the two sets */
+	return !(aabbMin == proxy->m_aabbMin && aabbMax == proxy->m_aabbMax);
+}
+
 //
 void btDbvtBroadphase::setAabbForceUpdate(btBroadphaseProxy* absproxy,
 										  const btVector3& aabbMin,
@@ -527,13 +632,16 @@ void btDbvtBroadphase::collide(btDispatcher* dispatcher)
 */
 
 	SPC(m_profiling.m_total);
-	/* optimize				*/
-	m_sets[0].optimizeIncremental(1 + (m_sets[0].m_leaves * m_dupdates) / 100);
-	if (m_fixedleft)
+	/* optimize, replays leave the trees as they are	*/
+	if (!m_replay)
 	{
-		const int count = 1 + (m_sets[1].m_leaves * m_fupdates) / 100;
-		m_sets[1].optimizeIncremental(1 + (m_sets[1].m_leaves * m_fupdates) / 100);
-		m_fixedleft = btMax<int>(0, m_fixedleft - count);
+		m_sets[0].optimizeIncremental(1 + (m_sets[0].m_leaves * m_dupdates) / 100);
+		if (m_fixedleft)
+		{
+			const int count = 1 + (m_sets[1].m_leaves * m_fupdates) / 100;
+			m_sets[1].optimizeIncremental(1 + (m_sets[1].m_leaves * m_fupdates) / 100);
+			m_fixedleft = btMax<int>(0, m_fixedleft - count);
+		}
 	}
 	/* dynamic -> fixed set	*/
 	m_stageCurrent = (m_stageCurrent + 1) % STAGECOUNT;
@@ -565,6 +673,12 @@ void btDbvtBroadphase::collide(btDispatcher* dispatcher)
 		m_needcleanup = true;
 	}
 	/* collide dynamics		*/
+	if (m_parallelcollide)
+	{
+		SPC(m_profiling.m_ddcollide);
+		collideParallel();
+	}
+	else
 	{
 		btDbvtTreeCollider collider(this);
 		if (m_deferedcollide)
@@ -623,6 +737,112 @@ void btDbvtBroadphase::collide(btDispatcher* dispatcher)
 	m_updates_call /= 2;
 }
 
+//
+void btDbvtBroadphase::collideParallel()
+{
+	/* split the two tree pairs the way collideTT descends them, breadth first, so each task gets a disjoint part	*/
+	btAlignedObjectArray<btDbvt::sStkNN>& tasks = m_collidetasks;
+	btAlignedObjectArray<btDbvt::sStkNN> next;
+	tasks.resize(0);
+	if (m_sets[0].m_root)
+	{
+		if (m_sets[1].m_root)
+			tasks.push_back(btDbvt::sStkNN(m_sets[0].m_root, m_sets[1].m_root));
+		tasks.push_back(btDbvt::sStkNN(m_sets[0].m_root, m_sets[0].m_root));
+	}
+	bool split = true;
+	while (split && tasks.size() && tasks.size() < COLLIDE_TASKS)
+	{
+		split = false;
+		next.resize(0);
+		for (int i = 0; i < tasks.size(); ++i)
+		{
+			const btDbvt::sStkNN p = tasks[i];
+			if (next.size() + tasks.size() - i >= COLLIDE_TASKS)
+			{
+				next.push_back(p);
+				continue;
+			}
+			if (p.a == p.b)
+			{
+				if (p.a->isinternal())
+				{
+					next.push_back(btDbvt::sStkNN(p.a->childs[0], p.a->childs[0]));
+					next.push_back(btDbvt::sStkNN(p.a->childs[1], p.a->childs[1]));
+					next.push_back(btDbvt::sStkNN(p.a->childs[0], p.a->childs[1]));
+					split = true;
+				}
+			}
+			else if (Intersect(p.a->volume, p.b->volume))
+			{
+				if (p.a->isinternal() && p.b->isinternal())
+				{
+					next.push_back(btDbvt::sStkNN(p.a->childs[0], p.b->childs[0]));
+					next.push_back(btDbvt::sStkNN(p.a->childs[1], p.b->childs[0]));
+					next.push_back(btDbvt::sStkNN(p.a->childs[0], p.b->childs[1]));
+					next.push_back(btDbvt::sStkNN(p.a->childs[1], p.b->childs[1]));
+					split = true;
+				}
+				else if (p.a->isinternal())
+				{
+					next.push_back(btDbvt::sStkNN(p.a->childs[0], p.b));
+					next.push_back(btDbvt::sStkNN(p.a->childs[1], p.b));
+					split = true;
+				}
+				else if (p.b->isinternal())
+				{
+					next.push_back(btDbvt::sStkNN(p.a, p.b->childs[0]));
+					next.push_back(btDbvt::sStkNN(p.a, p.b->childs[1]));
+					split = true;
+				}
+				else
+				{
+					next.push_back(p);
+				}
+			}
+		}
+		tasks.copyFromArray(next);
+	}
+	if (!tasks.size())
+		return;
+
+	if (m_collidepairs.size() < tasks.size())
+		m_collidepairs.resize(tasks.size());
+	m_collidefound.resize(tasks.size());
+	btDbvtCollideBody body;
+	body.pbp = this;
+	btParallelFor(0, tasks.size(), 1, body);
+
+	/* the pair cache isn't thread safe. Sorting by proxy ids makes the add order independent of the tree shape too	*/
+	m_collidemerged.resizeNoInitialize(0);
+	for (int i = 0; i < tasks.size(); ++i)
+	{
+		const btBroadphasePairArray& pairs = m_collidepairs[i];
+		for (int j = 0; j < pairs.size(); ++j)
+			m_collidemerged.push_back(pairs[j]);
+		/* the cleanup pass scales with the pairs found, like the serial deferred collide	*/
+		m_newpairs += m_collidefound[i];
+	}
+	m_collidemerged.quickSort(btBroadphasePairSortPredicate());
+	for (int i = 0; i < m_collidemerged.size(); ++i)
+	{
+		m_paircache->addOverlappingPair(m_collidemerged[i].m_pProxy0, m_collidemerged[i].m_pProxy1);
+	}
+}
+
+//
+void btDbvtBroadphase::beginReplay()
+{
+	/* only when the pair order doesn't depend on the tree shape, otherwise a replay would add pairs in another order	*/
+	m_replay = m_parallelcollide && m_deferedcollide;
+}
+
+//
+void btDbvtBroadphase::endReplay(btDispatcher* /*dispatcher*/)
+{
+	m_replay = false;
+}
+
 //
 void btDbvtBroadphase::optimize()
 {
@@ -671,7 +891,7 @@ void btDbvtBroadphase::resetPool(btDispatcher* dispatcher)
 		m_sets[0].clear();
 		m_sets[1].clear();
 
-		m_deferedcollide = false;
+		m_deferedcollide = m_parallelcollide;
 		m_needcleanup = true;
 		m_stageCurrent = 0;
 		m_fixedleft = 0;
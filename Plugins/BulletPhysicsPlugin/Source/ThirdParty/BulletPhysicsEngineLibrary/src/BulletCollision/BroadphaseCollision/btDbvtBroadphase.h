@@ -66,7 +66,8 @@ struct btDbvtBroadphase : btBroadphaseInterface
 	{
 		DYNAMIC_SET = 0, /* Dynamic set index	*/
 		FIXED_SET = 1,   /* Fixed set index		*/
-		STAGECOUNT = 2   /* Number of stages		*/
+		STAGECOUNT = 2,  /* Number of stages		*/
+		COLLIDE_TASKS = 128 /* Subtree pairs a parallel collide is split into */
 	};
 	/* Fields		*/
 	btDbvt m_sets[2];                           // Dbvt sets
@@ -88,6 +89,12 @@ struct btDbvtBroadphase : btBroadphaseInterface
 	bool m_releasepaircache;                    // Release pair cache on delete
 	bool m_deferedcollide;                      // Defere dynamic/static collision to collide call
 	bool m_needcleanup;                         // Need to run cleanup?
+	bool m_parallelcollide;                     // Find pairs with btParallelFor in collide
+	btAlignedObjectArray<btDbvt::sStkNN> m_collidetasks;              // Subtree pairs of the parallel collide
+	btAlignedObjectArray<btBroadphasePairArray> m_collidepairs;       // New pairs found by each task
+	btAlignedObjectArray<int> m_collidefound;                         // All pairs found by each task, cached or not
+	btBroadphasePairArray m_collidemerged;                            // All of them, sorted
+	bool m_replay;                              // Between beginReplay and endReplay, skips optimizeIncremental
 	btAlignedObjectArray<btAlignedObjectArray<const btDbvtNode*> > m_rayTestStacks;
 #if DBVT_BP_PROFILE
 	btClock m_clock;
@@ -104,6 +111,7 @@ struct btDbvtBroadphase : btBroadphaseInterface
 	btDbvtBroadphase(btOverlappingPairCache* paircache = 0);
 	~btDbvtBroadphase();
 	void collide(btDispatcher* dispatcher);
+	void collideParallel();
 	void optimize();
 
 	/* btBroadphaseInterface Implementation	*/
@@ -112,8 +120,10 @@ struct btDbvtBroadphase : btBroadphaseInterface
 	virtual void setAabb(btBroadphaseProxy* proxy, const btVector3& aabbMin, const btVector3& aabbMax, btDispatcher* dispatcher);
 	virtual void rayTest(const btVector3& rayFrom, const btVector3& rayTo, btBroadphaseRayCallback& rayCallback, const btVector3& aabbMin = btVector3(0, 0, 0), const btVector3& aabbMax = btVector3(0, 0, 0));
 	virtual void aabbTest(const btVector3& aabbMin, const btVector3& aabbMax, btBroadphaseAabbCallback& callback);
+	virtual void aabbTestBatch(const btVector3* aabbMins, const btVector3* aabbMaxs, int numAabbs, btBroadphaseAabbBatchCallback& callback);
 
 	virtual void getAabb(btBroadphaseProxy* proxy, btVector3& aabbMin, btVector3& aabbMax) const;
+	virtual bool needsAabbUpdate(const btBroadphaseProxy* proxy, const btVector3& aabbMin, const btVector3& aabbMax) const;
 	virtual void calculateOverlappingPairs(btDispatcher* dispatcher);
 	virtual btOverlappingPairCache* getOverlappingPairCache();
 	virtual const btOverlappingPairCache* getOverlappingPairCache() const;
@@ -123,6 +133,12 @@ struct btDbvtBroadphase : btBroadphaseInterface
 	///reset broadphase internal structures, to ensure determinism/reproducability
 	virtual void resetPool(btDispatcher* dispatcher);
 
+	///Replay steps skip the incremental tree optimization, everything else runs as in a normal step. Only with parallel
+	///collide, where pairs are added sorted by proxy id; the serial paths add them in tree order, so there it does nothing.
+	///Ray and aabb queries still walk the trees, hits of equal fraction can come back in another order than before.
+	virtual void beginReplay();
+	virtual void endReplay(btDispatcher* dispatcher);
+
 	void performDeferredRemoval(btDispatcher* dispatcher);
 
 	void setVelocityPrediction(btScalar prediction)
@@ -134,6 +150,20 @@ struct btDbvtBroadphase : btBroadphaseInterface
 		return m_prediction;
 	}
 
+	///Finds the dynamic-dynamic and dynamic-fixed pairs in calculateOverlappingPairs with btParallelFor, instead of one proxy at
+	///a time in setAabb. The trees are split into a fixed number of subtree pairs, each task only reads the trees and the pair
+	///cache and keeps the pairs that aren't cached yet, which are then sorted by proxy id and added on the calling thread.
+	///The pair cache's overlap filter callback gets called from worker threads in this mode.
+	void setParallelCollide(bool parallel)
+	{
+		m_parallelcollide = parallel;
+		m_deferedcollide = parallel;
+	}
+	bool getParallelCollide() const
+	{
+		return m_parallelcollide;
+	}
+
 	///this setAabbForceUpdate is similar to setAabb but always forces the aabb update.
 	///it is not part of the btBroadphaseInterface but specific to btDbvtBroadphase.
 	///it bypasses certain optimizations that prevent aabb updates (when the aabb shrinks), see
@@ -455,6 +455,16 @@ public:
 		return m_useQuantization;
 	}
 
+	///the box the tree was quantized over, refits have to stay inside it
+	const btVector3& getQuantizationAabbMin() const
+	{
+		return m_bvhAabbMin;
+	}
+	const btVector3& getQuantizationAabbMax() const
+	{
+		return m_bvhAabbMax;
+	}
+
 private:
 	// Special "copy" constructor that allows for in-place deserialization
 	// Prevents btVector3's default constructor from being called, but doesn't inialize much else
@@ -0,0 +1,559 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2009 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "btSapBroadphase.h"
+#include "BulletCollision/CollisionShapes/btCollisionShape.h"
+#include "LinearMath/btAabbUtil2.h"
+#include "LinearMath/btThreads.h"
+
+#include <string.h>
+#include <new>
+
+#if defined(BT_USE_SSE) && !defined(BT_USE_DOUBLE_PRECISION)
+#define BT_SAP_USE_SSE 1
+#endif
+
+//order preserving float -> unsigned key for the radix sort
+static SIMD_FORCE_INLINE unsigned int sapSortKey(btScalar value)
+{
+	float f = float(value);
+	unsigned int u;
+	memcpy(&u, &f, sizeof(u));
+	return (u & 0x80000000u) ? ~u : (u | 0x80000000u);
+}
+
+static SIMD_FORCE_INLINE void sapFillEntry(btSapEntry& entry, const btVector3& aabbMin, const btVector3& aabbMax, int axis, int group, int mask)
+{
+	const int axis1 = (axis + 1) % 3;
+	const int axis2 = (axis + 2) % 3;
+	entry.m_offAxis[0] = aabbMin[axis1];
+	entry.m_offAxis[1] = aabbMin[axis2];
+	entry.m_offAxis[2] = -aabbMax[axis1];
+	entry.m_offAxis[3] = -aabbMax[axis2];
+	entry.m_min = aabbMin[axis];
+	entry.m_max = aabbMax[axis];
+	entry.m_group = group;
+	entry.m_mask = mask;
+}
+
+//the sweep already knows the boxes overlap on the sorted axis, this tests the other two
+struct btSapOffAxisQuery
+{
+#ifdef BT_SAP_USE_SSE
+	__m128 m_query;
+
+	SIMD_FORCE_INLINE btSapOffAxisQuery(const btSapEntry& entry)
+	{
+		//{max1, max2, -min1, -min2}
+		const __m128 v = _mm_load_ps(entry.m_offAxis);
+		m_query = _mm_sub_ps(_mm_setzero_ps(), _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+	}
+
+	SIMD_FORCE_INLINE bool overlaps(const btSapEntry& other) const
+	{
+		return _mm_movemask_ps(_mm_cmpgt_ps(_mm_load_ps(other.m_offAxis), m_query)) == 0;
+	}
+#else
+	btScalar m_query[4];
+
+	SIMD_FORCE_INLINE btSapOffAxisQuery(const btSapEntry& entry)
+	{
+		m_query[0] = -entry.m_offAxis[2];
+		m_query[1] = -entry.m_offAxis[3];
+		m_query[2] = -entry.m_offAxis[0];
+		m_query[3] = -entry.m_offAxis[1];
+	}
+
+	SIMD_FORCE_INLINE bool overlaps(const btSapEntry& other) const
+	{
+		return other.m_offAxis[0] <= m_query[0] && other.m_offAxis[1] <= m_query[1] && other.m_offAxis[2] <= m_query[2] && other.m_offAxis[3] <= m_query[3];
+	}
+#endif
+};
+
+static SIMD_FORCE_INLINE bool sapFiltersPass(const btSapEntry& a, const btSapEntry& b)
+{
+	return (a.m_group & b.m_mask) != 0 && (b.m_group & a.m_mask) != 0;
+}
+
+//box pruning within one sorted set, entries [begin, end) against everything after them
+static void sapSweepSelf(const btSapEntry* entries, int numEntries, int begin, int end, btAlignedObjectArray<int>& pairs)
+{
+	for (int i = begin; i < end; i++)
+	{
+		const btSapEntry& a = entries[i];
+		const btSapOffAxisQuery query(a);
+		for (int j = i + 1; j < numEntries && entries[j].m_min <= a.m_max; j++)
+		{
+			if (query.overlaps(entries[j]) && sapFiltersPass(a, entries[j]))
+			{
+				pairs.push_back(i);
+				pairs.push_back(j);
+			}
+		}
+	}
+}
+
+//One side of bipartite box pruning: each of a[begin, end) against the b that start inside it. Run once each way, with
+//strict on the second run, so a pair is found exactly once. Pairs are written as (a, b), or (b, a) if swapped.
+static void sapSweepAgainst(const btSapEntry* a, int begin, int end, const btSapEntry* b, int numB, bool strict, bool filter, bool swapped, btAlignedObjectArray<int>& pairs)
+{
+	if (begin >= end || numB == 0)
+		return;
+
+	//first b at or after a[begin], later a only move it forward
+	int lo = 0, hi = numB;
+	const btScalar first = a[begin].m_min;
+	while (lo < hi)
+	{
+		const int mid = (lo + hi) >> 1;
+		if (strict ? b[mid].m_min <= first : b[mid].m_min < first)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	int start = lo;
+	for (int i = begin; i < end; i++)
+	{
+		const btSapEntry& entry = a[i];
+		while (start < numB && (strict ? b[start].m_min <= entry.m_min : b[start].m_min < entry.m_min))
+			start++;
+		const btSapOffAxisQuery query(entry);
+		for (int j = start; j < numB && b[j].m_min <= entry.m_max; j++)
+		{
+			if (query.overlaps(b[j]) && (!filter || sapFiltersPass(entry, b[j])))
+			{
+				pairs.push_back(swapped ? j : i);
+				pairs.push_back(swapped ? i : j);
+			}
+		}
+	}
+}
+
+btSapBroadphase::btSapBroadphase(int staticGroup, btOverlappingPairCache* overlappingPairCache)
+	: m_pairCache(overlappingPairCache),
+	  m_ownsPairCache(false),
+	  m_staticGroup(staticGroup),
+	  m_uniqueId(0),
+	  m_axis(0),
+	  m_staticMaxExtent(0),
+	  m_dynamicMaxExtent(0),
+	  m_staticDirty(false),
+	  m_dynamicDirty(false),
+	  m_pairsStale(false),
+	  m_pairsDirty(false)
+{
+	if (!m_pairCache)
+	{
+		void* mem = btAlignedAlloc(sizeof(btHashedOverlappingPairCache), 16);
+		m_pairCache = new (mem) btHashedOverlappingPairCache();
+		m_ownsPairCache = true;
+	}
+}
+
+btSapBroadphase::~btSapBroadphase()
+{
+	for (int i = 0; i < m_staticProxies.size(); i++)
+	{
+		m_staticProxies[i]->~btSapProxy();
+		btAlignedFree(m_staticProxies[i]);
+	}
+	for (int i = 0; i < m_dynamicProxies.size(); i++)
+	{
+		m_dynamicProxies[i]->~btSapProxy();
+		btAlignedFree(m_dynamicProxies[i]);
+	}
+	if (m_ownsPairCache)
+	{
+		m_pairCache->~btOverlappingPairCache();
+		btAlignedFree(m_pairCache);
+	}
+}
+
+btBroadphaseProxy* btSapBroadphase::createProxy(const btVector3& aabbMin, const btVector3& aabbMax, int shapeType, void* userPtr, int collisionFilterGroup, int collisionFilterMask, btDispatcher* /*dispatcher*/)
+{
+	(void)shapeType;
+	void* mem = btAlignedAlloc(sizeof(btSapProxy), 16);
+	btSapProxy* proxy = new (mem) btSapProxy(aabbMin, aabbMax, userPtr, collisionFilterGroup, collisionFilterMask);
+	proxy->m_uniqueId = ++m_uniqueId;
+	proxy->m_static = (collisionFilterGroup & m_staticGroup) != 0;
+	btAlignedObjectArray<btSapProxy*>& set = proxy->m_static ? m_staticProxies : m_dynamicProxies;
+	proxy->m_index = set.size();
+	set.push_back(proxy);
+	(proxy->m_static ? m_staticDirty : m_dynamicDirty) = true;
+	m_pairsStale = true;
+	return proxy;
+}
+
+void btSapBroadphase::destroyProxy(btBroadphaseProxy* absproxy, btDispatcher* dispatcher)
+{
+	btSapProxy* proxy = static_cast<btSapProxy*>(absproxy);
+	m_pairCache->removeOverlappingPairsContainingProxy(proxy, dispatcher);
+
+	btAlignedObjectArray<btSapProxy*>& set = proxy->m_static ? m_staticProxies : m_dynamicProxies;
+	const int index = proxy->m_index;
+	set[index] = set[set.size() - 1];
+	set[index]->m_index = index;
+	set.pop_back();
+	(proxy->m_static ? m_staticDirty : m_dynamicDirty) = true;
+	m_pairsStale = true;
+
+	proxy->~btSapProxy();
+	btAlignedFree(proxy);
+}
+
+void btSapBroadphase::setAabb(btBroadphaseProxy* absproxy, const btVector3& aabbMin, const btVector3& aabbMax, btDispatcher* /*dispatcher*/)
+{
+	btSapProxy* proxy = static_cast<btSapProxy*>(absproxy);
+	proxy->m_aabbMin = aabbMin;
+	proxy->m_aabbMax = aabbMax;
+	(proxy->m_static ? m_staticDirty : m_dynamicDirty) = true;
+	m_pairsStale = true;
+	m_pairsDirty = true;
+}
+
+void btSapBroadphase::getAabb(btBroadphaseProxy* proxy, btVector3& aabbMin, btVector3& aabbMax) const
+{
+	aabbMin = proxy->m_aabbMin;
+	aabbMax = proxy->m_aabbMax;
+}
+
+bool btSapBroadphase::needsAabbUpdate(const btBroadphaseProxy* proxy, const btVector3& aabbMin, const btVector3& aabbMax) const
+{
+	//pairs are rebuilt from the exact boxes, so only an unchanged box can be skipped
+	return !(aabbMin == proxy->m_aabbMin && aabbMax == proxy->m_aabbMax);
+}
+
+void btSapBroadphase::sortSet(const btAlignedObjectArray<btSapProxy*>& proxies, btAlignedObjectArray<btSapEntry>& entries, btAlignedObjectArray<btSapProxy*>& sorted, btScalar& maxExtent)
+{
+	const int n = proxies.size();
+	entries.resizeNoInitialize(n);
+	sorted.resizeNoInitialize(n);
+	maxExtent = 0;
+	if (n == 0)
+		return;
+
+	m_keys[0].resizeNoInitialize(n);
+	m_keys[1].resizeNoInitialize(n);
+	m_order[0].resizeNoInitialize(n);
+	m_order[1].resizeNoInitialize(n);
+	for (int i = 0; i < n; i++)
+	{
+		m_keys[0][i] = sapSortKey(proxies[i]->m_aabbMin[m_axis]);
+		m_order[0][i] = i;
+	}
+
+	//LSD radix sort, three passes of 11 bits. Stable, so equal boxes keep their set order and the result is reproducible.
+	int src = 0;
+	for (int shift = 0; shift < 32; shift += 11)
+	{
+		int counts[2048];
+		memset(counts, 0, sizeof(counts));
+		const unsigned int* keys = &m_keys[src][0];
+		for (int i = 0; i < n; i++)
+			counts[(keys[i] >> shift) & 2047]++;
+		int sum = 0;
+		for (int b = 0; b < 2048; b++)
+		{
+			const int c = counts[b];
+			counts[b] = sum;
+			sum += c;
+		}
+		const int* order = &m_order[src][0];
+		unsigned int* keysOut = &m_keys[1 - src][0];
+		int* orderOut = &m_order[1 - src][0];
+		for (int i = 0; i < n; i++)
+		{
+			const int dst = counts[(keys[i] >> shift) & 2047]++;
+			keysOut[dst] = keys[i];
+			orderOut[dst] = order[i];
+		}
+		src = 1 - src;
+	}
+
+	for (int i = 0; i < n; i++)
+	{
+		btSapProxy* proxy = proxies[m_order[src][i]];
+		sorted[i] = proxy;
+		sapFillEntry(entries[i], proxy->m_aabbMin, proxy->m_aabbMax, m_axis, proxy->m_collisionFilterGroup, proxy->m_collisionFilterMask);
+		maxExtent = btMax(maxExtent, entries[i].m_max - entries[i].m_min);
+	}
+}
+
+void btSapBroadphase::chooseAxis()
+{
+	const int n = m_dynamicProxies.size();
+	if (n < 2)
+		return;
+
+	btVector3 sum(0, 0, 0), sumSq(0, 0, 0);
+	for (int i = 0; i < n; i++)
+	{
+		const btVector3 center = (m_dynamicProxies[i]->m_aabbMin + m_dynamicProxies[i]->m_aabbMax) * btScalar(0.5);
+		sum += center;
+		sumSq += center * center;
+	}
+	const btVector3 variance = sumSq / btScalar(n) - (sum / btScalar(n)) * (sum / btScalar(n));
+	const int best = variance.maxAxis();
+	//only switch for a clear win, every switch re-sorts the static set too
+	if (best != m_axis && variance[best] > variance[m_axis] * btScalar(1.5))
+	{
+		m_axis = best;
+		m_dynamicDirty = true;
+		m_staticDirty = true;
+	}
+}
+
+void btSapBroadphase::updateSets()
+{
+	if (m_dynamicDirty)
+	{
+		sortSet(m_dynamicProxies, m_dynamicEntries, m_dynamicSorted, m_dynamicMaxExtent);
+	}
+	if (m_staticDirty)
+	{
+		sortSet(m_staticProxies, m_staticEntries, m_staticSorted, m_staticMaxExtent);
+	}
+	m_dynamicDirty = false;
+	m_staticDirty = false;
+}
+
+struct btSapRemoveSeparatedPairs : public btOverlapCallback
+{
+	virtual bool processOverlap(btBroadphasePair& pair)
+	{
+		return !TestAabbAgainstAabb2(pair.m_pProxy0->m_aabbMin, pair.m_pProxy0->m_aabbMax, pair.m_pProxy1->m_aabbMin, pair.m_pProxy1->m_aabbMax);
+	}
+};
+
+void btSapBroadphase::calculateOverlappingPairs(btDispatcher* dispatcher)
+{
+	if (!m_pairsStale)
+		return;
+	m_pairsStale = false;
+	//the axis only changes here, once per step. Queries between steps differ between peers (client raycasts, resims)
+	//and must not decide when the pair order changes
+	chooseAxis();
+	updateSets();
+
+	const int numDynamic = m_dynamicEntries.size();
+	const int numStatic = m_staticEntries.size();
+	if (numDynamic == 0 && !m_pairsDirty)
+		return;
+
+	//fixed chunk boundaries, so the merged pair order doesn't depend on the thread count
+	const int dynamicChunks = btMin<int>(MAX_CHUNKS, (numDynamic + MIN_CHUNK_SIZE - 1) / MIN_CHUNK_SIZE);
+	const int staticChunks = numDynamic ? btMin<int>(MAX_CHUNKS, (numStatic + MIN_CHUNK_SIZE - 1) / MIN_CHUNK_SIZE) : 0;
+	const int numTasks = dynamicChunks * 2 + staticChunks;
+
+	struct SweepBody : public btIParallelForBody
+	{
+		btSapBroadphase* m_bp;
+		int m_dynamicChunks;
+		int m_staticChunks;
+
+		virtual void forLoop(int iBegin, int iEnd) const
+		{
+			const btSapEntry* dynamicEntries = m_bp->m_dynamicEntries.size() ? &m_bp->m_dynamicEntries[0] : 0;
+			const btSapEntry* staticEntries = m_bp->m_staticEntries.size() ? &m_bp->m_staticEntries[0] : 0;
+			const int numDynamic = m_bp->m_dynamicEntries.size();
+			const int numStatic = m_bp->m_staticEntries.size();
+			for (int task = iBegin; task < iEnd; task++)
+			{
+				btAlignedObjectArray<int>& pairs = m_bp->m_chunks[task].m_pairs;
+				pairs.resizeNoInitialize(0);
+				if (task < m_dynamicChunks)
+				{
+					const int c = task;
+					sapSweepSelf(dynamicEntries, numDynamic, c * numDynamic / m_dynamicChunks, (c + 1) * numDynamic / m_dynamicChunks, pairs);
+				}
+				else if (task < m_dynamicChunks * 2)
+				{
+					const int c = task - m_dynamicChunks;
+					sapSweepAgainst(dynamicEntries, c * numDynamic / m_dynamicChunks, (c + 1) * numDynamic / m_dynamicChunks, staticEntries, numStatic, false, true, false, pairs);
+				}
+				else
+				{
+					const int c = task - m_dynamicChunks * 2;
+					sapSweepAgainst(staticEntries, c * numStatic / m_staticChunks, (c + 1) * numStatic / m_staticChunks, dynamicEntries, numDynamic, true, true, true, pairs);
+				}
+			}
+		}
+	};
+	SweepBody body;
+	body.m_bp = this;
+	body.m_dynamicChunks = dynamicChunks;
+	body.m_staticChunks = staticChunks;
+	if (numTasks > 0)
+		btParallelFor(0, numTasks, 1, body);
+
+	//the pair cache isn't thread safe, and adding in chunk order keeps it reproducible
+	for (int task = 0; task < numTasks; task++)
+	{
+		const btAlignedObjectArray<int>& pairs = m_chunks[task].m_pairs;
+		btSapProxy** first = &m_dynamicSorted[0];
+		btSapProxy** second = task < dynamicChunks ? first : (numStatic ? &m_staticSorted[0] : 0);
+		for (int p = 0; p < pairs.size(); p += 2)
+		{
+			m_pairCache->addOverlappingPair(first[pairs[p]], second[pairs[p + 1]]);
+		}
+	}
+
+	if (m_pairsDirty && m_pairCache->getNumOverlappingPairs())
+	{
+		btSapRemoveSeparatedPairs removeSeparated;
+		m_pairCache->processAllOverlappingPairs(&removeSeparated, dispatcher);
+	}
+	m_pairsDirty = false;
+}
+
+//Every proxy whose box can overlap [lo, hi] on the sweep axis, moving set first, each in sorted order
+template <typename Visitor>
+void btSapBroadphase::visitRange(btScalar lo, btScalar hi, Visitor& visitor)
+{
+	//queries can come between steps, after bodies were added or moved
+	updateSets();
+	const btAlignedObjectArray<btSapEntry>* sets[2] = {&m_dynamicEntries, &m_staticEntries};
+	const btAlignedObjectArray<btSapProxy*>* sorted[2] = {&m_dynamicSorted, &m_staticSorted};
+	const btScalar maxExtent[2] = {m_dynamicMaxExtent, m_staticMaxExtent};
+	for (int s = 0; s < 2; s++)
+	{
+		const btAlignedObjectArray<btSapEntry>& entries = *sets[s];
+		//a box that starts before lo - maxExtent ends before lo
+		const btScalar first = lo - maxExtent[s];
+		int begin = 0, end = entries.size();
+		while (begin < end)
+		{
+			const int mid = (begin + end) >> 1;
+			if (entries[mid].m_min < first)
+				begin = mid + 1;
+			else
+				end = mid;
+		}
+		for (int i = begin; i < entries.size() && entries[i].m_min <= hi; i++)
+		{
+			if (entries[i].m_max >= lo)
+				visitor((*sorted[s])[i]);
+		}
+	}
+}
+
+void btSapBroadphase::aabbTest(const btVector3& aabbMin, const btVector3& aabbMax, btBroadphaseAabbCallback& callback)
+{
+	struct Visitor
+	{
+		const btVector3* m_aabbMin;
+		const btVector3* m_aabbMax;
+		btBroadphaseAabbCallback* m_callback;
+		void operator()(btSapProxy* proxy)
+		{
+			if (TestAabbAgainstAabb2(*m_aabbMin, *m_aabbMax, proxy->m_aabbMin, proxy->m_aabbMax))
+				m_callback->process(proxy);
+		}
+	};
+	Visitor visitor;
+	visitor.m_aabbMin = &aabbMin;
+	visitor.m_aabbMax = &aabbMax;
+	visitor.m_callback = &callback;
+	visitRange(aabbMin[m_axis], aabbMax[m_axis], visitor);
+}
+
+void btSapBroadphase::aabbTestBatch(const btVector3* aabbMins, const btVector3* aabbMaxs, int numAabbs, btBroadphaseAabbBatchCallback& callback)
+{
+	if (numAabbs <= 0)
+		return;
+	//queries can come between steps, after bodies were added or moved
+	updateSets();
+
+	btAlignedObjectArray<btSapEntry> queries;
+	btAlignedObjectArray<int> order;
+	queries.resizeNoInitialize(numAabbs);
+	order.resizeNoInitialize(numAabbs);
+	m_keys[0].resizeNoInitialize(numAabbs);
+	for (int i = 0; i < numAabbs; i++)
+	{
+		m_keys[0][i] = sapSortKey(aabbMins[i][m_axis]);
+		order[i] = i;
+	}
+	//there are rarely many queries, a comparison sort is fine here
+	struct KeyLess
+	{
+		const unsigned int* m_keys;
+		bool operator()(int a, int b) const { return m_keys[a] != m_keys[b] ? m_keys[a] < m_keys[b] : a < b; }
+	};
+	KeyLess less;
+	less.m_keys = &m_keys[0][0];
+	order.quickSort(less);
+	for (int i = 0; i < numAabbs; i++)
+	{
+		sapFillEntry(queries[i], aabbMins[order[i]], aabbMaxs[order[i]], m_axis, -1, -1);
+	}
+
+	btAlignedObjectArray<int>& pairs = m_chunks[0].m_pairs;
+	const btAlignedObjectArray<btSapEntry>* sets[2] = {&m_dynamicEntries, &m_staticEntries};
+	const btAlignedObjectArray<btSapProxy*>* sorted[2] = {&m_dynamicSorted, &m_staticSorted};
+	for (int s = 0; s < 2; s++)
+	{
+		const int numEntries = sets[s]->size();
+		if (!numEntries)
+			continue;
+		pairs.resizeNoInitialize(0);
+		sapSweepAgainst(&queries[0], 0, numAabbs, &(*sets[s])[0], numEntries, false, false, false, pairs);
+		sapSweepAgainst(&(*sets[s])[0], 0, numEntries, &queries[0], numAabbs, true, false, true, pairs);
+		for (int p = 0; p < pairs.size(); p += 2)
+		{
+			callback.process(order[pairs[p]], (*sorted[s])[pairs[p + 1]]);
+		}
+	}
+}
+
+void btSapBroadphase::rayTest(const btVector3& rayFrom, const btVector3& rayTo, btBroadphaseRayCallback& rayCallback, const btVector3& aabbMin, const btVector3& aabbMax)
+{
+	struct Visitor
+	{
+		const btVector3* m_rayFrom;
+		const btVector3* m_aabbMin;
+		const btVector3* m_aabbMax;
+		btBroadphaseRayCallback* m_callback;
+		void operator()(btSapProxy* proxy)
+		{
+			//grown by the swept box like btDbvt::rayTestInternal, so convex casts go through here too
+			btVector3 bounds[2];
+			bounds[0] = proxy->m_aabbMin - *m_aabbMax;
+			bounds[1] = proxy->m_aabbMax - *m_aabbMin;
+			btScalar tmin = 1.f;
+			if (btRayAabb2(*m_rayFrom, m_callback->m_rayDirectionInverse, m_callback->m_signs, bounds, tmin, 0, m_callback->m_lambda_max))
+				m_callback->process(proxy);
+		}
+	};
+	Visitor visitor;
+	visitor.m_rayFrom = &rayFrom;
+	visitor.m_aabbMin = &aabbMin;
+	visitor.m_aabbMax = &aabbMax;
+	visitor.m_callback = &rayCallback;
+	//the segment from rayFrom to rayTo, grown by the swept box
+	visitRange(btMin(rayFrom[m_axis], rayTo[m_axis]) + aabbMin[m_axis], btMax(rayFrom[m_axis], rayTo[m_axis]) + aabbMax[m_axis], visitor);
+}
+
+void btSapBroadphase::resetPool(btDispatcher* /*dispatcher*/)
+{
+	//ids order the proxies in every pair, so restart them once the broadphase is empty again
+	if (m_staticProxies.size() == 0 && m_dynamicProxies.size() == 0)
+	{
+		m_uniqueId = 0;
+		m_axis = 0;
+	}
+}
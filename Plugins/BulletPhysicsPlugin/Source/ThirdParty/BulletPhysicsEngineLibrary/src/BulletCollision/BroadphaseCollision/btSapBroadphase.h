@@ -0,0 +1,157 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2009 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_SAP_BROADPHASE_H
+#define BT_SAP_BROADPHASE_H
+
+#include "btOverlappingPairCache.h"
+#include "LinearMath/btAlignedObjectArray.h"
+
+struct btSapProxy : public btBroadphaseProxy
+{
+	//slot in m_staticProxies or m_dynamicProxies
+	int m_index;
+	bool m_static;
+
+	btSapProxy(const btVector3& aabbMin, const btVector3& aabbMax, void* userPtr, int collisionFilterGroup, int collisionFilterMask)
+		: btBroadphaseProxy(aabbMin, aabbMax, userPtr, collisionFilterGroup, collisionFilterMask),
+		  m_index(-1),
+		  m_static(false)
+	{
+	}
+};
+
+///One box of a sorted set. The two off-axis extents are packed so that a single 4-wide compare tests both of them.
+ATTRIBUTE_ALIGNED16(struct)
+btSapEntry
+{
+	//{min1, min2, -max1, -max2} of the two axes that aren't swept
+	btScalar m_offAxis[4];
+	btScalar m_min;
+	btScalar m_max;
+	int m_group;
+	int m_mask;
+};
+
+///btSapBroadphase is a sort-and-sweep broadphase that rebuilds its pairs every step instead of updating them incrementally,
+///which suits many small, fast bodies in a bounded space better than the dbvt (no tree refits or rebalancing).
+///Moving proxies are radix sorted along the axis their centers spread the most on and swept against each other; proxies in
+///the static group sit in a second set that is only re-sorted when one of them changes, and are swept against the moving
+///ones with a two-sided pass. Neither set ever pairs a static proxy with another static one. The axis is only picked in
+///calculateOverlappingPairs; queries between steps re-sort on the current one, so they can't change the pair order.
+///The sweeps run through btParallelFor in fixed chunks whose pairs are merged in chunk order, so the pair cache sees the
+///same sequence of adds and removes on every machine and thread count. Group/mask filtering happens in the sweep, the pair
+///cache's overlap filter callback is still asked about every pair that passes it.
+class btSapBroadphase : public btBroadphaseInterface
+{
+public:
+	enum
+	{
+		MAX_CHUNKS = 64,
+		MIN_CHUNK_SIZE = 64
+	};
+
+	///Proxies whose group has any of the staticGroup bits go to the static set
+	btSapBroadphase(int staticGroup = btBroadphaseProxy::StaticFilter, btOverlappingPairCache* overlappingPairCache = 0);
+	virtual ~btSapBroadphase();
+
+	virtual btBroadphaseProxy* createProxy(const btVector3& aabbMin, const btVector3& aabbMax, int shapeType, void* userPtr, int collisionFilterGroup, int collisionFilterMask, btDispatcher* dispatcher);
+	virtual void destroyProxy(btBroadphaseProxy* proxy, btDispatcher* dispatcher);
+	virtual void setAabb(btBroadphaseProxy* proxy, const btVector3& aabbMin, const btVector3& aabbMax, btDispatcher* dispatcher);
+	virtual void getAabb(btBroadphaseProxy* proxy, btVector3& aabbMin, btVector3& aabbMax) const;
+	virtual bool needsAabbUpdate(const btBroadphaseProxy* proxy, const btVector3& aabbMin, const btVector3& aabbMax) const;
+
+	///Rays and single boxes only test the slice of each sorted set that can reach them on the sweep axis: from the query's
+	///start minus the longest box in the set, up to its end. One huge box in a set (a terrain in the static group, say)
+	///widens that slice for the whole set, and a ray along the sweep axis still covers every box along its length.
+	///Many boxes at once should go through aabbTestBatch.
+	virtual void rayTest(const btVector3& rayFrom, const btVector3& rayTo, btBroadphaseRayCallback& rayCallback, const btVector3& aabbMin = btVector3(0, 0, 0), const btVector3& aabbMax = btVector3(0, 0, 0));
+	virtual void aabbTest(const btVector3& aabbMin, const btVector3& aabbMax, btBroadphaseAabbCallback& callback);
+	///sorts the boxes and sweeps them against both sets, instead of a linear scan per box
+	virtual void aabbTestBatch(const btVector3* aabbMins, const btVector3* aabbMaxs, int numAabbs, btBroadphaseAabbBatchCallback& callback);
+
+	virtual void calculateOverlappingPairs(btDispatcher* dispatcher);
+
+	virtual btOverlappingPairCache* getOverlappingPairCache()
+	{
+		return m_pairCache;
+	}
+	virtual const btOverlappingPairCache* getOverlappingPairCache() const
+	{
+		return m_pairCache;
+	}
+
+	virtual void getBroadphaseAabb(btVector3& aabbMin, btVector3& aabbMax) const
+	{
+		aabbMin.setValue(-BT_LARGE_FLOAT, -BT_LARGE_FLOAT, -BT_LARGE_FLOAT);
+		aabbMax.setValue(BT_LARGE_FLOAT, BT_LARGE_FLOAT, BT_LARGE_FLOAT);
+	}
+
+	virtual void resetPool(btDispatcher* dispatcher);
+
+	virtual void printStats() {}
+
+	int getSweepAxis() const
+	{
+		return m_axis;
+	}
+
+private:
+	struct Chunk
+	{
+		//pairs as indices into the two sorted sets (or both into the moving set)
+		btAlignedObjectArray<int> m_pairs;
+	};
+
+	void sortSet(const btAlignedObjectArray<btSapProxy*>& proxies, btAlignedObjectArray<btSapEntry>& entries, btAlignedObjectArray<btSapProxy*>& sorted, btScalar& maxExtent);
+	template <typename Visitor>
+	void visitRange(btScalar lo, btScalar hi, Visitor& visitor);
+	void updateSets();
+	void chooseAxis();
+
+	btOverlappingPairCache* m_pairCache;
+	bool m_ownsPairCache;
+	int m_staticGroup;
+	int m_uniqueId;
+	int m_axis;
+
+	btAlignedObjectArray<btSapProxy*> m_staticProxies;
+	btAlignedObjectArray<btSapProxy*> m_dynamicProxies;
+	//sorted by m_min, with the proxy of each entry alongside
+	btAlignedObjectArray<btSapEntry> m_staticEntries;
+	btAlignedObjectArray<btSapProxy*> m_staticSorted;
+	btAlignedObjectArray<btSapEntry> m_dynamicEntries;
+	btAlignedObjectArray<btSapProxy*> m_dynamicSorted;
+	//longest box of each set along the sweep axis, bounds how far before a query a box can start and still reach it
+	btScalar m_staticMaxExtent;
+	btScalar m_dynamicMaxExtent;
+	//the set has to be sorted again before it is swept
+	bool m_staticDirty;
+	bool m_dynamicDirty;
+	//a proxy was added, moved or removed since the last calculateOverlappingPairs. Kept apart from the dirty flags above
+	//because queries sort the sets between steps too, which must not make the next step skip its pairs.
+	bool m_pairsStale;
+	//a box moved since the last calculateOverlappingPairs, so pairs may have to go
+	bool m_pairsDirty;
+
+	//radix sort scratch
+	btAlignedObjectArray<unsigned int> m_keys[2];
+	btAlignedObjectArray<int> m_order[2];
+
+	//moving-moving, moving-static and static-moving sweeps
+	Chunk m_chunks[MAX_CHUNKS * 3];
+};
+
+#endif  //BT_SAP_BROADPHASE_H
@@ -0,0 +1,208 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2006 Erwin Coumans  https://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose, 
+including commercial applications, and to alter it and redistribute it freely, 
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "btCapsuleBoxCollisionAlgorithm.h"
+#include "BulletCollision/CollisionDispatch/btCollisionDispatcher.h"
+#include "BulletCollision/CollisionShapes/btSphereShape.h"
+#include "BulletCollision/CollisionShapes/btCapsuleShape.h"
+#include "BulletCollision/CollisionShapes/btBoxShape.h"
+#include "BulletCollision/CollisionDispatch/btCollisionObject.h"
+#include "BulletCollision/CollisionDispatch/btCollisionObjectWrapper.h"
+
+//golden section steps along the segment, the bracket shrinks to 0.618^20 (less than 1e-4) of the capsule length
+#define BT_CAPSULE_BOX_SEARCH_STEPS 20
+
+btCapsuleBoxCollisionAlgorithm::btCapsuleBoxCollisionAlgorithm(btPersistentManifold* mf, const btCollisionAlgorithmConstructionInfo& ci, const btCollisionObjectWrapper* col0Wrap, const btCollisionObjectWrapper* col1Wrap, bool isSwapped)
+	: btActivatingCollisionAlgorithm(ci, col0Wrap, col1Wrap),
+	  m_ownManifold(false),
+	  m_manifoldPtr(mf),
+	  m_isSwapped(isSwapped)
+{
+	const btCollisionObjectWrapper* capsuleObjWrap = m_isSwapped ? col1Wrap : col0Wrap;
+	const btCollisionObjectWrapper* boxObjWrap = m_isSwapped ? col0Wrap : col1Wrap;
+
+	if (!m_manifoldPtr && m_dispatcher->needsCollision(capsuleObjWrap->getCollisionObject(), boxObjWrap->getCollisionObject()))
+	{
+		m_manifoldPtr = m_dispatcher->getNewManifold(capsuleObjWrap->getCollisionObject(), boxObjWrap->getCollisionObject());
+		m_ownManifold = true;
+	}
+}
+
+btCapsuleBoxCollisionAlgorithm::~btCapsuleBoxCollisionAlgorithm()
+{
+	if (m_ownManifold)
+	{
+		if (m_manifoldPtr)
+			m_dispatcher->releaseManifold(m_manifoldPtr);
+	}
+}
+
+btScalar btCapsuleBoxCollisionAlgorithm::pointBoxDistance(const btVector3& halfExtents, const btVector3& point, btVector3& pointOnBox, btVector3& normal)
+{
+	btVector3 clamped(btClamped(point.getX(), -halfExtents.getX(), halfExtents.getX()),
+					  btClamped(point.getY(), -halfExtents.getY(), halfExtents.getY()),
+					  btClamped(point.getZ(), -halfExtents.getZ(), halfExtents.getZ()));
+	btVector3 diff = point - clamped;
+	btScalar dist2 = diff.length2();
+	if (dist2 > btScalar(0))
+	{
+		btScalar dist = btSqrt(dist2);
+		pointOnBox = clamped;
+		normal = diff / dist;
+		return dist;
+	}
+
+	//inside, leave through the closest face
+	int axis = 0;
+	btScalar faceDist = halfExtents[0] - btFabs(point[0]);
+	for (int i = 1; i < 3; i++)
+	{
+		btScalar d = halfExtents[i] - btFabs(point[i]);
+		if (d < faceDist)
+		{
+			faceDist = d;
+			axis = i;
+		}
+	}
+	normal.setValue(0, 0, 0);
+	normal[axis] = point[axis] < 0 ? btScalar(-1) : btScalar(1);
+	pointOnBox = point;
+	pointOnBox[axis] = normal[axis] * halfExtents[axis];
+	return -faceDist;
+}
+
+void btCapsuleBoxCollisionAlgorithm::addContact(const btTransform& boxTrans, const btVector3& boxHalfExtents, btScalar boxMargin, const btVector3& pointInBox, btScalar radius, btScalar maxContactDistance, bool boxIsB, btManifoldResult* resultOut)
+{
+	btVector3 pointOnBox, normal;
+	btScalar dist = pointBoxDistance(boxHalfExtents, pointInBox, pointOnBox, normal) - radius - boxMargin;
+	if (dist > maxContactDistance)
+		return;
+
+	btVector3 normalOnBox = boxTrans.getBasis() * normal;
+	btVector3 pointOnBoxWorld = boxTrans * pointOnBox + normalOnBox * boxMargin;
+	//addContactPoint wants the point on the manifold's second body, whichever order the result has
+	if (boxIsB)
+	{
+		resultOut->addContactPoint(normalOnBox, pointOnBoxWorld, dist);
+	}
+	else
+	{
+		resultOut->addContactPoint(-normalOnBox, pointOnBoxWorld + normalOnBox * dist, dist);
+	}
+}
+
+void btCapsuleBoxCollisionAlgorithm::processCollision(const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap, const btDispatcherInfo& dispatchInfo, btManifoldResult* resultOut)
+{
+	(void)dispatchInfo;
+	if (!m_manifoldPtr)
+		return;
+
+	const btCollisionObjectWrapper* capsuleObjWrap = m_isSwapped ? body1Wrap : body0Wrap;
+	const btCollisionObjectWrapper* boxObjWrap = m_isSwapped ? body0Wrap : body1Wrap;
+
+	const btTransform& capsuleTrans = capsuleObjWrap->getWorldTransform();
+	const btCollisionShape* shape = capsuleObjWrap->getCollisionShape();
+	btScalar radius;
+	btScalar halfHeight = 0;
+	btVector3 axis(0, 0, 0);
+	if (shape->getShapeType() == CAPSULE_SHAPE_PROXYTYPE)
+	{
+		const btCapsuleShape* capsule = (const btCapsuleShape*)shape;
+		radius = capsule->getRadius();
+		halfHeight = capsule->getHalfHeight();
+		axis = capsuleTrans.getBasis().getColumn(capsule->getUpAxis());
+	}
+	else
+	{
+		radius = ((const btSphereShape*)shape)->getRadius();
+	}
+
+	//like GJK, the box is its core with the margin rounded around it
+	const btBoxShape* box = (const btBoxShape*)boxObjWrap->getCollisionShape();
+	const btVector3& halfExtents = box->getHalfExtentsWithoutMargin();
+	const btScalar margin = box->getMargin();
+	const btTransform& boxTrans = boxObjWrap->getWorldTransform();
+	const btScalar maxContactDistance = m_manifoldPtr->getContactBreakingThreshold();
+	const bool boxIsB = m_manifoldPtr->getBody0() == capsuleObjWrap->getCollisionObject();
+
+	resultOut->setPersistentManifold(m_manifoldPtr);
+
+	//the segment in the box's space
+	const btVector3 from = boxTrans.invXform(capsuleTrans.getOrigin() - axis * halfHeight);
+	const btVector3 to = boxTrans.invXform(capsuleTrans.getOrigin() + axis * halfHeight);
+	if (halfHeight <= btScalar(0))
+	{
+		addContact(boxTrans, halfExtents, margin, from, radius, maxContactDistance, boxIsB, resultOut);
+	}
+	else
+	{
+		const btVector3 delta = to - from;
+		const btScalar invPhi = btScalar(0.6180339887498949);
+		btVector3 pointOnBox, normal;
+		btScalar lo = 0;
+		btScalar hi = 1;
+		btScalar t0 = hi - invPhi;
+		btScalar t1 = lo + invPhi;
+		btScalar d0 = pointBoxDistance(halfExtents, from + delta * t0, pointOnBox, normal);
+		btScalar d1 = pointBoxDistance(halfExtents, from + delta * t1, pointOnBox, normal);
+		for (int i = 0; i < BT_CAPSULE_BOX_SEARCH_STEPS; i++)
+		{
+			if (d0 < d1)
+			{
+				hi = t1;
+				t1 = t0;
+				d1 = d0;
+				t0 = hi - invPhi * (hi - lo);
+				d0 = pointBoxDistance(halfExtents, from + delta * t0, pointOnBox, normal);
+			}
+			else
+			{
+				lo = t0;
+				t0 = t1;
+				d0 = d1;
+				t1 = lo + invPhi * (hi - lo);
+				d1 = pointBoxDistance(halfExtents, from + delta * t1, pointOnBox, normal);
+			}
+		}
+		const btScalar t = (lo + hi) * btScalar(0.5);
+		addContact(boxTrans, halfExtents, margin, from + delta * t, radius, maxContactDistance, boxIsB, resultOut);
+
+		//the ends, unless the deepest point is (about) one of them
+		const btScalar endSpacing = radius / (2 * halfHeight);
+		if (t > endSpacing)
+			addContact(boxTrans, halfExtents, margin, from, radius, maxContactDistance, boxIsB, resultOut);
+		if (t < 1 - endSpacing)
+			addContact(boxTrans, halfExtents, margin, to, radius, maxContactDistance, boxIsB, resultOut);
+	}
+
+	if (m_ownManifold)
+	{
+		if (m_manifoldPtr->getNumContacts())
+		{
+			resultOut->refreshContactPoints();
+		}
+	}
+}
+
+btScalar btCapsuleBoxCollisionAlgorithm::calculateTimeOfImpact(btCollisionObject* col0, btCollisionObject* col1, const btDispatcherInfo& dispatchInfo, btManifoldResult* resultOut)
+{
+	(void)resultOut;
+	(void)dispatchInfo;
+	(void)col0;
+	(void)col1;
+
+	//not yet
+	return btScalar(1.);
+}
@@ -0,0 +1,71 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2006 Erwin Coumans  https://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose, 
+including commercial applications, and to alter it and redistribute it freely, 
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_CAPSULE_BOX_COLLISION_ALGORITHM_H
+#define BT_CAPSULE_BOX_COLLISION_ALGORITHM_H
+
+#include "btActivatingCollisionAlgorithm.h"
+#include "BulletCollision/BroadphaseCollision/btBroadphaseProxy.h"
+#include "BulletCollision/CollisionDispatch/btCollisionCreateFunc.h"
+class btPersistentManifold;
+#include "btCollisionDispatcher.h"
+
+#include "LinearMath/btVector3.h"
+
+/// btCapsuleBoxCollisionAlgorithm provides analytic capsule-box and sphere-box collision detection, a sphere being a
+/// capsule with a zero length segment. The box is treated like GJK does, its core rounded by the margin, so the contacts
+/// match the convex-convex algorithm. The signed distance from a point to a box is convex, so its minimum along the
+/// capsule segment is found with a golden section search instead of GJK/EPA. Next to the deepest point the segment
+/// ends are reported when they are in range, so a capsule lying on a face gets a stable contact right away.
+class btCapsuleBoxCollisionAlgorithm : public btActivatingCollisionAlgorithm
+{
+	bool m_ownManifold;
+	btPersistentManifold* m_manifoldPtr;
+	bool m_isSwapped;
+
+	void addContact(const btTransform& boxTrans, const btVector3& boxHalfExtents, btScalar boxMargin, const btVector3& pointInBox, btScalar radius, btScalar maxContactDistance, bool boxIsB, btManifoldResult* resultOut);
+
+public:
+	btCapsuleBoxCollisionAlgorithm(btPersistentManifold* mf, const btCollisionAlgorithmConstructionInfo& ci, const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap, bool isSwapped);
+
+	virtual ~btCapsuleBoxCollisionAlgorithm();
+
+	virtual void processCollision(const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap, const btDispatcherInfo& dispatchInfo, btManifoldResult* resultOut);
+
+	virtual btScalar calculateTimeOfImpact(btCollisionObject* body0, btCollisionObject* body1, const btDispatcherInfo& dispatchInfo, btManifoldResult* resultOut);
+
+	virtual void getAllContactManifolds(btManifoldArray& manifoldArray)
+	{
+		if (m_manifoldPtr && m_ownManifold)
+		{
+			manifoldArray.push_back(m_manifoldPtr);
+		}
+	}
+
+	///signed distance from a point to a box centered at the origin, with the closest point on the surface and the
+	///outward normal there. Points inside leave through the nearest face and get a negative distance.
+	static btScalar pointBoxDistance(const btVector3& halfExtents, const btVector3& point, btVector3& pointOnBox, btVector3& normal);
+
+	struct CreateFunc : public btCollisionAlgorithmCreateFunc
+	{
+		virtual btCollisionAlgorithm* CreateCollisionAlgorithm(btCollisionAlgorithmConstructionInfo& ci, const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap)
+		{
+			void* mem = ci.m_dispatcher1->allocateCollisionAlgorithm(sizeof(btCapsuleBoxCollisionAlgorithm));
+			return new (mem) btCapsuleBoxCollisionAlgorithm(0, ci, body0Wrap, body1Wrap, m_swapped);
+		}
+	};
+};
+
+#endif  //BT_CAPSULE_BOX_COLLISION_ALGORITHM_H
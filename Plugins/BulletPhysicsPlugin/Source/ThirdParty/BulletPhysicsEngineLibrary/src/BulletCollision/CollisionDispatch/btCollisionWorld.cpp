@@ -23,6 +23,7 @@ subject to the following restrictions:
 #include "BulletCollision/CollisionShapes/btBvhTriangleMeshShape.h"        //for raycasting
 #include "BulletCollision/CollisionShapes/btScaledBvhTriangleMeshShape.h"  //for raycasting
 #include "BulletCollision/CollisionShapes/btHeightfieldTerrainShape.h"     //for raycasting
+#include "BulletCollision/CollisionShapes/btSdfCollisionShape.h"           //for raycasting
 #include "BulletCollision/NarrowPhaseCollision/btRaycastCallback.h"
 #include "BulletCollision/CollisionShapes/btCompoundShape.h"
 #include "BulletCollision/NarrowPhaseCollision/btSubSimplexConvexCast.h"
@@ -68,7 +69,9 @@ btCollisionWorld::btCollisionWorld(btDispatcher* dispatcher, btBroadphaseInterfa
 	: m_dispatcher1(dispatcher),
 	  m_broadphasePairCache(pairCache),
 	  m_debugDrawer(0),
-	  m_forceUpdateAllAabbs(true)
+	  m_forceUpdateAllAabbs(true),
+	  m_numAabbUpdates(0),
+	  m_numAabbSkips(0)
 {
 }
 
@@ -174,7 +177,19 @@ void btCollisionWorld::updateSingleAabb(btCollisionObject* colObj)
 	//moving objects should be moderately sized, probably something wrong if not
 	if (colObj->isStaticObject() || ((maxAabb - minAabb).length2() < btScalar(1e12)))
 	{
-		bp->setAabb(colObj->getBroadphaseHandle(), minAabb, maxAabb, m_dispatcher1);
+		btBroadphaseProxy* proxy = colObj->getBroadphaseHandle();
+		if (bp->needsAabbUpdate(proxy, minAabb, maxAabb))
+		{
+			bp->setAabb(proxy, minAabb, maxAabb, m_dispatcher1);
+			m_numAabbUpdates++;
+		}
+		else
+		{
+			//keep the box queries see current, the broadphase structure stays as it is
+			proxy->m_aabbMin = minAabb;
+			proxy->m_aabbMax = maxAabb;
+			m_numAabbSkips++;
+		}
 	}
 	else
 	{
@@ -198,16 +213,22 @@ void btCollisionWorld::updateAabbs()
 {
 	BT_PROFILE("updateAabbs");
 
+	m_numAabbUpdates = 0;
+	m_numAabbSkips = 0;
 	for (int i = 0; i < m_collisionObjects.size(); i++)
 	{
 		btCollisionObject* colObj = m_collisionObjects[i];
 		btAssert(colObj->getWorldArrayIndex() == i);
 
-		//only update aabb of active objects
-		if (m_forceUpdateAllAabbs || colObj->isActive())
+		//only update aabb of active objects, static objects only move through an explicit updateSingleAabb
+		if (m_forceUpdateAllAabbs || (colObj->isActive() && !colObj->isStaticObject()))
 		{
 			updateSingleAabb(colObj);
 		}
+		else
+		{
+			m_numAabbSkips++;
+		}
 	}
 }
 
@@ -427,6 +448,22 @@ void btCollisionWorld::rayTestSingleInternal(const btTransform& rayFromTrans, co
 				rcb.m_hitFraction = resultCallback.m_closestHitFraction;
 				heightField->performRaycast(&rcb, rayFromLocal, rayToLocal);
 			}
+			else if (collisionShape->getShapeType() == SDF_SHAPE_PROXYTYPE)
+			{
+				///no triangles to test, march the field instead
+				const btSdfCollisionShape* sdfShape = (const btSdfCollisionShape*)collisionShape;
+				btScalar hitFraction;
+				btVector3 hitNormalLocal;
+				if (sdfShape->rayTest(rayFromLocal, rayToLocal, hitFraction, hitNormalLocal) && hitFraction < resultCallback.m_closestHitFraction)
+				{
+					btCollisionWorld::LocalRayResult rayResult(collisionObjectWrap->getCollisionObject(),
+															   0,
+															   (colObjWorldTransform.getBasis() * hitNormalLocal).normalized(),
+															   hitFraction);
+					bool normalInWorldSpace = true;
+					resultCallback.addSingleResult(rayResult, normalInWorldSpace);
+				}
+			}
 			else
 			{
 				//generic (slower) case
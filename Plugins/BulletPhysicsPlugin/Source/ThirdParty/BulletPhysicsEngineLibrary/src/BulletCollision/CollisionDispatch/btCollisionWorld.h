@@ -99,6 +99,10 @@ protected:
 	///it is true by default, because it is error-prone (setting the position of static objects wouldn't update their AABB)
 	bool m_forceUpdateAllAabbs;
 
+	///proxies updated and left alone by the last updateAabbs (statics, sleeping bodies and boxes the broadphase didn't need)
+	int m_numAabbUpdates;
+	int m_numAabbSkips;
+
 	void serializeCollisionObjects(btSerializer* serializer);
 
 	void serializeContactManifolds(btSerializer* serializer);
@@ -505,6 +509,14 @@ public:
 	{
 		m_forceUpdateAllAabbs = forceUpdateAllAabbs;
 	}
+	int getNumAabbUpdates() const
+	{
+		return m_numAabbUpdates;
+	}
+	int getNumAabbSkips() const
+	{
+		return m_numAabbSkips;
+	}
 
 	///Preliminary serialization test for Bullet 2.76. Loading those files requires a separate parser (Bullet/Demos/SerializeDemo)
 	virtual void serialize(btSerializer* serializer);
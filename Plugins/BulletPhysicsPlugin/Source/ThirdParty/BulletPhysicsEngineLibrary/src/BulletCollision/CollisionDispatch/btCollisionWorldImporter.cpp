@@ -459,10 +459,8 @@ btCollisionShape* btCollisionWorldImporter::convertCollisionShape(btCollisionSha
 #endif  //BT_USE_DOUBLE_PRECISION
 					}
 					btConvexHullShape* hullShape = createConvexHullShape();
-					for (i = 0; i < numPoints; i++)
-					{
-						hullShape->addPoint(tmpPoints[i]);
-					}
+					if (numPoints)
+						hullShape->setPoints(&tmpPoints[0].x(), numPoints);
 					hullShape->setMargin(bsd->m_collisionMargin);
 					//hullShape->initializePolyhedralFeatures();
 					shape = hullShape;
@@ -560,7 +558,9 @@ btCollisionShape* btCollisionWorldImporter::convertCollisionShape(btCollisionSha
 
 				btCollisionShapeData* cd = compoundData->m_childShapePtr[i].m_childShape;
 
-				btCollisionShape* childShape = convertCollisionShape(cd);
+				//children converted on their own already are shared instead of converted again
+				btCollisionShape** converted = m_shapeMap.find(cd);
+				btCollisionShape* childShape = converted ? *converted : convertCollisionShape(cd);
 				if (childShape)
 				{
 					btTransform localTransform;
@@ -23,6 +23,8 @@ subject to the following restrictions:
 #include "BulletCollision/NarrowPhaseCollision/btRaycastCallback.h"
 #include "BulletCollision/CollisionShapes/btTriangleShape.h"
 #include "BulletCollision/CollisionShapes/btSphereShape.h"
+#include "BulletCollision/CollisionShapes/btCapsuleShape.h"
+#include "BulletCollision/CollisionShapes/btPolyhedralConvexShape.h"
 #include "LinearMath/btIDebugDraw.h"
 #include "BulletCollision/NarrowPhaseCollision/btSubSimplexConvexCast.h"
 #include "BulletCollision/CollisionDispatch/btCollisionObjectWrapper.h"
@@ -217,74 +219,172 @@ void btConvexConcaveCollisionAlgorithm::clearCache()
 	m_btConvexTriangleCallback.clearCache();
 }
 
-void btConvexConcaveCollisionAlgorithm::processCollision(const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap, const btDispatcherInfo& dispatchInfo, btManifoldResult* resultOut)
+// One point of a convex shape, in the field's space, against the field. radius is how far the shape extends around it.
+static void addSdfContact(const btTransform& sdfTrans, const btVector3& pointInSdf, btScalar dist, const btVector3& gradient, btScalar radius, btScalar threshold, btManifoldResult* resultOut)
 {
-	BT_PROFILE("btConvexConcaveCollisionAlgorithm::processCollision");
+	dist -= radius;
+	// deep inside or far outside a sparse field there is no direction to push along
+	if (dist > threshold || gradient.length2() <= SIMD_EPSILON)
+	{
+		return;
+	}
+	const btVector3 normal = sdfTrans.getBasis() * gradient.normalized();
+	// the manifold is always (convex, sdf), so the point is on the field's surface and the normal points out of it
+	resultOut->addContactPoint(normal, sdfTrans * pointInSdf - normal * (dist + radius), dist);
+}
 
-	const btCollisionObjectWrapper* convexBodyWrap = m_isSwapped ? body1Wrap : body0Wrap;
-	const btCollisionObjectWrapper* triBodyWrap = m_isSwapped ? body0Wrap : body1Wrap;
+// Support points along a fixed set of directions, for when the field can't see the shape's centre: a sphere or
+// capsule wider than the band has its core where distances are clamped and the gradient is zero.
+static void addSdfSupportContacts(const btSdfCollisionShape* sdf, const btTransform& sdfTrans, const btTransform& convexInSdf, const btConvexShape* convex, btScalar threshold, btManifoldResult* resultOut)
+{
+	static const btScalar d = btSqrt(btScalar(1) / btScalar(3));
+	static const btVector3 directions[14] = {
+		btVector3(1, 0, 0), btVector3(-1, 0, 0), btVector3(0, 1, 0), btVector3(0, -1, 0), btVector3(0, 0, 1), btVector3(0, 0, -1),
+		btVector3(d, d, d), btVector3(d, d, -d), btVector3(d, -d, d), btVector3(d, -d, -d),
+		btVector3(-d, d, d), btVector3(-d, d, -d), btVector3(-d, -d, d), btVector3(-d, -d, -d)};
+	for (int i = 0; i < 14; i++)
+	{
+		const btVector3 support = convexInSdf * convex->localGetSupportingVertex(directions[i] * convexInSdf.getBasis());
+		btScalar dist;
+		btVector3 gradient;
+		if (sdf->queryPoint(support, dist, gradient))
+		{
+			addSdfContact(sdfTrans, support, dist, gradient, 0, threshold, resultOut);
+		}
+	}
+}
 
-	if (triBodyWrap->getCollisionShape()->isConcave())
+static void processSdfCollision(const btCollisionObjectWrapper* convexBodyWrap, const btCollisionObjectWrapper* sdfBodyWrap, btPersistentManifold* manifold, btManifoldResult* resultOut)
+{
+	const btSdfCollisionShape* sdf = static_cast<const btSdfCollisionShape*>(sdfBodyWrap->getCollisionShape());
+	const btConvexShape* convex = static_cast<const btConvexShape*>(convexBodyWrap->getCollisionShape());
+	const btTransform& sdfTrans = sdfBodyWrap->getWorldTransform();
+	const btTransform convexInSdf = sdfTrans.inverseTimes(convexBodyWrap->getWorldTransform());
+	const btScalar threshold = manifold->getContactBreakingThreshold() + resultOut->m_closestPointDistanceThreshold;
+	resultOut->setPersistentManifold(manifold);
+
+	// Bounding sphere first. Clamped distances are lower bounds, interpolation can be off by up to a cell.
+	// A centre outside the field's domain can still have vertices inside it.
+	btVector3 center;
+	btScalar boundingRadius;
+	convex->getBoundingSphere(center, boundingRadius);
+	const btVector3 centerInSdf = convexInSdf * center;
+	btScalar dist;
+	btVector3 gradient;
+	const bool centerInDomain = sdf->queryPoint(centerInSdf, dist, gradient);
+	if (centerInDomain && dist > boundingRadius + threshold + sdf->getCellSize())
 	{
-		if (triBodyWrap->getCollisionShape()->getShapeType() == SDF_SHAPE_PROXYTYPE)
+		if (manifold->getNumContacts())
 		{
-			btSdfCollisionShape* sdfShape = (btSdfCollisionShape*)triBodyWrap->getCollisionShape();
-			if (convexBodyWrap->getCollisionShape()->isConvex())
-			{
-				btConvexShape* convex = (btConvexShape*)convexBodyWrap->getCollisionShape();
-				btAlignedObjectArray<btVector3> queryVertices;
+			resultOut->refreshContactPoints();
+		}
+		return;
+	}
 
-				if (convex->isPolyhedral())
+	switch (convex->getShapeType())
+	{
+		case SPHERE_SHAPE_PROXYTYPE:
+		{
+			const btSphereShape* sphere = static_cast<const btSphereShape*>(convex);
+			if (sphere->getRadius() + threshold >= sdf->getBand())
+			{
+				addSdfSupportContacts(sdf, sdfTrans, convexInSdf, convex, threshold, resultOut);
+			}
+			else if (centerInDomain)
+			{
+				addSdfContact(sdfTrans, centerInSdf, dist, gradient, sphere->getRadius(), threshold, resultOut);
+			}
+			break;
+		}
+		case CAPSULE_SHAPE_PROXYTYPE:
+		{
+			// Samples about a radius apart along the segment, contacts at both ends and where the distance dips
+			const btCapsuleShape* capsule = static_cast<const btCapsuleShape*>(convex);
+			const btScalar radius = capsule->getRadius();
+			if (radius + threshold >= sdf->getBand())
+			{
+				addSdfSupportContacts(sdf, sdfTrans, convexInSdf, convex, threshold, resultOut);
+				break;
+			}
+			btVector3 halfAxis(0, 0, 0);
+			halfAxis[capsule->getUpAxis()] = capsule->getHalfHeight();
+			const btVector3 a = convexInSdf * -halfAxis;
+			const btVector3 b = convexInSdf * halfAxis;
+			enum
+			{
+				MAX_CAPSULE_SAMPLES = 9
+			};
+			const int numSamples = btMin(int(MAX_CAPSULE_SAMPLES), 2 + int(btScalar(2) * capsule->getHalfHeight() / btMax(radius, SIMD_EPSILON)));
+			btVector3 points[MAX_CAPSULE_SAMPLES];
+			btVector3 gradients[MAX_CAPSULE_SAMPLES];
+			btScalar dists[MAX_CAPSULE_SAMPLES];
+			bool valid[MAX_CAPSULE_SAMPLES];
+			for (int i = 0; i < numSamples; i++)
+			{
+				points[i] = a.lerp(b, btScalar(i) / btScalar(numSamples - 1));
+				valid[i] = sdf->queryPoint(points[i], dists[i], gradients[i]);
+			}
+			for (int i = 0; i < numSamples; i++)
+			{
+				if (!valid[i]) continue;
+				const bool isEnd = i == 0 || i == numSamples - 1;
+				const bool isDip = !isEnd && (!valid[i - 1] || dists[i] <= dists[i - 1]) && (!valid[i + 1] || dists[i] < dists[i + 1]);
+				if (isEnd || isDip)
 				{
-					btPolyhedralConvexShape* poly = (btPolyhedralConvexShape*)convex;
-					for (int v = 0; v < poly->getNumVertices(); v++)
+					addSdfContact(sdfTrans, points[i], dists[i], gradients[i], radius, threshold, resultOut);
+				}
+			}
+			break;
+		}
+		default:
+		{
+			if (convex->isPolyhedral())
+			{
+				const btPolyhedralConvexShape* poly = static_cast<const btPolyhedralConvexShape*>(convex);
+				for (int v = 0; v < poly->getNumVertices(); v++)
+				{
+					btVector3 vtx;
+					poly->getVertex(v, vtx);
+					const btVector3 vtxInSdf = convexInSdf * vtx;
+					if (sdf->queryPoint(vtxInSdf, dist, gradient))
 					{
-						btVector3 vtx;
-						poly->getVertex(v, vtx);
-						queryVertices.push_back(vtx);
+						addSdfContact(sdfTrans, vtxInSdf, dist, gradient, 0, threshold, resultOut);
 					}
 				}
-				btScalar maxDist = SIMD_EPSILON;
-
-				if (convex->getShapeType() == SPHERE_SHAPE_PROXYTYPE)
+			}
+			else if (centerInDomain && gradient.length2() > SIMD_EPSILON)
+			{
+				// anything else: its deepest point along the field's gradient at the centre
+				const btVector3 support = convexInSdf * convex->localGetSupportingVertex(-gradient * convexInSdf.getBasis());
+				if (sdf->queryPoint(support, dist, gradient))
 				{
-					queryVertices.push_back(btVector3(0, 0, 0));
-					btSphereShape* sphere = (btSphereShape*)convex;
-					maxDist = sphere->getRadius() + SIMD_EPSILON;
+					addSdfContact(sdfTrans, support, dist, gradient, 0, threshold, resultOut);
 				}
-				if (queryVertices.size())
-				{
-					resultOut->setPersistentManifold(m_btConvexTriangleCallback.m_manifoldPtr);
-					//m_btConvexTriangleCallback.m_manifoldPtr->clearManifold();
+			}
+			else
+			{
+				addSdfSupportContacts(sdf, sdfTrans, convexInSdf, convex, threshold, resultOut);
+			}
+			break;
+		}
+	}
+	resultOut->refreshContactPoints();
+}
 
-					btPolyhedralConvexShape* poly = (btPolyhedralConvexShape*)convex;
-					for (int v = 0; v < queryVertices.size(); v++)
-					{
-						const btVector3& vtx = queryVertices[v];
-						btVector3 vtxWorldSpace = convexBodyWrap->getWorldTransform() * vtx;
-						btVector3 vtxInSdf = triBodyWrap->getWorldTransform().invXform(vtxWorldSpace);
-
-						btVector3 normalLocal;
-						btScalar dist;
-						if (sdfShape->queryPoint(vtxInSdf, dist, normalLocal))
-						{
-							if (dist <= maxDist)
-							{
-								normalLocal.safeNormalize();
-								btVector3 normal = triBodyWrap->getWorldTransform().getBasis() * normalLocal;
-
-								if (convex->getShapeType() == SPHERE_SHAPE_PROXYTYPE)
-								{
-									btSphereShape* sphere = (btSphereShape*)convex;
-									dist -= sphere->getRadius();
-									vtxWorldSpace -= sphere->getRadius() * normal;
-								}
-								resultOut->addContactPoint(normal, vtxWorldSpace - normal * dist, dist);
-							}
-						}
-					}
-					resultOut->refreshContactPoints();
-				}
+void btConvexConcaveCollisionAlgorithm::processCollision(const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap, const btDispatcherInfo& dispatchInfo, btManifoldResult* resultOut)
+{
+	BT_PROFILE("btConvexConcaveCollisionAlgorithm::processCollision");
+
+	const btCollisionObjectWrapper* convexBodyWrap = m_isSwapped ? body1Wrap : body0Wrap;
+	const btCollisionObjectWrapper* triBodyWrap = m_isSwapped ? body0Wrap : body1Wrap;
+
+	if (triBodyWrap->getCollisionShape()->isConcave())
+	{
+		if (triBodyWrap->getCollisionShape()->getShapeType() == SDF_SHAPE_PROXYTYPE)
+		{
+			if (convexBodyWrap->getCollisionShape()->isConvex())
+			{
+				processSdfCollision(convexBodyWrap, triBodyWrap, m_btConvexTriangleCallback.m_manifoldPtr, resultOut);
 			}
 		}
 		else
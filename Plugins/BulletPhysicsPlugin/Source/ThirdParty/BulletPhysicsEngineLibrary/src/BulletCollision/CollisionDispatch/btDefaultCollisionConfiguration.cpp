@@ -23,6 +23,7 @@ subject to the following restrictions:
 
 #include "BulletCollision/CollisionDispatch/btConvexPlaneCollisionAlgorithm.h"
 #include "BulletCollision/CollisionDispatch/btBoxBoxCollisionAlgorithm.h"
+#include "BulletCollision/CollisionDispatch/btCapsuleBoxCollisionAlgorithm.h"
 #include "BulletCollision/CollisionDispatch/btSphereSphereCollisionAlgorithm.h"
 #ifdef USE_BUGGY_SPHERE_BOX_ALGORITHM
 #include "BulletCollision/CollisionDispatch/btSphereBoxCollisionAlgorithm.h"
@@ -86,6 +87,13 @@ btDefaultCollisionConfiguration::btDefaultCollisionConfiguration(const btDefault
 	mem = btAlignedAlloc(sizeof(btBoxBoxCollisionAlgorithm::CreateFunc), 16);
 	m_boxBoxCF = new (mem) btBoxBoxCollisionAlgorithm::CreateFunc;
 
+	//sphere or capsule versus box
+	mem = btAlignedAlloc(sizeof(btCapsuleBoxCollisionAlgorithm::CreateFunc), 16);
+	m_capsuleBoxCF = new (mem) btCapsuleBoxCollisionAlgorithm::CreateFunc;
+	mem = btAlignedAlloc(sizeof(btCapsuleBoxCollisionAlgorithm::CreateFunc), 16);
+	m_boxCapsuleCF = new (mem) btCapsuleBoxCollisionAlgorithm::CreateFunc;
+	m_boxCapsuleCF->m_swapped = true;
+
 	//convex versus plane
 	mem = btAlignedAlloc(sizeof(btConvexPlaneCollisionAlgorithm::CreateFunc), 16);
 	m_convexPlaneCF = new (mem) btConvexPlaneCollisionAlgorithm::CreateFunc;
@@ -113,7 +121,7 @@ btDefaultCollisionConfiguration::btDefaultCollisionConfiguration(const btDefault
 	{
 		m_ownsPersistentManifoldPool = true;
 		void* mem = btAlignedAlloc(sizeof(btPoolAllocator), 16);
-		m_persistentManifoldPool = new (mem) btPoolAllocator(sizeof(btPersistentManifold), constructionInfo.m_defaultMaxPersistentManifoldPoolSize);
+		m_persistentManifoldPool = new (mem) btPoolAllocator(sizeof(btPersistentManifold), constructionInfo.m_defaultMaxPersistentManifoldPoolSize, constructionInfo.m_persistentManifoldPoolGrowSize);
 	}
 
 	collisionAlgorithmMaxElementSize = (collisionAlgorithmMaxElementSize + 16) & 0xffffffffffff0;
@@ -126,7 +134,7 @@ btDefaultCollisionConfiguration::btDefaultCollisionConfiguration(const btDefault
 	{
 		m_ownsCollisionAlgorithmPool = true;
 		void* mem = btAlignedAlloc(sizeof(btPoolAllocator), 16);
-		m_collisionAlgorithmPool = new (mem) btPoolAllocator(collisionAlgorithmMaxElementSize, constructionInfo.m_defaultMaxCollisionAlgorithmPoolSize);
+		m_collisionAlgorithmPool = new (mem) btPoolAllocator(collisionAlgorithmMaxElementSize, constructionInfo.m_defaultMaxCollisionAlgorithmPoolSize, constructionInfo.m_collisionAlgorithmPoolGrowSize);
 	}
 }
 
@@ -179,6 +187,10 @@ btDefaultCollisionConfiguration::~btDefaultCollisionConfiguration()
 	btAlignedFree(m_triangleSphereCF);
 	m_boxBoxCF->~btCollisionAlgorithmCreateFunc();
 	btAlignedFree(m_boxBoxCF);
+	m_capsuleBoxCF->~btCollisionAlgorithmCreateFunc();
+	btAlignedFree(m_capsuleBoxCF);
+	m_boxCapsuleCF->~btCollisionAlgorithmCreateFunc();
+	btAlignedFree(m_boxCapsuleCF);
 
 	m_convexPlaneCF->~btCollisionAlgorithmCreateFunc();
 	btAlignedFree(m_convexPlaneCF);
@@ -297,6 +309,16 @@ btCollisionAlgorithmCreateFunc* btDefaultCollisionConfiguration::getCollisionAlg
 		return m_boxBoxCF;
 	}
 
+	if (((proxyType0 == SPHERE_SHAPE_PROXYTYPE) || (proxyType0 == CAPSULE_SHAPE_PROXYTYPE)) && (proxyType1 == BOX_SHAPE_PROXYTYPE))
+	{
+		return m_capsuleBoxCF;
+	}
+
+	if ((proxyType0 == BOX_SHAPE_PROXYTYPE) && ((proxyType1 == SPHERE_SHAPE_PROXYTYPE) || (proxyType1 == CAPSULE_SHAPE_PROXYTYPE)))
+	{
+		return m_boxCapsuleCF;
+	}
+
 	if (btBroadphaseProxy::isConvex(proxyType0) && (proxyType1 == STATIC_PLANE_PROXYTYPE))
 	{
 		return m_convexPlaneCF;
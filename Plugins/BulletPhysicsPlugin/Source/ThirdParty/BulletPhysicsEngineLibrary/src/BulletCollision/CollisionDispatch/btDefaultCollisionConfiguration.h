@@ -26,6 +26,9 @@ struct btDefaultCollisionConstructionInfo
 	btPoolAllocator* m_collisionAlgorithmPool;
 	int m_defaultMaxPersistentManifoldPoolSize;
 	int m_defaultMaxCollisionAlgorithmPoolSize;
+	///when > 0 the default pools add chunks of this many elements instead of overflowing to the heap
+	int m_persistentManifoldPoolGrowSize;
+	int m_collisionAlgorithmPoolGrowSize;
 	int m_customCollisionAlgorithmMaxElementSize;
 	int m_useEpaPenetrationAlgorithm;
 
@@ -34,6 +37,8 @@ struct btDefaultCollisionConstructionInfo
 		  m_collisionAlgorithmPool(0),
 		  m_defaultMaxPersistentManifoldPoolSize(4096),
 		  m_defaultMaxCollisionAlgorithmPoolSize(4096),
+		  m_persistentManifoldPoolGrowSize(0),
+		  m_collisionAlgorithmPoolGrowSize(0),
 		  m_customCollisionAlgorithmMaxElementSize(0),
 		  m_useEpaPenetrationAlgorithm(true)
 	{
@@ -71,6 +76,8 @@ protected:
 	btCollisionAlgorithmCreateFunc* m_boxSphereCF;
 
 	btCollisionAlgorithmCreateFunc* m_boxBoxCF;
+	btCollisionAlgorithmCreateFunc* m_capsuleBoxCF;
+	btCollisionAlgorithmCreateFunc* m_boxCapsuleCF;
 	btCollisionAlgorithmCreateFunc* m_sphereTriangleCF;
 	btCollisionAlgorithmCreateFunc* m_triangleSphereCF;
 	btCollisionAlgorithmCreateFunc* m_planeConvexCF;
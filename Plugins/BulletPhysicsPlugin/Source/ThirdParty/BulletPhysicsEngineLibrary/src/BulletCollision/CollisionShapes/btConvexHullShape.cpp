@@ -28,13 +28,18 @@ subject to the following restrictions:
 btConvexHullShape ::btConvexHullShape(const btScalar* points, int numPoints, int stride) : btPolyhedralConvexAabbCachingShape()
 {
 	m_shapeType = CONVEX_HULL_SHAPE_PROXYTYPE;
+	setPoints(points, numPoints, stride);
+}
+
+void btConvexHullShape::setPoints(const btScalar* points, int numPoints, int stride)
+{
 	m_unscaledPoints.resize(numPoints);
 
-	unsigned char* pointsAddress = (unsigned char*)points;
+	const unsigned char* pointsAddress = (const unsigned char*)points;
 
 	for (int i = 0; i < numPoints; i++)
 	{
-		btScalar* point = (btScalar*)pointsAddress;
+		const btScalar* point = (const btScalar*)pointsAddress;
 		m_unscaledPoints[i] = btVector3(point[0], point[1], point[2]);
 		pointsAddress += stride;
 	}
@@ -125,6 +130,80 @@ void btConvexHullShape::optimizeConvexHull()
 	}
 }
 
+void btConvexHullShape::simplifyConvexHull(int maxVertices, btScalar planarTolerance)
+{
+	optimizeConvexHull();
+	while (m_unscaledPoints.size() > 4)
+	{
+		btConvexHullComputer conv;
+		conv.compute(&m_unscaledPoints[0].getX(), sizeof(btVector3), m_unscaledPoints.size(), 0.f, 0.f);
+		int numVerts = conv.vertices.size();
+		if (numVerts <= 4)
+			break;
+
+		btVector3 center(0, 0, 0);
+		btAlignedObjectArray<int> firstEdge;
+		firstEdge.resize(numVerts, -1);
+		for (int i = 0; i < numVerts; i++)
+		{
+			center += conv.vertices[i];
+		}
+		center /= btScalar(numVerts);
+		for (int e = 0; e < conv.edges.size(); e++)
+		{
+			int v = conv.edges[e].getSourceVertex();
+			if (firstEdge[v] < 0)
+				firstEdge[v] = e;
+		}
+
+		//how far each vertex sticks out over the ring of its neighbors
+		int cheapest = -1;
+		btScalar cheapestHeight = BT_LARGE_FLOAT;
+		for (int v = 0; v < numVerts; v++)
+		{
+			if (firstEdge[v] < 0)
+				continue;
+			const btVector3& pt = conv.vertices[v];
+			const btConvexHullComputer::Edge* first = &conv.edges[firstEdge[v]];
+			const btConvexHullComputer::Edge* edge = first;
+			btVector3 normal(0, 0, 0);
+			btVector3 ringCenter(0, 0, 0);
+			int ringSize = 0;
+			do
+			{
+				const btConvexHullComputer::Edge* next = edge->getNextEdgeOfVertex();
+				normal += (conv.vertices[edge->getTargetVertex()] - pt).cross(conv.vertices[next->getTargetVertex()] - pt);
+				ringCenter += conv.vertices[edge->getTargetVertex()];
+				ringSize++;
+				edge = next;
+			} while (edge != first);
+
+			if (normal.length2() < SIMD_EPSILON * SIMD_EPSILON)
+				continue;
+			normal.normalize();
+			if (normal.dot(pt - center) < 0)
+				normal = -normal;
+			btScalar height = normal.dot(pt - ringCenter / btScalar(ringSize));
+			if (height < cheapestHeight)
+			{
+				cheapestHeight = height;
+				cheapest = v;
+			}
+		}
+
+		if (cheapest < 0 || ((maxVertices <= 0 || numVerts <= maxVertices) && cheapestHeight > planarTolerance))
+			break;
+
+		m_unscaledPoints.resize(0);
+		for (int i = 0; i < numVerts; i++)
+		{
+			if (i != cheapest)
+				m_unscaledPoints.push_back(conv.vertices[i]);
+		}
+	}
+	recalcLocalAabb();
+}
+
 //currently just for debugging (drawing), perhaps future support for algebraic continuous collision detection
 //Please note that you can debug-draw btConvexHullShape with the Raytracer Demo
 int btConvexHullShape::getNumVertices() const
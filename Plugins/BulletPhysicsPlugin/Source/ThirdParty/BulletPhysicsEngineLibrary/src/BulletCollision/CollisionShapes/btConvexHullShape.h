@@ -37,6 +37,9 @@ public:
 
 	void addPoint(const btVector3& point, bool recalculateLocalAabb = true);
 
+	///replaces all points at once, same layout as the constructor takes
+	void setPoints(const btScalar* points, int numPoints, int stride = sizeof(btVector3));
+
 	btVector3* getUnscaledPoints()
 	{
 		return &m_unscaledPoints[0];
@@ -55,6 +58,11 @@ public:
 
 	void optimizeConvexHull();
 
+	///optimizeConvexHull, then drops the vertices that stick out least over their neighbors until there are no more than
+	///maxVertices (0 for no limit) and no vertex sticks out by less than planarTolerance, which merges nearly coplanar
+	///faces. The hull only shrinks: a removed vertex cuts off a cap about as high as it stuck out.
+	void simplifyConvexHull(int maxVertices, btScalar planarTolerance);
+
 	SIMD_FORCE_INLINE btVector3 getScaledPoint(int i) const
 	{
 		return m_unscaledPoints[i] * m_localScaling;
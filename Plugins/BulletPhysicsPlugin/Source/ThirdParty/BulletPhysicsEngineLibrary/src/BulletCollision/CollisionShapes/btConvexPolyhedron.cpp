@@ -172,6 +172,104 @@ void btConvexPolyhedron::initialize()
 #endif  //USE_CONNECTED_FACES
 
 	initialize2();
+	initializeAdjacency();
+}
+
+void btConvexPolyhedron::initializeAdjacency()
+{
+	m_edges.resize(0);
+	m_vertexNeighborStart.resize(0);
+	m_vertexNeighbors.resize(0);
+
+	btHashMap<btInternalVertexPair, int> edgeIndices;
+	bool closed = true;
+	for (int i = 0; i < m_faces.size() && closed; i++)
+	{
+		int numVertices = m_faces[i].m_indices.size();
+		for (int j = 0; j < numVertices; j++)
+		{
+			int v0 = m_faces[i].m_indices[j];
+			int v1 = m_faces[i].m_indices[(j + 1) % numVertices];
+			btInternalVertexPair vp(v0, v1);
+			int* edgeIndex = edgeIndices.find(vp);
+			if (edgeIndex)
+			{
+				btPolyhedronEdge& edge = m_edges[*edgeIndex];
+				//every edge has to be walked once each way, by two different faces
+				if (edge.m_face1 >= 0 || edge.m_vertex0 != v1)
+				{
+					closed = false;
+					break;
+				}
+				edge.m_face1 = i;
+			}
+			else
+			{
+				edgeIndices.insert(vp, m_edges.size());
+				btPolyhedronEdge& edge = m_edges.expand();
+				edge.m_vertex0 = v0;
+				edge.m_vertex1 = v1;
+				edge.m_face0 = i;
+				edge.m_face1 = -1;
+			}
+		}
+	}
+	for (int i = 0; i < m_edges.size() && closed; i++)
+	{
+		closed = m_edges[i].m_face1 >= 0;
+	}
+	if (!closed || m_edges.size() == 0)
+	{
+		m_edges.resize(0);
+		return;
+	}
+
+	m_vertexNeighborStart.resize(m_vertices.size() + 1, 0);
+	for (int i = 0; i < m_edges.size(); i++)
+	{
+		m_vertexNeighborStart[m_edges[i].m_vertex0 + 1]++;
+		m_vertexNeighborStart[m_edges[i].m_vertex1 + 1]++;
+	}
+	for (int i = 0; i < m_vertices.size(); i++)
+	{
+		m_vertexNeighborStart[i + 1] += m_vertexNeighborStart[i];
+	}
+	btAlignedObjectArray<int> fill;
+	fill.resize(m_vertices.size());
+	for (int i = 0; i < m_vertices.size(); i++)
+	{
+		fill[i] = m_vertexNeighborStart[i];
+	}
+	m_vertexNeighbors.resize(m_edges.size() * 2);
+	for (int i = 0; i < m_edges.size(); i++)
+	{
+		m_vertexNeighbors[fill[m_edges[i].m_vertex0]++] = m_edges[i].m_vertex1;
+		m_vertexNeighbors[fill[m_edges[i].m_vertex1]++] = m_edges[i].m_vertex0;
+	}
+}
+
+int btConvexPolyhedron::hillClimbSupport(const btVector3& dir, int startVertex) const
+{
+	//a vertex without a better neighbor is the support vertex, the function is linear and the polyhedron convex
+	int best = startVertex;
+	btScalar bestDot = m_vertices[best].dot(dir);
+	for (;;)
+	{
+		int next = best;
+		for (int i = m_vertexNeighborStart[best]; i < m_vertexNeighborStart[best + 1]; i++)
+		{
+			int n = m_vertexNeighbors[i];
+			btScalar d = m_vertices[n].dot(dir);
+			if (d > bestDot)
+			{
+				bestDot = d;
+				next = n;
+			}
+		}
+		if (next == best)
+			return best;
+		best = next;
+	}
 }
 
 void btConvexPolyhedron::initialize2()
@@ -30,6 +30,15 @@ struct btFace
 	btScalar m_plane[4];
 };
 
+///an edge shared by two faces, m_face0 runs from m_vertex0 to m_vertex1 and m_face1 the other way
+struct btPolyhedronEdge
+{
+	int m_vertex0;
+	int m_vertex1;
+	int m_face0;
+	int m_face1;
+};
+
 ATTRIBUTE_ALIGNED16(class)
 btConvexPolyhedron
 {
@@ -49,10 +58,20 @@ public:
 	btVector3 mC;
 	btVector3 mE;
 
+	///adjacency, built by initializeAdjacency. Empty when the faces don't form a closed surface.
+	///The neighbors of vertex i are m_vertexNeighbors[m_vertexNeighborStart[i] .. m_vertexNeighborStart[i + 1]).
+	btAlignedObjectArray<btPolyhedronEdge> m_edges;
+	btAlignedObjectArray<int> m_vertexNeighborStart;
+	btAlignedObjectArray<int> m_vertexNeighbors;
+
 	void initialize();
 	void initialize2();
+	void initializeAdjacency();
 	bool testContainment() const;
 
+	///index of the vertex furthest along dir, found by walking from startVertex to better neighbors. Needs adjacency.
+	int hillClimbSupport(const btVector3& dir, int startVertex) const;
+
 	void project(const btTransform& trans, const btVector3& dir, btScalar& minProj, btScalar& maxProj, btVector3& witnesPtMin, btVector3& witnesPtMax) const;
 };
 
@@ -58,6 +58,16 @@ btHeightfieldTerrainShape::btHeightfieldTerrainShape(
 			   flipQuadEdges);
 }
 
+btHeightfieldTerrainShape::btHeightfieldTerrainShape(
+	int heightStickWidth, int heightStickLength, const unsigned short* heightfieldData, btScalar heightScale,
+	btScalar minHeight, btScalar maxHeight, int upAxis, bool flipQuadEdges)
+	: m_userValue3(0), m_triangleInfoMap(0)
+{
+	initialize(heightStickWidth, heightStickLength, heightfieldData,
+			   heightScale, minHeight, maxHeight, upAxis, PHY_USHORT,
+			   flipQuadEdges);
+}
+
 btHeightfieldTerrainShape::btHeightfieldTerrainShape(
 	int heightStickWidth, int heightStickLength, const void* heightfieldData,
 	btScalar heightScale, btScalar minHeight, btScalar maxHeight, int upAxis,
@@ -107,7 +117,7 @@ void btHeightfieldTerrainShape::initialize(
 	// btAssert(heightScale) -- do we care?  Trust caller here
 	btAssert(minHeight <= maxHeight);                                    // && "bad min/max height");
 	btAssert(upAxis >= 0 && upAxis < 3);                                 // && "bad upAxis--should be in range [0,2]");
-	btAssert(hdt != PHY_UCHAR || hdt != PHY_FLOAT || hdt != PHY_DOUBLE || hdt != PHY_SHORT);  // && "Bad height data type enum");
+	btAssert(hdt != PHY_UCHAR || hdt != PHY_FLOAT || hdt != PHY_DOUBLE || hdt != PHY_SHORT || hdt != PHY_USHORT);  // && "Bad height data type enum");
 
 	// initialize member variables
 	m_shapeType = TERRAIN_SHAPE_PROXYTYPE;
@@ -220,6 +230,13 @@ btHeightfieldTerrainShape::getRawHeightFieldValue(int x, int y) const
 			break;
 		}
 
+		case PHY_USHORT:
+		{
+			unsigned short hfValue = m_heightfieldDataUnsignedShort[(y * m_heightStickWidth) + x];
+			val = hfValue * m_heightScale;
+			break;
+		}
+
 		default:
 		{
 			btAssert(!"Bad m_heightDataType");
@@ -882,13 +899,31 @@ void btHeightfieldTerrainShape::buildAccelerator(int chunkSize)
 
 	// This data structure is only reallocated if the required size changed
 	m_vboundsGrid.resize(nChunksX * nChunksZ);
-	
-	// Compute min and max height for all chunks
-	for (int cz = 0; cz < nChunksZ; ++cz)
+
+	updateAccelerator(0, 0, m_heightStickWidth - 1, m_heightStickLength - 1);
+}
+
+void btHeightfieldTerrainShape::updateAccelerator(int minX, int minY, int maxX, int maxY)
+{
+	if (m_vboundsGrid.size() == 0)
+	{
+		return;
+	}
+
+	const int chunkSize = m_vboundsChunkSize;
+	const int nChunksX = m_vboundsGridWidth;
+	// a chunk also covers the first samples of the next one, see below
+	const int cx0 = btMax(0, (minX - 1) / chunkSize);
+	const int cz0 = btMax(0, (minY - 1) / chunkSize);
+	const int cx1 = btMin(m_vboundsGridWidth - 1, maxX / chunkSize);
+	const int cz1 = btMin(m_vboundsGridLength - 1, maxY / chunkSize);
+
+	// Compute min and max height for the chunks
+	for (int cz = cz0; cz <= cz1; ++cz)
 	{
 		int z0 = cz * chunkSize;
 
-		for (int cx = 0; cx < nChunksX; ++cx)
+		for (int cx = cx0; cx <= cx1; ++cx)
 		{
 			int x0 = cx * chunkSize;
 
@@ -101,6 +101,7 @@ protected:
 	union {
 		const unsigned char* m_heightfieldDataUnsignedChar;
 		const short* m_heightfieldDataShort;
+		const unsigned short* m_heightfieldDataUnsignedShort;
 		const float* m_heightfieldDataFloat;
 		const double* m_heightfieldDataDouble;
 		const void* m_heightfieldDataUnknown;
@@ -159,6 +160,10 @@ public:
 		int heightStickWidth, int heightStickLength,
 		const unsigned char* heightfieldData, btScalar heightScale, btScalar minHeight, btScalar maxHeight,
 		int upAxis, bool flipQuadEdges);
+	btHeightfieldTerrainShape(
+		int heightStickWidth, int heightStickLength,
+		const unsigned short* heightfieldData, btScalar heightScale, btScalar minHeight, btScalar maxHeight,
+		int upAxis, bool flipQuadEdges);
 
 	/// legacy constructor
 	/**
@@ -211,6 +216,8 @@ public:
 	void performRaycast(btTriangleCallback * callback, const btVector3& raySource, const btVector3& rayTarget) const;
 
 	void buildAccelerator(int chunkSize = 16);
+	///recomputes the accelerator chunks touching the samples [minX, maxX] x [minY, maxY] after they were changed in place
+	void updateAccelerator(int minX, int minY, int maxX, int maxY);
 	void clearAccelerator();
 
 	int getUpAxis() const
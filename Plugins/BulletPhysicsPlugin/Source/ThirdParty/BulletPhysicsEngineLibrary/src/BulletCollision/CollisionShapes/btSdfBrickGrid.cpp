@@ -0,0 +1,575 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2006 Erwin Coumans  https://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "btSdfBrickGrid.h"
+#include "LinearMath/btMinMax.h"
+
+namespace
+{
+enum btSdfFeature
+{
+	SDF_FEATURE_FACE,
+	SDF_FEATURE_VERTEX0,
+	SDF_FEATURE_VERTEX1,
+	SDF_FEATURE_VERTEX2,
+	SDF_FEATURE_EDGE01,
+	SDF_FEATURE_EDGE12,
+	SDF_FEATURE_EDGE20
+};
+
+struct btSdfBakeTriangle
+{
+	int m_v[3];
+	btVector3 m_normal;
+	// pseudonormals of edges 01, 12 and 20
+	btVector3 m_edgeNormals[3];
+	btVector3 m_aabbMin;
+	btVector3 m_aabbMax;
+};
+
+struct btSdfBakeEdge
+{
+	int m_lo;
+	int m_hi;
+	int m_triangle;
+	int m_edge;
+};
+
+struct btSdfVertexLess
+{
+	const btVector3* m_vertices;
+	btSdfVertexLess(const btVector3* vertices) : m_vertices(vertices) {}
+	bool operator()(int a, int b) const
+	{
+		const btVector3& va = m_vertices[a];
+		const btVector3& vb = m_vertices[b];
+		if (va.x() != vb.x()) return va.x() < vb.x();
+		if (va.y() != vb.y()) return va.y() < vb.y();
+		return va.z() < vb.z();
+	}
+};
+
+struct btSdfEdgeLess
+{
+	bool operator()(const btSdfBakeEdge& a, const btSdfBakeEdge& b) const
+	{
+		return a.m_lo != b.m_lo ? a.m_lo < b.m_lo : a.m_hi < b.m_hi;
+	}
+};
+
+// closest point on triangle abc to p (Ericson, Real-Time Collision Detection 5.1.5), and which feature it is on
+btVector3 closestPointOnTriangle(const btVector3& p, const btVector3& a, const btVector3& b, const btVector3& c, int& feature)
+{
+	const btVector3 ab = b - a;
+	const btVector3 ac = c - a;
+	const btVector3 ap = p - a;
+	const btScalar d1 = ab.dot(ap);
+	const btScalar d2 = ac.dot(ap);
+	if (d1 <= btScalar(0) && d2 <= btScalar(0))
+	{
+		feature = SDF_FEATURE_VERTEX0;
+		return a;
+	}
+	const btVector3 bp = p - b;
+	const btScalar d3 = ab.dot(bp);
+	const btScalar d4 = ac.dot(bp);
+	if (d3 >= btScalar(0) && d4 <= d3)
+	{
+		feature = SDF_FEATURE_VERTEX1;
+		return b;
+	}
+	const btScalar vc = d1 * d4 - d3 * d2;
+	if (vc <= btScalar(0) && d1 >= btScalar(0) && d3 <= btScalar(0))
+	{
+		feature = SDF_FEATURE_EDGE01;
+		return a + ab * (d1 / (d1 - d3));
+	}
+	const btVector3 cp = p - c;
+	const btScalar d5 = ab.dot(cp);
+	const btScalar d6 = ac.dot(cp);
+	if (d6 >= btScalar(0) && d5 <= d6)
+	{
+		feature = SDF_FEATURE_VERTEX2;
+		return c;
+	}
+	const btScalar vb = d5 * d2 - d1 * d6;
+	if (vb <= btScalar(0) && d2 >= btScalar(0) && d6 <= btScalar(0))
+	{
+		feature = SDF_FEATURE_EDGE20;
+		return a + ac * (d2 / (d2 - d6));
+	}
+	const btScalar va = d3 * d6 - d5 * d4;
+	if (va <= btScalar(0) && (d4 - d3) >= btScalar(0) && (d5 - d6) >= btScalar(0))
+	{
+		feature = SDF_FEATURE_EDGE12;
+		return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+	}
+	const btScalar denom = btScalar(1) / (va + vb + vc);
+	feature = SDF_FEATURE_FACE;
+	return a + ab * (vb * denom) + ac * (vc * denom);
+}
+
+// generalized winding number (Jacobson et al. 2013), ~1 inside a closed outward-facing mesh and ~0 outside
+btScalar windingNumber(const btVector3& p, const btAlignedObjectArray<btVector3>& vertices, const btAlignedObjectArray<btSdfBakeTriangle>& triangles)
+{
+	btScalar total = 0;
+	for (int t = 0; t < triangles.size(); t++)
+	{
+		const btVector3 a = vertices[triangles[t].m_v[0]] - p;
+		const btVector3 b = vertices[triangles[t].m_v[1]] - p;
+		const btVector3 c = vertices[triangles[t].m_v[2]] - p;
+		const btScalar la = a.length();
+		const btScalar lb = b.length();
+		const btScalar lc = c.length();
+		const btScalar det = a.dot(b.cross(c));
+		const btScalar div = la * lb * lc + a.dot(b) * lc + b.dot(c) * la + c.dot(a) * lb;
+		total += btScalar(2) * btAtan2(det, div);
+	}
+	return total / (btScalar(4) * SIMD_PI);
+}
+
+btScalar aabbDistance2(const btVector3& p, const btVector3& aabbMin, const btVector3& aabbMax)
+{
+	btScalar d2 = 0;
+	for (int a = 0; a < 3; a++)
+	{
+		const btScalar d = btMax(aabbMin[a] - p[a], btMax(p[a] - aabbMax[a], btScalar(0)));
+		d2 += d * d;
+	}
+	return d2;
+}
+}  // namespace
+
+btSdfBrickGrid::btSdfBrickGrid()
+	: m_origin(0, 0, 0),
+	  m_cellSize(1),
+	  m_band(1)
+{
+	m_numBricks[0] = m_numBricks[1] = m_numBricks[2] = 0;
+}
+
+void btSdfBrickGrid::getDomain(btVector3& aabbMin, btVector3& aabbMax) const
+{
+	aabbMin = m_origin;
+	aabbMax = m_origin + btVector3(btScalar(m_numBricks[0]), btScalar(m_numBricks[1]), btScalar(m_numBricks[2])) * (m_cellSize * BRICK_CELLS);
+}
+
+int btSdfBrickGrid::getMemorySize() const
+{
+	return m_bricks.size() * int(sizeof(int)) + m_samples.size() * int(sizeof(short));
+}
+
+void btSdfBrickGrid::build(const btVector3* vertices, int numVertices, const int* indices, int numTriangles, btScalar cellSize, btScalar band)
+{
+	m_bricks.clear();
+	m_samples.clear();
+	m_numBricks[0] = m_numBricks[1] = m_numBricks[2] = 0;
+	if (numVertices == 0 || numTriangles == 0 || cellSize <= btScalar(0))
+	{
+		return;
+	}
+	m_cellSize = cellSize;
+	// the sign is carried from sample to sample beyond the band, which needs neighbours to be closer than it
+	m_band = btMax(band, btScalar(2) * cellSize);
+
+	// Weld vertices at the same position, pseudonormals need the real adjacency
+	btAlignedObjectArray<int> order;
+	order.resize(numVertices);
+	for (int i = 0; i < numVertices; i++) order[i] = i;
+	order.quickSort(btSdfVertexLess(vertices));
+	btAlignedObjectArray<int> remap;
+	remap.resize(numVertices);
+	btAlignedObjectArray<btVector3> welded;
+	for (int i = 0; i < numVertices; i++)
+	{
+		if (i == 0 || vertices[order[i]] != vertices[order[i - 1]])
+		{
+			welded.push_back(vertices[order[i]]);
+		}
+		remap[order[i]] = welded.size() - 1;
+	}
+
+	btAlignedObjectArray<btSdfBakeTriangle> triangles;
+	btScalar volume = 0;
+	for (int t = 0; t < numTriangles; t++)
+	{
+		btSdfBakeTriangle tri;
+		for (int k = 0; k < 3; k++) tri.m_v[k] = remap[indices[t * 3 + k]];
+		const btVector3& a = welded[tri.m_v[0]];
+		const btVector3& b = welded[tri.m_v[1]];
+		const btVector3& c = welded[tri.m_v[2]];
+		const btVector3 n = (b - a).cross(c - a);
+		if (n.length2() <= SIMD_EPSILON * SIMD_EPSILON * cellSize * cellSize * cellSize * cellSize)
+		{
+			continue;
+		}
+		tri.m_normal = n.normalized();
+		volume += a.dot(b.cross(c));
+		triangles.push_back(tri);
+	}
+	if (triangles.size() == 0)
+	{
+		return;
+	}
+	if (volume < btScalar(0))
+	{
+		for (int t = 0; t < triangles.size(); t++)
+		{
+			btSwap(triangles[t].m_v[1], triangles[t].m_v[2]);
+			triangles[t].m_normal = -triangles[t].m_normal;
+		}
+	}
+
+	// Angle-weighted vertex pseudonormals and edge pseudonormals (Baerentzen and Aanaes 2005)
+	btAlignedObjectArray<btVector3> vertexNormals;
+	vertexNormals.resize(welded.size(), btVector3(0, 0, 0));
+	btAlignedObjectArray<btSdfBakeEdge> edges;
+	edges.resize(triangles.size() * 3);
+	for (int t = 0; t < triangles.size(); t++)
+	{
+		btSdfBakeTriangle& tri = triangles[t];
+		tri.m_aabbMin = tri.m_aabbMax = welded[tri.m_v[0]];
+		for (int k = 0; k < 3; k++)
+		{
+			const btVector3& v = welded[tri.m_v[k]];
+			const btVector3 e0 = (welded[tri.m_v[(k + 1) % 3]] - v).normalized();
+			const btVector3 e1 = (welded[tri.m_v[(k + 2) % 3]] - v).normalized();
+			vertexNormals[tri.m_v[k]] += tri.m_normal * btAcos(btClamped(e0.dot(e1), btScalar(-1), btScalar(1)));
+			tri.m_aabbMin.setMin(v);
+			tri.m_aabbMax.setMax(v);
+
+			btSdfBakeEdge& edge = edges[t * 3 + k];
+			edge.m_lo = btMin(tri.m_v[k], tri.m_v[(k + 1) % 3]);
+			edge.m_hi = btMax(tri.m_v[k], tri.m_v[(k + 1) % 3]);
+			edge.m_triangle = t;
+			edge.m_edge = k;
+		}
+	}
+	edges.quickSort(btSdfEdgeLess());
+	for (int i = 0; i < edges.size();)
+	{
+		int j = i;
+		btVector3 sum(0, 0, 0);
+		for (; j < edges.size() && edges[j].m_lo == edges[i].m_lo && edges[j].m_hi == edges[i].m_hi; j++)
+		{
+			sum += triangles[edges[j].m_triangle].m_normal;
+		}
+		for (int k = i; k < j; k++)
+		{
+			triangles[edges[k].m_triangle].m_edgeNormals[edges[k].m_edge] = sum;
+		}
+		i = j;
+	}
+
+	// Domain: the mesh bounds plus the band and a cell, rounded up to whole bricks
+	btVector3 meshMin = welded[0];
+	btVector3 meshMax = welded[0];
+	for (int i = 1; i < welded.size(); i++)
+	{
+		meshMin.setMin(welded[i]);
+		meshMax.setMax(welded[i]);
+	}
+	const btScalar pad = m_band + cellSize;
+	const btScalar brickSize = cellSize * BRICK_CELLS;
+	m_origin = meshMin - btVector3(pad, pad, pad);
+	for (int a = 0; a < 3; a++)
+	{
+		m_numBricks[a] = btMax(1, int(ceil((meshMax[a] - meshMin[a] + btScalar(2) * pad) / brickSize)));
+	}
+	const int numBricks = m_numBricks[0] * m_numBricks[1] * m_numBricks[2];
+
+	// Bin every triangle into the bricks its band-expanded bounds touch (two passes, compact lists)
+	btAlignedObjectArray<int> binStart;
+	binStart.resize(numBricks + 1, 0);
+	btAlignedObjectArray<int> binTriangles;
+	for (int pass = 0; pass < 2; pass++)
+	{
+		for (int t = 0; t < triangles.size(); t++)
+		{
+			int lo[3], hi[3];
+			for (int a = 0; a < 3; a++)
+			{
+				lo[a] = btClamped(int(floor((triangles[t].m_aabbMin[a] - m_band - m_origin[a]) / brickSize)), 0, m_numBricks[a] - 1);
+				hi[a] = btClamped(int(floor((triangles[t].m_aabbMax[a] + m_band - m_origin[a]) / brickSize)), 0, m_numBricks[a] - 1);
+			}
+			for (int z = lo[2]; z <= hi[2]; z++)
+				for (int y = lo[1]; y <= hi[1]; y++)
+					for (int x = lo[0]; x <= hi[0]; x++)
+					{
+						const int b = x + m_numBricks[0] * (y + m_numBricks[1] * z);
+						if (pass == 0)
+							binStart[b + 1]++;
+						else
+							binTriangles[binStart[b]++] = t;
+					}
+		}
+		if (pass == 0)
+		{
+			for (int b = 0; b < numBricks; b++) binStart[b + 1] += binStart[b];
+			binTriangles.resize(binStart[numBricks]);
+		}
+		else
+		{
+			// the fill advanced every start to the next brick's start
+			for (int b = numBricks; b > 0; b--) binStart[b] = binStart[b - 1];
+			binStart[0] = 0;
+		}
+	}
+
+	// bricks that don't get samples are resolved to inside/outside afterwards
+	const int BRICK_UNRESOLVED = -3;
+	m_bricks.resize(numBricks, BRICK_UNRESOLVED);
+
+	btScalar dist[BRICK_SIZE];
+	// 1 within the band, 2 signed from a neighbour, 0 not known yet
+	unsigned char known[BRICK_SIZE];
+	int queue[BRICK_SIZE];
+	const int step[3] = {1, BRICK_SAMPLES, BRICK_SAMPLES * BRICK_SAMPLES};
+	const btScalar band2 = m_band * m_band;
+	const btScalar quantize = btScalar(32767) / m_band;
+
+	for (int bz = 0; bz < m_numBricks[2]; bz++)
+		for (int by = 0; by < m_numBricks[1]; by++)
+			for (int bx = 0; bx < m_numBricks[0]; bx++)
+			{
+				const int b = bx + m_numBricks[0] * (by + m_numBricks[1] * bz);
+				if (binStart[b] == binStart[b + 1])
+				{
+					continue;
+				}
+				const btVector3 brickOrigin = m_origin + btVector3(btScalar(bx), btScalar(by), btScalar(bz)) * brickSize;
+
+				int head = 0, tail = 0;
+				for (int s = 0; s < BRICK_SIZE; s++)
+				{
+					const int i = s % BRICK_SAMPLES;
+					const int j = (s / BRICK_SAMPLES) % BRICK_SAMPLES;
+					const int k = s / (BRICK_SAMPLES * BRICK_SAMPLES);
+					const btVector3 p = brickOrigin + btVector3(btScalar(i), btScalar(j), btScalar(k)) * cellSize;
+
+					btScalar best = band2;
+					int bestTriangle = -1;
+					int bestFeature = SDF_FEATURE_FACE;
+					btVector3 bestPoint;
+					for (int n = binStart[b]; n < binStart[b + 1]; n++)
+					{
+						const btSdfBakeTriangle& tri = triangles[binTriangles[n]];
+						if (aabbDistance2(p, tri.m_aabbMin, tri.m_aabbMax) > best)
+						{
+							continue;
+						}
+						int feature;
+						const btVector3 q = closestPointOnTriangle(p, welded[tri.m_v[0]], welded[tri.m_v[1]], welded[tri.m_v[2]], feature);
+						const btScalar d2 = (p - q).length2();
+						if (d2 <= best)
+						{
+							best = d2;
+							bestTriangle = binTriangles[n];
+							bestFeature = feature;
+							bestPoint = q;
+						}
+					}
+
+					if (bestTriangle < 0)
+					{
+						known[s] = 0;
+						continue;
+					}
+					const btSdfBakeTriangle& tri = triangles[bestTriangle];
+					btVector3 pseudoNormal;
+					switch (bestFeature)
+					{
+						case SDF_FEATURE_VERTEX0:
+						case SDF_FEATURE_VERTEX1:
+						case SDF_FEATURE_VERTEX2:
+							pseudoNormal = vertexNormals[tri.m_v[bestFeature - SDF_FEATURE_VERTEX0]];
+							break;
+						case SDF_FEATURE_EDGE01:
+						case SDF_FEATURE_EDGE12:
+						case SDF_FEATURE_EDGE20:
+							pseudoNormal = tri.m_edgeNormals[bestFeature - SDF_FEATURE_EDGE01];
+							break;
+						default:
+							pseudoNormal = tri.m_normal;
+							break;
+					}
+					const btScalar d = btSqrt(best);
+					dist[s] = (p - bestPoint).dot(pseudoNormal) < btScalar(0) ? -d : d;
+					known[s] = 1;
+					queue[tail++] = s;
+				}
+
+				if (tail == 0)
+				{
+					// the triangles' bounds reached this brick but none came within the band of a sample
+					continue;
+				}
+
+				// Samples beyond the band can't be on the other side of the surface from a neighbour (the band is at
+				// least two cells), so they take the sign of whichever neighbour already has one
+				while (head < tail)
+				{
+					const int s = queue[head++];
+					const int coord[3] = {s % BRICK_SAMPLES, (s / BRICK_SAMPLES) % BRICK_SAMPLES, s / (BRICK_SAMPLES * BRICK_SAMPLES)};
+					for (int a = 0; a < 3; a++)
+					{
+						for (int dir = -1; dir <= 1; dir += 2)
+						{
+							const int c = coord[a] + dir;
+							if (c < 0 || c >= BRICK_SAMPLES) continue;
+							const int n = s + dir * step[a];
+							if (known[n]) continue;
+							known[n] = 2;
+							dist[n] = dist[s] < btScalar(0) ? -m_band : m_band;
+							queue[tail++] = n;
+						}
+					}
+				}
+
+				bool allOutside = true;
+				bool allInside = true;
+				for (int s = 0; s < BRICK_SIZE; s++)
+				{
+					if (!known[s])
+					{
+						// cut off from the rest of the brick by its faces, rare enough to just ask the whole mesh
+						const int i = s % BRICK_SAMPLES;
+						const int j = (s / BRICK_SAMPLES) % BRICK_SAMPLES;
+						const int k = s / (BRICK_SAMPLES * BRICK_SAMPLES);
+						const btVector3 p = brickOrigin + btVector3(btScalar(i), btScalar(j), btScalar(k)) * cellSize;
+						dist[s] = windingNumber(p, welded, triangles) > btScalar(0.5) ? -m_band : m_band;
+					}
+					allOutside = allOutside && dist[s] >= m_band;
+					allInside = allInside && dist[s] <= -m_band;
+				}
+				if (allOutside || allInside)
+				{
+					m_bricks[b] = allOutside ? BRICK_OUTSIDE : BRICK_INSIDE;
+					continue;
+				}
+
+				m_bricks[b] = m_samples.size() / BRICK_SIZE;
+				const int base = m_samples.size();
+				m_samples.resize(base + BRICK_SIZE);
+				for (int s = 0; s < BRICK_SIZE; s++)
+				{
+					const int q = int(floor(dist[s] * quantize + btScalar(0.5)));
+					m_samples[base + s] = short(btClamped(q, -32767, 32767));
+				}
+			}
+
+	// The remaining bricks are all further than the band from the surface, so a face-connected group of them
+	// can't cross it: one winding number per group
+	btAlignedObjectArray<int> group;
+	for (int seed = 0; seed < numBricks; seed++)
+	{
+		if (m_bricks[seed] != BRICK_UNRESOLVED)
+		{
+			continue;
+		}
+		const int bx = seed % m_numBricks[0];
+		const int by = (seed / m_numBricks[0]) % m_numBricks[1];
+		const int bz = seed / (m_numBricks[0] * m_numBricks[1]);
+		const btVector3 center = m_origin + (btVector3(btScalar(bx), btScalar(by), btScalar(bz)) + btVector3(0.5, 0.5, 0.5)) * brickSize;
+		const int value = windingNumber(center, welded, triangles) > btScalar(0.5) ? BRICK_INSIDE : BRICK_OUTSIDE;
+
+		group.resize(0);
+		group.push_back(seed);
+		m_bricks[seed] = value;
+		for (int head = 0; head < group.size(); head++)
+		{
+			const int b = group[head];
+			const int coord[3] = {b % m_numBricks[0], (b / m_numBricks[0]) % m_numBricks[1], b / (m_numBricks[0] * m_numBricks[1])};
+			const int brickStep[3] = {1, m_numBricks[0], m_numBricks[0] * m_numBricks[1]};
+			for (int a = 0; a < 3; a++)
+			{
+				for (int dir = -1; dir <= 1; dir += 2)
+				{
+					const int c = coord[a] + dir;
+					if (c < 0 || c >= m_numBricks[a]) continue;
+					const int n = b + dir * brickStep[a];
+					if (m_bricks[n] != BRICK_UNRESOLVED) continue;
+					m_bricks[n] = value;
+					group.push_back(n);
+				}
+			}
+		}
+	}
+}
+
+bool btSdfBrickGrid::interpolate(const btVector3& x, btScalar& dist, btVector3* gradient) const
+{
+	if (!isValid())
+	{
+		return false;
+	}
+	const btScalar invCellSize = btScalar(1) / m_cellSize;
+	int brick[3];
+	int cell[3];
+	btScalar f[3];
+	for (int a = 0; a < 3; a++)
+	{
+		const btScalar g = (x[a] - m_origin[a]) * invCellSize;
+		const int numCells = m_numBricks[a] * BRICK_CELLS;
+		if (!(g >= btScalar(0) && g <= btScalar(numCells)))
+		{
+			return false;
+		}
+		const int c = btMin(int(g), numCells - 1);
+		brick[a] = c / BRICK_CELLS;
+		cell[a] = c - brick[a] * BRICK_CELLS;
+		f[a] = g - btScalar(c);
+	}
+
+	const int b = m_bricks[brick[0] + m_numBricks[0] * (brick[1] + m_numBricks[1] * brick[2])];
+	if (b < 0)
+	{
+		dist = b == BRICK_OUTSIDE ? m_band : -m_band;
+		if (gradient)
+		{
+			gradient->setValue(0, 0, 0);
+		}
+		return true;
+	}
+
+	const int dy = BRICK_SAMPLES;
+	const int dz = BRICK_SAMPLES * BRICK_SAMPLES;
+	const short* s = &m_samples[b * BRICK_SIZE + cell[0] + dy * cell[1] + dz * cell[2]];
+	const btScalar c000 = s[0], c100 = s[1], c010 = s[dy], c110 = s[dy + 1];
+	const btScalar c001 = s[dz], c101 = s[dz + 1], c011 = s[dz + dy], c111 = s[dz + dy + 1];
+
+	const btScalar c00 = c000 + (c100 - c000) * f[0];
+	const btScalar c10 = c010 + (c110 - c010) * f[0];
+	const btScalar c01 = c001 + (c101 - c001) * f[0];
+	const btScalar c11 = c011 + (c111 - c011) * f[0];
+	const btScalar c0 = c00 + (c10 - c00) * f[1];
+	const btScalar c1 = c01 + (c11 - c01) * f[1];
+	const btScalar scale = m_band / btScalar(32767);
+	dist = (c0 + (c1 - c0) * f[2]) * scale;
+
+	if (gradient)
+	{
+		const btScalar dx0 = (c100 - c000) + ((c110 - c010) - (c100 - c000)) * f[1];
+		const btScalar dx1 = (c101 - c001) + ((c111 - c011) - (c101 - c001)) * f[1];
+		const btScalar dyz0 = c10 - c00;
+		const btScalar dyz1 = c11 - c01;
+		gradient->setValue(
+			dx0 + (dx1 - dx0) * f[2],
+			dyz0 + (dyz1 - dyz0) * f[2],
+			c1 - c0);
+		*gradient *= scale * invCellSize;
+	}
+	return true;
+}
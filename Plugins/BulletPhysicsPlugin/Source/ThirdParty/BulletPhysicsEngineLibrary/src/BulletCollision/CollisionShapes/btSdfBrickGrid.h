@@ -0,0 +1,79 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2006 Erwin Coumans  https://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_SDF_BRICK_GRID_H
+#define BT_SDF_BRICK_GRID_H
+
+#include "LinearMath/btVector3.h"
+#include "LinearMath/btAlignedObjectArray.h"
+
+///
+/// btSdfBrickGrid
+///
+///  A sparse, quantized signed distance field, as an alternative to the Discregrid fields btMiniSDF loads.
+///  The domain is split into bricks of BRICK_CELLS^3 cells. Bricks within m_band of the surface keep all
+///  BRICK_SAMPLES^3 corner samples (shared faces are stored twice, so a lookup never touches a second brick)
+///  as 16-bit distances over [-m_band, m_band]. Every other brick is just BRICK_OUTSIDE or BRICK_INSIDE.
+///
+///  Distances are exact (up to quantization and trilinear interpolation) within the band and clamped beyond
+///  it, so the band has to cover the largest sphere/capsule radius that is tested against the centre of the shape.
+///
+ATTRIBUTE_ALIGNED16(struct)
+btSdfBrickGrid
+{
+	BT_DECLARE_ALIGNED_ALLOCATOR();
+
+	enum
+	{
+		BRICK_CELLS = 7,
+		BRICK_SAMPLES = BRICK_CELLS + 1,
+		BRICK_SIZE = BRICK_SAMPLES * BRICK_SAMPLES * BRICK_SAMPLES,
+		BRICK_OUTSIDE = -1,
+		BRICK_INSIDE = -2
+	};
+
+	// lower corner of the domain
+	btVector3 m_origin;
+	btScalar m_cellSize;
+	btScalar m_band;
+	int m_numBricks[3];
+	// per brick, x fastest: index of its samples in m_samples (in units of BRICK_SIZE), or BRICK_OUTSIDE / BRICK_INSIDE
+	btAlignedObjectArray<int> m_bricks;
+	// x fastest within a brick, distance = sample * m_band / 32767
+	btAlignedObjectArray<short> m_samples;
+
+	btSdfBrickGrid();
+
+	bool isValid() const
+	{
+		return m_bricks.size() > 0;
+	}
+
+	void getDomain(btVector3 & aabbMin, btVector3 & aabbMax) const;
+
+	///Bakes the field of a triangle mesh, which should be closed (the sign is taken from angle-weighted pseudonormals).
+	///Vertices at the same position are welded first, so meshes split at UV seams are fine. The band is raised to at
+	///least two cells. Either winding works, the mesh is flipped if its volume comes out negative.
+	void build(const btVector3* vertices, int numVertices, const int* indices, int numTriangles, btScalar cellSize, btScalar band);
+
+	///Trilinear distance at a point in the grid's space and, if asked, its gradient. Returns false outside the domain.
+	///Beyond the band the distance is +-m_band and the gradient is zero.
+	bool interpolate(const btVector3& x, btScalar& dist, btVector3* gradient) const;
+
+	///bytes used by the brick table and the samples
+	int getMemorySize() const;
+};
+
+#endif  //BT_SDF_BRICK_GRID_H
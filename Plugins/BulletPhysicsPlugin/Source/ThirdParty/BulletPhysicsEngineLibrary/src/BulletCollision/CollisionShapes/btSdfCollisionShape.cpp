@@ -1,5 +1,6 @@
 #include "btSdfCollisionShape.h"
 #include "btMiniSDF.h"
+#include "btSdfBrickGrid.h"
 #include "LinearMath/btAabbUtil2.h"
 
 ATTRIBUTE_ALIGNED16(struct)
@@ -10,6 +11,7 @@ btSdfCollisionShapeInternalData
 	btVector3 m_localScaling;
 	btScalar m_margin;
 	btMiniSDF m_sdf;
+	btSdfBrickGrid m_bricks;
 
 	btSdfCollisionShapeInternalData()
 		: m_localScaling(1, 1, 1),
@@ -23,6 +25,16 @@ bool btSdfCollisionShape::initializeSDF(const char* sdfData, int sizeInBytes)
 	bool valid = m_data->m_sdf.load(sdfData, sizeInBytes);
 	return valid;
 }
+btSdfBrickGrid& btSdfCollisionShape::getBrickGrid()
+{
+	return m_data->m_bricks;
+}
+
+const btSdfBrickGrid& btSdfCollisionShape::getBrickGrid() const
+{
+	return m_data->m_bricks;
+}
+
 btSdfCollisionShape::btSdfCollisionShape()
 {
 	m_shapeType = SDF_SHAPE_PROXYTYPE;
@@ -43,9 +55,13 @@ btSdfCollisionShape::~btSdfCollisionShape()
 
 void btSdfCollisionShape::getAabb(const btTransform& t, btVector3& aabbMin, btVector3& aabbMax) const
 {
-	btAssert(m_data->m_sdf.isValid());
+	btAssert(m_data->m_bricks.isValid() || m_data->m_sdf.isValid());
 	btVector3 localAabbMin = m_data->m_sdf.m_domain.m_min;
 	btVector3 localAabbMax = m_data->m_sdf.m_domain.m_max;
+	if (m_data->m_bricks.isValid())
+	{
+		m_data->m_bricks.getDomain(localAabbMin, localAabbMax);
+	}
 	btScalar margin(0);
 	btTransformAabb(localAabbMin, localAabbMax, margin, t, aabbMin, aabbMax);
 }
@@ -80,8 +96,13 @@ void btSdfCollisionShape::processAllTriangles(btTriangleCallback* callback, cons
 	//not yet
 }
 
-bool btSdfCollisionShape::queryPoint(const btVector3& ptInSDF, btScalar& distOut, btVector3& normal)
+bool btSdfCollisionShape::queryPoint(const btVector3& ptInSDF, btScalar& distOut, btVector3& normal) const
 {
+	if (m_data->m_bricks.isValid())
+	{
+		return m_data->m_bricks.interpolate(ptInSDF, distOut, &normal);
+	}
+
 	int field = 0;
 	btVector3 grad;
 	double dist;
@@ -93,3 +114,105 @@ bool btSdfCollisionShape::queryPoint(const btVector3& ptInSDF, btScalar& distOut
 	}
 	return hasResult;
 }
+
+btScalar btSdfCollisionShape::getCellSize() const
+{
+	if (m_data->m_bricks.isValid())
+	{
+		return m_data->m_bricks.m_cellSize;
+	}
+	const btVector3& cell = m_data->m_sdf.m_cell_size;
+	return btMin(cell.x(), btMin(cell.y(), cell.z()));
+}
+
+btScalar btSdfCollisionShape::getBand() const
+{
+	if (m_data->m_bricks.isValid())
+	{
+		return m_data->m_bricks.m_band;
+	}
+	return BT_LARGE_FLOAT;
+}
+
+bool btSdfCollisionShape::rayTest(const btVector3& rayFrom, const btVector3& rayTo, btScalar& hitFraction, btVector3& hitNormal) const
+{
+	btVector3 aabbMin, aabbMax;
+	getAabb(btTransform::getIdentity(), aabbMin, aabbMax);
+	const btVector3 dir = rayTo - rayFrom;
+	const btScalar length = dir.length();
+	if (length <= SIMD_EPSILON)
+	{
+		return false;
+	}
+
+	// clip the segment to the domain, the field isn't defined outside it
+	btScalar tMin = 0;
+	btScalar tMax = 1;
+	for (int a = 0; a < 3; a++)
+	{
+		if (btFabs(dir[a]) < SIMD_EPSILON)
+		{
+			if (rayFrom[a] < aabbMin[a] || rayFrom[a] > aabbMax[a]) return false;
+			continue;
+		}
+		btScalar t0 = (aabbMin[a] - rayFrom[a]) / dir[a];
+		btScalar t1 = (aabbMax[a] - rayFrom[a]) / dir[a];
+		if (t0 > t1) btSwap(t0, t1);
+		tMin = btMax(tMin, t0);
+		tMax = btMin(tMax, t1);
+	}
+	if (tMin > tMax)
+	{
+		return false;
+	}
+
+	// Sphere tracing, with a floor on the step so grazing rays still finish. A step that ends up inside is
+	// bisected back to the surface. Features thinner than the floor can be stepped over.
+	const btScalar minStep = btScalar(0.25) * getCellSize() / length;
+	const btScalar tolerance = btScalar(0.01) * getCellSize();
+	btScalar t = tMin;
+	btScalar prevT = tMin;
+	btScalar dist;
+	btVector3 grad;
+	while (t <= tMax)
+	{
+		if (!queryPoint(rayFrom + dir * t, dist, grad))
+		{
+			return false;
+		}
+		if (dist < tolerance)
+		{
+			if (dist < btScalar(0))
+			{
+				if (t == tMin)
+				{
+					// started inside
+					return false;
+				}
+				btScalar lo = prevT;
+				btScalar hi = t;
+				for (int i = 0; i < 16 && (hi - lo) * length > tolerance; i++)
+				{
+					const btScalar mid = btScalar(0.5) * (lo + hi);
+					queryPoint(rayFrom + dir * mid, dist, grad);
+					if (dist < btScalar(0))
+						hi = mid;
+					else
+						lo = mid;
+				}
+				t = hi;
+				queryPoint(rayFrom + dir * t, dist, grad);
+			}
+			if (grad.length2() <= SIMD_EPSILON)
+			{
+				return false;
+			}
+			hitFraction = t;
+			hitNormal = grad;
+			return true;
+		}
+		prevT = t;
+		t += btMax(dist / length, minStep);
+	}
+	return false;
+}
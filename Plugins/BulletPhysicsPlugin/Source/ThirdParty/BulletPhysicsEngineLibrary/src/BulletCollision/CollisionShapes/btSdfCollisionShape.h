@@ -3,6 +3,11 @@
 
 #include "btConcaveShape.h"
 
+struct btSdfBrickGrid;
+
+///A static signed distance field collider. The field is either a Discregrid file (initializeSDF) or a
+///btSdfBrickGrid baked from a mesh (getBrickGrid().build). Convex shapes collide through
+///btConvexConcaveCollisionAlgorithm, rays are marched through the field.
 class btSdfCollisionShape : public btConcaveShape
 {
 	struct btSdfCollisionShapeInternalData* m_data;
@@ -12,6 +17,9 @@ public:
 	virtual ~btSdfCollisionShape();
 
 	bool initializeSDF(const char* sdfData, int sizeInBytes);
+	///the brick grid used instead of the Discregrid data once it is valid
+	btSdfBrickGrid& getBrickGrid();
+	const btSdfBrickGrid& getBrickGrid() const;
 
 	virtual void getAabb(const btTransform& t, btVector3& aabbMin, btVector3& aabbMax) const;
 	virtual void setLocalScaling(const btVector3& scaling);
@@ -23,7 +31,16 @@ public:
 
 	virtual void processAllTriangles(btTriangleCallback* callback, const btVector3& aabbMin, const btVector3& aabbMax) const;
 
-	bool queryPoint(const btVector3& ptInSDF, btScalar& distOut, btVector3& normal);
+	bool queryPoint(const btVector3& ptInSDF, btScalar& distOut, btVector3& normal) const;
+
+	///size of one grid cell, the finest detail the field resolves
+	btScalar getCellSize() const;
+
+	///distances are only exact this close to the surface and clamped beyond it. BT_LARGE_FLOAT for Discregrid fields.
+	btScalar getBand() const;
+
+	///marches the segment through the field, in the shape's space. The normal is the (unnormalized) gradient at the hit.
+	bool rayTest(const btVector3& rayFrom, const btVector3& rayTo, btScalar& hitFraction, btVector3& hitNormal) const;
 };
 
 #endif  //BT_SDF_COLLISION_SHAPE_H
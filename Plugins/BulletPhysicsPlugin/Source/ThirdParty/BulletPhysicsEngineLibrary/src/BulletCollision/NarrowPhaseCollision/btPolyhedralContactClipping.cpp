@@ -233,10 +233,154 @@ SIMD_FORCE_INLINE void btSegmentsClosestPoints(
 	ptsVector = translation - offsetA + offsetB;
 }
 
+///Separating axis test on the Gauss maps, for hulls with adjacency. A face normal is only tested against the support
+///vertex of the other hull, found by hill climbing from the previous face's one. An edge pair is only tested when the arcs
+///of both edges cross on the Gauss map (they build a face of the Minkowski difference), and then only against the two
+///edges themselves. Faces are preferred over edges and faces of A over faces of B unless the other is clearly better.
+static bool findSeparatingAxisGaussMap(const btConvexPolyhedron& hullA, const btConvexPolyhedron& hullB, const btTransform& transA, const btTransform& transB, btVector3& sep, btDiscreteCollisionDetectorInterface::Result& resultOut)
+{
+	const btScalar relEdgeTolerance = btScalar(0.90);
+	const btScalar relFaceTolerance = btScalar(0.98);
+	const btScalar absTolerance = btScalar(0.0025);
+
+	const btTransform transBtoA = transA.inverseTimes(transB);
+	const btTransform transAtoB = transB.inverseTimes(transA);
+
+	btScalar faceSepA = -BT_LARGE_FLOAT;
+	int faceA = -1;
+	int support = 0;
+	for (int i = 0; i < hullA.m_faces.size(); i++)
+	{
+		const btVector3 normal(hullA.m_faces[i].m_plane[0], hullA.m_faces[i].m_plane[1], hullA.m_faces[i].m_plane[2]);
+		support = hullB.hillClimbSupport(-normal * transBtoA.getBasis(), support);
+		const btScalar d = normal.dot(transBtoA * hullB.m_vertices[support]) + hullA.m_faces[i].m_plane[3];
+		if (d > 0)
+			return false;
+		if (d > faceSepA)
+		{
+			faceSepA = d;
+			faceA = i;
+		}
+	}
+
+	btScalar faceSepB = -BT_LARGE_FLOAT;
+	int faceB = -1;
+	support = 0;
+	for (int i = 0; i < hullB.m_faces.size(); i++)
+	{
+		const btVector3 normal(hullB.m_faces[i].m_plane[0], hullB.m_faces[i].m_plane[1], hullB.m_faces[i].m_plane[2]);
+		support = hullA.hillClimbSupport(-normal * transAtoB.getBasis(), support);
+		const btScalar d = normal.dot(transAtoB * hullA.m_vertices[support]) + hullB.m_faces[i].m_plane[3];
+		if (d > 0)
+			return false;
+		if (d > faceSepB)
+		{
+			faceSepB = d;
+			faceB = i;
+		}
+	}
+
+	//edges in B's space, so only the edges of A have to be transformed
+	btScalar edgeSep = -BT_LARGE_FLOAT;
+	int edgeA = -1;
+	int edgeB = -1;
+	btVector3 edgeAxis(0, 0, 0);
+	const btVector3 centerA = transAtoB * hullA.m_localCenter;
+	for (int i = 0; i < hullA.m_edges.size(); i++)
+	{
+		const btPolyhedronEdge& edge0 = hullA.m_edges[i];
+		const btFace& face0 = hullA.m_faces[edge0.m_face0];
+		const btFace& face1 = hullA.m_faces[edge0.m_face1];
+		const btVector3 a = transAtoB.getBasis() * btVector3(face0.m_plane[0], face0.m_plane[1], face0.m_plane[2]);
+		const btVector3 b = transAtoB.getBasis() * btVector3(face1.m_plane[0], face1.m_plane[1], face1.m_plane[2]);
+		const btVector3 bxa = b.cross(a);
+		const btVector3 pA = transAtoB * hullA.m_vertices[edge0.m_vertex0];
+		const btVector3 dirA = transAtoB.getBasis() * (hullA.m_vertices[edge0.m_vertex1] - hullA.m_vertices[edge0.m_vertex0]);
+
+		for (int j = 0; j < hullB.m_edges.size(); j++)
+		{
+			const btPolyhedronEdge& edge1 = hullB.m_edges[j];
+			const btFace& face2 = hullB.m_faces[edge1.m_face0];
+			const btFace& face3 = hullB.m_faces[edge1.m_face1];
+			//B's normals are negated, the Minkowski difference is A - B
+			const btVector3 c(-face2.m_plane[0], -face2.m_plane[1], -face2.m_plane[2]);
+			const btVector3 d(-face3.m_plane[0], -face3.m_plane[1], -face3.m_plane[2]);
+			const btVector3 dxc = d.cross(c);
+			const btScalar cba = c.dot(bxa);
+			const btScalar dba = d.dot(bxa);
+			const btScalar adc = a.dot(dxc);
+			const btScalar bdc = b.dot(dxc);
+			if (!(cba * dba < 0 && adc * bdc < 0 && cba * bdc > 0))
+				continue;
+
+			const btVector3 dirB = hullB.m_vertices[edge1.m_vertex1] - hullB.m_vertices[edge1.m_vertex0];
+			btVector3 axis = dirA.cross(dirB);
+			const btScalar length2 = axis.length2();
+			//parallel edges, the faces cover them
+			if (length2 < SIMD_EPSILON * dirA.length2() * dirB.length2())
+				continue;
+			axis /= btSqrt(length2);
+			if (axis.dot(pA - centerA) < 0)
+				axis = -axis;
+			const btScalar dist = axis.dot(hullB.m_vertices[edge1.m_vertex0] - pA);
+			if (dist > 0)
+				return false;
+			if (dist > edgeSep)
+			{
+				edgeSep = dist;
+				edgeA = i;
+				edgeB = j;
+				edgeAxis = axis;
+			}
+		}
+	}
+
+	if (edgeA >= 0 && edgeSep > relEdgeTolerance * btMax(faceSepA, faceSepB) + absTolerance)
+	{
+		//the axis points from A to B
+		sep = -(transB.getBasis() * edgeAxis);
+
+		const btPolyhedronEdge& edge0 = hullA.m_edges[edgeA];
+		const btPolyhedronEdge& edge1 = hullB.m_edges[edgeB];
+		const btVector3 a0 = transA * hullA.m_vertices[edge0.m_vertex0];
+		const btVector3 a1 = transA * hullA.m_vertices[edge0.m_vertex1];
+		const btVector3 b0 = transB * hullB.m_vertices[edge1.m_vertex0];
+		const btVector3 b1 = transB * hullB.m_vertices[edge1.m_vertex1];
+		btVector3 dirA = a1 - a0;
+		btVector3 dirB = b1 - b0;
+		const btScalar hlenA = dirA.length() * btScalar(0.5);
+		const btScalar hlenB = dirB.length() * btScalar(0.5);
+		dirA /= 2 * hlenA;
+		dirB /= 2 * hlenB;
+		const btVector3 centerEdgeB = (b0 + b1) * btScalar(0.5);
+
+		btVector3 ptsVector, offsetA, offsetB;
+		btScalar tA, tB;
+		btSegmentsClosestPoints(ptsVector, offsetA, offsetB, tA, tB, centerEdgeB - (a0 + a1) * btScalar(0.5), dirA, hlenA, dirB, hlenB);
+		resultOut.addContactPoint(sep, centerEdgeB + offsetB, edgeSep);
+	}
+	else if (faceSepB > relFaceTolerance * faceSepA + absTolerance)
+	{
+		const btFace& face = hullB.m_faces[faceB];
+		sep = transB.getBasis() * btVector3(face.m_plane[0], face.m_plane[1], face.m_plane[2]);
+	}
+	else
+	{
+		const btFace& face = hullA.m_faces[faceA];
+		sep = -(transA.getBasis() * btVector3(face.m_plane[0], face.m_plane[1], face.m_plane[2]));
+	}
+	return true;
+}
+
 bool btPolyhedralContactClipping::findSeparatingAxis(const btConvexPolyhedron& hullA, const btConvexPolyhedron& hullB, const btTransform& transA, const btTransform& transB, btVector3& sep, btDiscreteCollisionDetectorInterface::Result& resultOut)
 {
 	gActualSATPairTests++;
 
+	if (hullA.m_edges.size() && hullB.m_edges.size())
+	{
+		return findSeparatingAxisGaussMap(hullA, hullB, transA, transB, sep, resultOut);
+	}
+
 	//#ifdef TEST_INTERNAL_OBJECTS
 	const btVector3 c0 = transA * hullA.m_localCenter;
 	const btVector3 c1 = transB * hullB.m_localCenter;
@@ -517,7 +517,9 @@ static void writeGrainSizes(btBatchedConstraints* bc)
 	typedef btBatchedConstraints::Range Range;
 	int numPhases = bc->m_phases.size();
 	bc->m_phaseGrainSize.resizeNoInitialize(numPhases);
-	int numThreads = btGetTaskScheduler()->getNumThreads();
+	// no task scheduler when batching for a single threaded solver
+	btITaskScheduler* taskScheduler = btGetTaskScheduler();
+	int numThreads = taskScheduler ? taskScheduler->getNumThreads() : 1;
 	for (int iPhase = 0; iPhase < numPhases; ++iPhase)
 	{
 		const Range& phase = bc->m_phases[iPhase];
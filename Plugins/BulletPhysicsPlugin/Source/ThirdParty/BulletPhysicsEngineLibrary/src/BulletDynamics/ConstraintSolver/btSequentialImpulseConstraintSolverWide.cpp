@@ -0,0 +1,914 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2006 Erwin Coumans  https://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "btSequentialImpulseConstraintSolverWide.h"
+
+#include "LinearMath/btQuickprof.h"
+#include "LinearMath/btCpuFeatureUtility.h"
+
+#include "BulletDynamics/ConstraintSolver/btTypedConstraint.h"
+#include "BulletDynamics/Dynamics/btRigidBody.h"
+
+#ifdef BT_CPU_FEATURE_X86_AVX2
+#define BT_WIDE_SSE 1
+#include <immintrin.h>
+#endif
+
+btBatchedConstraints::BatchingMethod btSequentialImpulseConstraintSolverWide::s_batchingMethod = btBatchedConstraints::BATCHING_METHOD_SPATIAL_GRID_2D;
+
+typedef btSequentialImpulseConstraintSolverWide btWideSolver;
+
+// MSVC compiles any intrinsic anywhere, GCC/Clang need the AVX2 kernel tagged with the instruction set (AVX2 only,
+// no FMA). flatten pulls the lane helpers into the tagged kernel so they end up inlined.
+#if defined(_MSC_VER) && !defined(__clang__)
+#define BT_WIDE_TARGET_AVX2
+#define BT_WIDE_FLATTEN
+#else
+#define BT_WIDE_TARGET_AVX2 __attribute__((target("avx2")))
+#define BT_WIDE_FLATTEN __attribute__((flatten))
+#endif
+
+// The kernels must never fuse a multiply and an add, whatever the build flags are, or machines would round differently.
+#if defined(__clang__)
+#pragma float_control(push)
+#pragma clang fp contract(off)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC optimize("fp-contract=off")
+#pragma GCC diagnostic push
+// the shared kernel template only ever runs inlined into the tagged AVX2 wrapper
+#pragma GCC diagnostic ignored "-Wpsabi"
+#elif defined(_MSC_VER)
+#pragma fp_contract(off)
+#endif
+
+// Lane helpers, all WIDE_WIDTH wide. AVX2, two SSE2 halves and the scalar version do exactly the same IEEE operation
+// per lane, that's what keeps every CPU in lockstep.
+struct btWideLanesScalar
+{
+	enum
+	{
+		Width = btWideSolver::WIDE_WIDTH
+	};
+	struct V
+	{
+		btScalar l[Width];
+	};
+	typedef unsigned M;
+	static SIMD_FORCE_INLINE V zero()
+	{
+		V r;
+		for (int i = 0; i < Width; i++) r.l[i] = btScalar(0);
+		return r;
+	}
+	static SIMD_FORCE_INLINE V load(const btScalar* p)
+	{
+		V r;
+		for (int i = 0; i < Width; i++) r.l[i] = p[i];
+		return r;
+	}
+	static SIMD_FORCE_INLINE void store(btScalar* p, V v)
+	{
+		for (int i = 0; i < Width; i++) p[i] = v.l[i];
+	}
+	static SIMD_FORCE_INLINE V add(V a, V b)
+	{
+		for (int i = 0; i < Width; i++) a.l[i] = a.l[i] + b.l[i];
+		return a;
+	}
+	static SIMD_FORCE_INLINE V sub(V a, V b)
+	{
+		for (int i = 0; i < Width; i++) a.l[i] = a.l[i] - b.l[i];
+		return a;
+	}
+	static SIMD_FORCE_INLINE V mul(V a, V b)
+	{
+		for (int i = 0; i < Width; i++) a.l[i] = a.l[i] * b.l[i];
+		return a;
+	}
+	static SIMD_FORCE_INLINE V div(V a, V b)
+	{
+		for (int i = 0; i < Width; i++) a.l[i] = a.l[i] / b.l[i];
+		return a;
+	}
+	// same as maxps: the second operand unless the first is greater
+	static SIMD_FORCE_INLINE V max(V a, V b)
+	{
+		for (int i = 0; i < Width; i++) a.l[i] = a.l[i] > b.l[i] ? a.l[i] : b.l[i];
+		return a;
+	}
+	static SIMD_FORCE_INLINE M less(V a, V b)
+	{
+		M m = 0;
+		for (int i = 0; i < Width; i++) m |= (a.l[i] < b.l[i] ? 1u : 0u) << i;
+		return m;
+	}
+	static SIMD_FORCE_INLINE M both(M a, M b) { return a & b; }
+	static SIMD_FORCE_INLINE V select(M m, V a, V b)
+	{
+		for (int i = 0; i < Width; i++) a.l[i] = (m & (1u << i)) ? a.l[i] : b.l[i];
+		return a;
+	}
+	static SIMD_FORCE_INLINE unsigned bits(M m) { return m; }
+	static SIMD_FORCE_INLINE M used(const int* rows)
+	{
+		M m = 0;
+		for (int i = 0; i < Width; i++) m |= (rows[i] >= 0 ? 1u : 0u) << i;
+		return m;
+	}
+	static SIMD_FORCE_INLINE V gather(const btScalar* base, const int* offsets, int component)
+	{
+		V r;
+		for (int i = 0; i < Width; i++) r.l[i] = base[offsets[i] + component];
+		return r;
+	}
+};
+
+#ifdef BT_WIDE_SSE
+// a bundle as two SSE2 halves
+struct btWideLanesSse
+{
+	enum
+	{
+		Width = 8
+	};
+	struct V
+	{
+		__m128 lo, hi;
+	};
+	typedef V M;
+	static SIMD_FORCE_INLINE V make(__m128 lo, __m128 hi)
+	{
+		V r;
+		r.lo = lo;
+		r.hi = hi;
+		return r;
+	}
+	static SIMD_FORCE_INLINE V zero() { return make(_mm_setzero_ps(), _mm_setzero_ps()); }
+	static SIMD_FORCE_INLINE V load(const btScalar* p) { return make(_mm_loadu_ps(p), _mm_loadu_ps(p + 4)); }
+	static SIMD_FORCE_INLINE void store(btScalar* p, V v)
+	{
+		_mm_storeu_ps(p, v.lo);
+		_mm_storeu_ps(p + 4, v.hi);
+	}
+	static SIMD_FORCE_INLINE V add(V a, V b) { return make(_mm_add_ps(a.lo, b.lo), _mm_add_ps(a.hi, b.hi)); }
+	static SIMD_FORCE_INLINE V sub(V a, V b) { return make(_mm_sub_ps(a.lo, b.lo), _mm_sub_ps(a.hi, b.hi)); }
+	static SIMD_FORCE_INLINE V mul(V a, V b) { return make(_mm_mul_ps(a.lo, b.lo), _mm_mul_ps(a.hi, b.hi)); }
+	static SIMD_FORCE_INLINE V div(V a, V b) { return make(_mm_div_ps(a.lo, b.lo), _mm_div_ps(a.hi, b.hi)); }
+	static SIMD_FORCE_INLINE V max(V a, V b) { return make(_mm_max_ps(a.lo, b.lo), _mm_max_ps(a.hi, b.hi)); }
+	static SIMD_FORCE_INLINE M less(V a, V b) { return make(_mm_cmplt_ps(a.lo, b.lo), _mm_cmplt_ps(a.hi, b.hi)); }
+	static SIMD_FORCE_INLINE M both(M a, M b) { return make(_mm_and_ps(a.lo, b.lo), _mm_and_ps(a.hi, b.hi)); }
+	static SIMD_FORCE_INLINE V select(M m, V a, V b)
+	{
+		return make(_mm_or_ps(_mm_and_ps(m.lo, a.lo), _mm_andnot_ps(m.lo, b.lo)), _mm_or_ps(_mm_and_ps(m.hi, a.hi), _mm_andnot_ps(m.hi, b.hi)));
+	}
+	static SIMD_FORCE_INLINE unsigned bits(M m) { return (unsigned)_mm_movemask_ps(m.lo) | ((unsigned)_mm_movemask_ps(m.hi) << 4); }
+	static SIMD_FORCE_INLINE M used(const int* rows)
+	{
+		const __m128i minusOne = _mm_set1_epi32(-1);
+		return make(_mm_castsi128_ps(_mm_cmpgt_epi32(_mm_loadu_si128((const __m128i*)rows), minusOne)),
+					_mm_castsi128_ps(_mm_cmpgt_epi32(_mm_loadu_si128((const __m128i*)(rows + 4)), minusOne)));
+	}
+	static SIMD_FORCE_INLINE V gather(const btScalar* base, const int* offsets, int component)
+	{
+		return make(_mm_setr_ps(base[offsets[0] + component], base[offsets[1] + component], base[offsets[2] + component], base[offsets[3] + component]),
+					_mm_setr_ps(base[offsets[4] + component], base[offsets[5] + component], base[offsets[6] + component], base[offsets[7] + component]));
+	}
+};
+
+struct btWideLanesAvx2
+{
+	enum
+	{
+		Width = 8
+	};
+	typedef __m256 V;
+	typedef __m256 M;
+	static BT_WIDE_TARGET_AVX2 inline V zero() { return _mm256_setzero_ps(); }
+	static BT_WIDE_TARGET_AVX2 inline V load(const btScalar* p) { return _mm256_loadu_ps(p); }
+	static BT_WIDE_TARGET_AVX2 inline void store(btScalar* p, V v) { _mm256_storeu_ps(p, v); }
+	static BT_WIDE_TARGET_AVX2 inline V add(V a, V b) { return _mm256_add_ps(a, b); }
+	static BT_WIDE_TARGET_AVX2 inline V sub(V a, V b) { return _mm256_sub_ps(a, b); }
+	static BT_WIDE_TARGET_AVX2 inline V mul(V a, V b) { return _mm256_mul_ps(a, b); }
+	static BT_WIDE_TARGET_AVX2 inline V div(V a, V b) { return _mm256_div_ps(a, b); }
+	static BT_WIDE_TARGET_AVX2 inline V max(V a, V b) { return _mm256_max_ps(a, b); }
+	static BT_WIDE_TARGET_AVX2 inline M less(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+	static BT_WIDE_TARGET_AVX2 inline M both(M a, M b) { return _mm256_and_ps(a, b); }
+	static BT_WIDE_TARGET_AVX2 inline V select(M m, V a, V b) { return _mm256_blendv_ps(b, a, m); }
+	static BT_WIDE_TARGET_AVX2 inline unsigned bits(M m) { return (unsigned)_mm256_movemask_ps(m); }
+	static BT_WIDE_TARGET_AVX2 inline M used(const int* rows) { return _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_loadu_si256((const __m256i*)rows), _mm256_set1_epi32(-1))); }
+	static BT_WIDE_TARGET_AVX2 inline V gather(const btScalar* base, const int* offsets, int component)
+	{
+		__m256i index = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)offsets), _mm256_set1_epi32(component));
+		return _mm256_i32gather_ps(base, index, 4);
+	}
+};
+#endif  //BT_WIDE_SSE
+
+// Projected Gauss-Seidel on a run of bundles, the same steps as gResolveSingleConstraintRowGeneric_sse2 for every lane.
+// Friction rows (contactFields != NULL) take their limits from the applied impulse of their contact and are skipped
+// while it is zero. Bodies are read and written in place; lanes of one bundle never share a moving body.
+template <class L>
+static SIMD_FORCE_INLINE btScalar btSolveWideBundles(btScalar* fields, const int* indices, int numBundles, btScalar* bodies, int angularOffset, const btScalar* contactFields)
+{
+	typedef typename L::V V;
+	typedef typename L::M M;
+	const int W = L::Width;
+	V maxResidual = L::zero();
+	btScalar velocities[12 * W];
+	for (int b = 0; b < numBundles; b++)
+	{
+		btScalar* f = fields + b * btWideSolver::WIDE_NUM_FIELDS * W;
+		const int* n = indices + b * btWideSolver::WIDE_NUM_INDICES * W;
+		const int* bodyA = n + btWideSolver::WIDE_BODY_A * W;
+		const int* bodyB = n + btWideSolver::WIDE_BODY_B * W;
+#define BT_WIDE_FIELD(field) L::load(f + (btWideSolver::field) * W)
+
+		M active = L::used(n + btWideSolver::WIDE_ROW * W);
+		V applied = BT_WIDE_FIELD(WIDE_APPLIED_IMPULSE);
+		V lowerLimit, upperLimit;
+		if (contactFields)
+		{
+			V totalImpulse = L::gather(contactFields, n + btWideSolver::WIDE_CONTACT * W, 0);
+			active = L::both(active, L::less(L::zero(), totalImpulse));
+			upperLimit = L::mul(BT_WIDE_FIELD(WIDE_FRICTION), totalImpulse);
+			lowerLimit = L::sub(L::zero(), upperLimit);
+		}
+		else
+		{
+			lowerLimit = BT_WIDE_FIELD(WIDE_LOWER_LIMIT);
+			upperLimit = BT_WIDE_FIELD(WIDE_UPPER_LIMIT);
+		}
+		if (!L::bits(active))
+		{
+			continue;
+		}
+
+		V linA[3], angA[3], linB[3], angB[3];
+		for (int i = 0; i < 3; i++)
+		{
+			linA[i] = L::gather(bodies, bodyA, i);
+			angA[i] = L::gather(bodies, bodyA, angularOffset + i);
+			linB[i] = L::gather(bodies, bodyB, i);
+			angB[i] = L::gather(bodies, bodyB, angularOffset + i);
+		}
+
+		V jacDiagABInv = BT_WIDE_FIELD(WIDE_JAC_DIAG_AB_INV);
+		V deltaImpulse = L::sub(BT_WIDE_FIELD(WIDE_RHS), L::mul(applied, BT_WIDE_FIELD(WIDE_CFM)));
+		V deltaVel1Dotn = L::add(L::add(L::add(L::mul(BT_WIDE_FIELD(WIDE_NORMAL1_X), linA[0]), L::mul(BT_WIDE_FIELD(WIDE_NORMAL1_Y), linA[1])), L::mul(BT_WIDE_FIELD(WIDE_NORMAL1_Z), linA[2])),
+								 L::add(L::add(L::mul(BT_WIDE_FIELD(WIDE_RELPOS1_CROSS_NORMAL_X), angA[0]), L::mul(BT_WIDE_FIELD(WIDE_RELPOS1_CROSS_NORMAL_Y), angA[1])), L::mul(BT_WIDE_FIELD(WIDE_RELPOS1_CROSS_NORMAL_Z), angA[2])));
+		V deltaVel2Dotn = L::add(L::add(L::add(L::mul(BT_WIDE_FIELD(WIDE_NORMAL2_X), linB[0]), L::mul(BT_WIDE_FIELD(WIDE_NORMAL2_Y), linB[1])), L::mul(BT_WIDE_FIELD(WIDE_NORMAL2_Z), linB[2])),
+								 L::add(L::add(L::mul(BT_WIDE_FIELD(WIDE_RELPOS2_CROSS_NORMAL_X), angB[0]), L::mul(BT_WIDE_FIELD(WIDE_RELPOS2_CROSS_NORMAL_Y), angB[1])), L::mul(BT_WIDE_FIELD(WIDE_RELPOS2_CROSS_NORMAL_Z), angB[2])));
+		deltaImpulse = L::sub(deltaImpulse, L::mul(deltaVel1Dotn, jacDiagABInv));
+		deltaImpulse = L::sub(deltaImpulse, L::mul(deltaVel2Dotn, jacDiagABInv));
+
+		// clamp to [lower, upper]
+		V sum = L::add(applied, deltaImpulse);
+		M lowerLess = L::less(sum, lowerLimit);
+		M upperLess = L::less(sum, upperLimit);
+		deltaImpulse = L::select(lowerLess, L::sub(lowerLimit, applied), deltaImpulse);
+		V newApplied = L::select(lowerLess, lowerLimit, sum);
+		deltaImpulse = L::select(upperLess, deltaImpulse, L::sub(upperLimit, applied));
+		newApplied = L::select(upperLess, newApplied, upperLimit);
+
+		deltaImpulse = L::select(active, deltaImpulse, L::zero());
+		L::store(f + btWideSolver::WIDE_APPLIED_IMPULSE * W, L::select(active, newApplied, applied));
+		V residual = L::div(deltaImpulse, jacDiagABInv);
+		maxResidual = L::max(maxResidual, L::mul(residual, residual));
+
+		for (int i = 0; i < 3; i++)
+		{
+			L::store(velocities + (0 + i) * W, L::add(linA[i], L::mul(BT_WIDE_FIELD(WIDE_LINEAR_COMPONENT_A_X + i), deltaImpulse)));
+			L::store(velocities + (3 + i) * W, L::add(angA[i], L::mul(BT_WIDE_FIELD(WIDE_ANGULAR_COMPONENT_A_X + i), deltaImpulse)));
+			L::store(velocities + (6 + i) * W, L::add(linB[i], L::mul(BT_WIDE_FIELD(WIDE_LINEAR_COMPONENT_B_X + i), deltaImpulse)));
+			L::store(velocities + (9 + i) * W, L::add(angB[i], L::mul(BT_WIDE_FIELD(WIDE_ANGULAR_COMPONENT_B_X + i), deltaImpulse)));
+		}
+#undef BT_WIDE_FIELD
+
+		// scatter in lane order; only static and kinematic bodies (whose deltas stay zero) can show up in more than one lane
+		unsigned laneBits = L::bits(active);
+		for (int l = 0; l < W; l++)
+		{
+			if (laneBits & (1u << l))
+			{
+				btScalar* a = bodies + bodyA[l];
+				btScalar* c = bodies + bodyB[l];
+				for (int i = 0; i < 3; i++)
+				{
+					a[i] = velocities[(0 + i) * W + l];
+					a[angularOffset + i] = velocities[(3 + i) * W + l];
+					c[i] = velocities[(6 + i) * W + l];
+					c[angularOffset + i] = velocities[(9 + i) * W + l];
+				}
+			}
+		}
+	}
+
+	btScalar residuals[W];
+	L::store(residuals, maxResidual);
+	btScalar leastSquaresResidual = 0;
+	for (int l = 0; l < W; l++)
+	{
+		leastSquaresResidual = btMax(leastSquaresResidual, residuals[l]);
+	}
+	return leastSquaresResidual;
+}
+
+static btScalar btSolveWideBundlesScalar(btScalar* fields, const int* indices, int numBundles, btScalar* bodies, int angularOffset, const btScalar* contactFields)
+{
+	return btSolveWideBundles<btWideLanesScalar>(fields, indices, numBundles, bodies, angularOffset, contactFields);
+}
+
+#ifdef BT_WIDE_SSE
+static btScalar btSolveWideBundlesSse(btScalar* fields, const int* indices, int numBundles, btScalar* bodies, int angularOffset, const btScalar* contactFields)
+{
+	return btSolveWideBundles<btWideLanesSse>(fields, indices, numBundles, bodies, angularOffset, contactFields);
+}
+
+BT_WIDE_TARGET_AVX2 BT_WIDE_FLATTEN static btScalar btSolveWideBundlesAvx2(btScalar* fields, const int* indices, int numBundles, btScalar* bodies, int angularOffset, const btScalar* contactFields)
+{
+	return btSolveWideBundles<btWideLanesAvx2>(fields, indices, numBundles, bodies, angularOffset, contactFields);
+}
+#endif  //BT_WIDE_SSE
+
+#if defined(__clang__)
+#pragma float_control(pop)
+#elif defined(__GNUC__)
+#pragma GCC diagnostic pop
+#pragma GCC pop_options
+#endif
+
+// The bundles visit the pool rows out of order and the pools don't fit in L2, so the setup asks for the rows a few
+// bundles ahead of the one it fills.
+static SIMD_FORCE_INLINE void btWidePrefetchRow(const btSolverConstraint& row)
+{
+#ifdef BT_WIDE_SSE
+	const char* p = (const char*)&row;
+	_mm_prefetch(p, _MM_HINT_T0);
+	_mm_prefetch(p + 64, _MM_HINT_T0);
+	_mm_prefetch(p + 128, _MM_HINT_T0);
+	_mm_prefetch(p + sizeof(btSolverConstraint) - 1, _MM_HINT_T0);
+#else
+	(void)row;
+#endif
+}
+
+btSequentialImpulseConstraintSolverWide::btSequentialImpulseConstraintSolverWide()
+{
+	m_wideKernel = getMaxWideKernel();
+	memset(&m_unusedRow, 0, sizeof(m_unusedRow));
+	m_unusedRow.m_jacDiagABInv = btScalar(1);
+	m_useWideRows = false;
+	m_bodiesPacked = false;
+	m_minBatchedRows = 16;
+	m_packBodyVelocities = true;
+}
+
+btSequentialImpulseConstraintSolverWide::~btSequentialImpulseConstraintSolverWide()
+{
+}
+
+int btSequentialImpulseConstraintSolverWide::getMaxWideKernel()
+{
+#ifdef BT_WIDE_SSE
+	if (btCpuFeatureUtility::getCpuFeatures() & btCpuFeatureUtility::CPU_FEATURE_AVX2)
+	{
+		return WIDE_KERNEL_AVX2;
+	}
+	return WIDE_KERNEL_SSE2;
+#else
+	return WIDE_KERNEL_SCALAR;
+#endif
+}
+
+void btSequentialImpulseConstraintSolverWide::setWideKernel(int kernel)
+{
+	m_wideKernel = btMin(btMax(kernel, int(WIDE_KERNEL_SCALAR)), getMaxWideKernel());
+}
+
+// x, y and z of a btVector3 of every lane into three consecutive fields
+static SIMD_FORCE_INLINE void btWideSetVectorFields(btScalar* f, int field, const btVector3* const* lanes)
+{
+	const int W = btWideSolver::WIDE_WIDTH;
+#ifdef BT_WIDE_SSE
+	// four lanes at a time, the rows of a 4x4 transpose (w is dropped)
+	for (int l = 0; l < W; l += 4)
+	{
+		__m128 x = _mm_load_ps(lanes[l + 0]->m_floats);
+		__m128 y = _mm_load_ps(lanes[l + 1]->m_floats);
+		__m128 z = _mm_load_ps(lanes[l + 2]->m_floats);
+		__m128 w = _mm_load_ps(lanes[l + 3]->m_floats);
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+		_mm_store_ps(f + (field + 0) * W + l, x);
+		_mm_store_ps(f + (field + 1) * W + l, y);
+		_mm_store_ps(f + (field + 2) * W + l, z);
+	}
+#else
+	for (int i = 0; i < 3; ++i)
+	{
+		for (int l = 0; l < W; ++l)
+		{
+			f[(field + i) * W + l] = (*lanes[l])[i];
+		}
+	}
+#endif
+}
+
+void btSequentialImpulseConstraintSolverWide::setupWideBundle(btScalar* f, int* n, const btConstraintArray& pool, const int* rows, const int* contactSlots)
+{
+	const int W = WIDE_WIDTH;
+	const int bodyStride = m_bodiesPacked ? int(WIDE_BODY_STRIDE) : int(sizeof(btSolverBody) / sizeof(btScalar));
+	// unused lanes (row -1) read m_unusedRow: harmless values, never written back
+	const btSolverConstraint* c[W];
+	btVector3 linearComponentA[W];
+	btVector3 linearComponentB[W];
+	for (int l = 0; l < W; ++l)
+	{
+		c[l] = rows[l] >= 0 ? &pool[rows[l]] : &m_unusedRow;
+		linearComponentA[l] = c[l]->m_contactNormal1 * m_tmpSolverBodyPool[c[l]->m_solverBodyIdA].internalGetInvMass();
+		linearComponentB[l] = c[l]->m_contactNormal2 * m_tmpSolverBodyPool[c[l]->m_solverBodyIdB].internalGetInvMass();
+	}
+	// a field of every lane at a time, so the stores fill the bundle one cache line after the other
+	const btVector3* v[W];
+	for (int l = 0; l < W; ++l) v[l] = &c[l]->m_contactNormal1;
+	btWideSetVectorFields(f, WIDE_NORMAL1_X, v);
+	for (int l = 0; l < W; ++l) v[l] = &c[l]->m_relpos1CrossNormal;
+	btWideSetVectorFields(f, WIDE_RELPOS1_CROSS_NORMAL_X, v);
+	for (int l = 0; l < W; ++l) v[l] = &c[l]->m_contactNormal2;
+	btWideSetVectorFields(f, WIDE_NORMAL2_X, v);
+	for (int l = 0; l < W; ++l) v[l] = &c[l]->m_relpos2CrossNormal;
+	btWideSetVectorFields(f, WIDE_RELPOS2_CROSS_NORMAL_X, v);
+	for (int l = 0; l < W; ++l) v[l] = &c[l]->m_angularComponentA;
+	btWideSetVectorFields(f, WIDE_ANGULAR_COMPONENT_A_X, v);
+	for (int l = 0; l < W; ++l) v[l] = &c[l]->m_angularComponentB;
+	btWideSetVectorFields(f, WIDE_ANGULAR_COMPONENT_B_X, v);
+	for (int l = 0; l < W; ++l) v[l] = &linearComponentA[l];
+	btWideSetVectorFields(f, WIDE_LINEAR_COMPONENT_A_X, v);
+	for (int l = 0; l < W; ++l) v[l] = &linearComponentB[l];
+	btWideSetVectorFields(f, WIDE_LINEAR_COMPONENT_B_X, v);
+	for (int l = 0; l < W; ++l) f[WIDE_RHS * W + l] = c[l]->m_rhs;
+	for (int l = 0; l < W; ++l) f[WIDE_CFM * W + l] = c[l]->m_cfm;
+	for (int l = 0; l < W; ++l) f[WIDE_JAC_DIAG_AB_INV * W + l] = c[l]->m_jacDiagABInv;
+	for (int l = 0; l < W; ++l) f[WIDE_LOWER_LIMIT * W + l] = c[l]->m_lowerLimit;
+	for (int l = 0; l < W; ++l) f[WIDE_UPPER_LIMIT * W + l] = c[l]->m_upperLimit;
+	for (int l = 0; l < W; ++l) f[WIDE_FRICTION * W + l] = c[l]->m_friction;
+	for (int l = 0; l < W; ++l) f[WIDE_APPLIED_IMPULSE * W + l] = btScalar(c[l]->m_appliedImpulse);
+	for (int l = 0; l < W; ++l) f[WIDE_UNUSED * W + l] = btScalar(0);
+	for (int l = 0; l < W; ++l)
+	{
+		n[WIDE_BODY_A * W + l] = c[l]->m_solverBodyIdA * bodyStride;
+		n[WIDE_BODY_B * W + l] = c[l]->m_solverBodyIdB * bodyStride;
+		n[WIDE_ROW * W + l] = rows[l];
+		n[WIDE_CONTACT * W + l] = contactSlots[l];
+	}
+}
+
+void btSequentialImpulseConstraintSolverWide::setupWideContactRows(const btBatchedConstraints& batches)
+{
+	BT_PROFILE("setupWideContactRows");
+	typedef btBatchedConstraints::Range Range;
+	const int W = WIDE_WIDTH;
+	const btConstraintArray& pool = m_tmpSolverContactConstraintPool;
+
+	// static and kinematic bodies (whose deltas stay zero) can share a bundle, moving ones start out in none
+	const int sharedBody = -2;
+	m_bodyBundle.resizeNoInitialize(m_tmpSolverBodyPool.size());
+	for (int i = 0; i < m_bodyBundle.size(); ++i)
+	{
+		const btRigidBody* body = m_tmpSolverBodyPool[i].m_originalBody;
+		m_bodyBundle[i] = body && !body->isStaticOrKinematicObject() ? -1 : sharedBody;
+	}
+	m_bundleRows.resizeNoInitialize(0);
+	m_conflictRows.resizeNoInitialize(0);
+	m_nextLaneBatch.resizeNoInitialize(batches.m_batches.size());
+
+	// The batches of a phase are spread over the W lanes, longest first onto the lane with the fewest rows, and a
+	// bundle takes the next row of every lane. A batch stays in one lane, so the lanes of a bundle always come from
+	// different batches. The batching only keeps bodies with a linear inverse mass in x apart, a row whose moving body
+	// is already in an earlier lane of the bundle waits for the conflict bundles at the end instead
+	int numBundles = 0;
+	for (int iPhase = 0; iPhase < batches.m_phases.size(); ++iPhase)
+	{
+		const Range& phase = batches.m_phases[batches.m_phaseOrder[iPhase]];
+		int laneRows[W];
+		int laneBatch[W];
+		int laneLast[W];
+		int laneNext[W];
+		for (int l = 0; l < W; ++l)
+		{
+			laneRows[l] = 0;
+			laneBatch[l] = -1;
+			laneLast[l] = -1;
+		}
+		for (int iBatch = phase.begin; iBatch < phase.end; ++iBatch)
+		{
+			const int numRows = batches.m_batches[iBatch].end - batches.m_batches[iBatch].begin;
+			if (numRows == 0)
+			{
+				continue;
+			}
+			int lane = 0;
+			for (int l = 1; l < W; ++l)
+			{
+				lane = laneRows[l] < laneRows[lane] ? l : lane;
+			}
+			m_nextLaneBatch[iBatch] = -1;
+			if (laneLast[lane] < 0)
+			{
+				laneBatch[lane] = iBatch;
+			}
+			else
+			{
+				m_nextLaneBatch[laneLast[lane]] = iBatch;
+			}
+			laneLast[lane] = iBatch;
+			laneRows[lane] += numRows;
+		}
+		int longest = 0;
+		for (int l = 0; l < W; ++l)
+		{
+			longest = btMax(longest, laneRows[l]);
+			laneNext[l] = laneBatch[l] >= 0 ? batches.m_batches[laneBatch[l]].begin : 0;
+		}
+
+		for (int j = 0; j < longest; ++j, ++numBundles)
+		{
+			for (int l = 0; l < W; ++l)
+			{
+				if (laneBatch[l] < 0)
+				{
+					m_bundleRows.push_back(-1);
+					continue;
+				}
+				int iRow = batches.m_constraintIndices[laneNext[l]++];
+				if (laneNext[l] == batches.m_batches[laneBatch[l]].end)
+				{
+					laneBatch[l] = m_nextLaneBatch[laneBatch[l]];
+					laneNext[l] = laneBatch[l] >= 0 ? batches.m_batches[laneBatch[l]].begin : 0;
+				}
+
+				const int bodyA = pool[iRow].m_solverBodyIdA;
+				const int bodyB = pool[iRow].m_solverBodyIdB;
+				if (m_bodyBundle[bodyA] == numBundles || m_bodyBundle[bodyB] == numBundles)
+				{
+					m_conflictRows.push_back(iRow);
+					iRow = -1;
+				}
+				else
+				{
+					m_bodyBundle[bodyA] = m_bodyBundle[bodyA] == sharedBody ? sharedBody : numBundles;
+					m_bodyBundle[bodyB] = m_bodyBundle[bodyB] == sharedBody ? sharedBody : numBundles;
+				}
+				m_bundleRows.push_back(iRow);
+			}
+		}
+	}
+	// one conflict row per bundle, in the order they were taken out
+	for (int i = 0; i < m_conflictRows.size(); ++i, ++numBundles)
+	{
+		m_bundleRows.push_back(m_conflictRows[i]);
+		for (int l = 1; l < W; ++l)
+		{
+			m_bundleRows.push_back(-1);
+		}
+	}
+
+	btWideRows& rows = m_contactRows;
+	rows.m_numBundles = numBundles;
+	rows.m_numRows = pool.size();
+	rows.m_fields.resizeNoInitialize(numBundles * WIDE_NUM_FIELDS * W);
+	rows.m_indices.resizeNoInitialize(numBundles * WIDE_NUM_INDICES * W);
+	m_contactImpulseSlots.resizeNoInitialize(pool.size());
+
+	const int noContactSlots[W] = {0};
+	const int prefetchBundles = 2;
+	for (int bundle = 0; bundle < numBundles; ++bundle)
+	{
+		btScalar* f = &rows.m_fields[bundle * WIDE_NUM_FIELDS * W];
+		int* n = &rows.m_indices[bundle * WIDE_NUM_INDICES * W];
+		if (bundle + prefetchBundles < numBundles)
+		{
+			for (int l = 0; l < W; ++l)
+			{
+				const int iRow = m_bundleRows[(bundle + prefetchBundles) * W + l];
+				if (iRow >= 0)
+				{
+					btWidePrefetchRow(pool[iRow]);
+				}
+			}
+		}
+		for (int l = 0; l < W; ++l)
+		{
+			const int iRow = m_bundleRows[bundle * W + l];
+			if (iRow >= 0)
+			{
+				m_contactImpulseSlots[iRow] = (bundle * WIDE_NUM_FIELDS + WIDE_APPLIED_IMPULSE) * W + l;
+			}
+		}
+		setupWideBundle(f, n, pool, &m_bundleRows[bundle * W], noContactSlots);
+	}
+}
+
+void btSequentialImpulseConstraintSolverWide::setupWideFrictionRows()
+{
+	BT_PROFILE("setupWideFrictionRows");
+	const int W = WIDE_WIDTH;
+	const btConstraintArray& pool = m_tmpSolverContactFrictionConstraintPool;
+	const int numContacts = m_tmpSolverContactConstraintPool.size();
+
+	// friction rows of each contact, in pool order
+	m_frictionRowStart.resizeNoInitialize(numContacts + 1);
+	for (int i = 0; i <= numContacts; ++i)
+	{
+		m_frictionRowStart[i] = 0;
+	}
+	bool inContactOrder = true;
+	for (int i = 0; i < pool.size(); ++i)
+	{
+		m_frictionRowStart[pool[i].m_frictionIndex + 1]++;
+		inContactOrder &= i == 0 || pool[i - 1].m_frictionIndex <= pool[i].m_frictionIndex;
+	}
+	int frictionPerContact = 0;
+	for (int i = 0; i < numContacts; ++i)
+	{
+		frictionPerContact = btMax(frictionPerContact, m_frictionRowStart[i + 1]);
+		m_frictionRowStart[i + 1] += m_frictionRowStart[i];
+	}
+	m_frictionRowsByContact.resizeNoInitialize(pool.size());
+	if (inContactOrder)
+	{
+		// the usual case, convertContact adds the friction rows right after their contact
+		for (int i = 0; i < pool.size(); ++i)
+		{
+			m_frictionRowsByContact[i] = i;
+		}
+	}
+	else
+	{
+		for (int i = 0; i < pool.size(); ++i)
+		{
+			m_frictionRowsByContact[m_frictionRowStart[pool[i].m_frictionIndex]++] = i;
+		}
+		// filling moved every start to the end of its contact, shift them back
+		for (int i = numContacts; i > 0; --i)
+		{
+			m_frictionRowStart[i] = m_frictionRowStart[i - 1];
+		}
+		m_frictionRowStart[0] = 0;
+	}
+
+	// friction bundle k of a contact bundle holds the k-th friction row of each lane's contact, so a friction row
+	// sits in the same lane as its contact and the bundles inherit the contact batching
+	const btWideRows& contactRows = m_contactRows;
+	btWideRows& rows = m_frictionRows;
+	const int numBundles = contactRows.m_numBundles * frictionPerContact;
+	rows.m_numBundles = numBundles;
+	rows.m_numRows = pool.size();
+	rows.m_fields.resizeNoInitialize(numBundles * WIDE_NUM_FIELDS * W);
+	rows.m_indices.resizeNoInitialize(numBundles * WIDE_NUM_INDICES * W);
+	m_frictionImpulseSlots.resizeNoInitialize(pool.size());
+
+	const int prefetchBundles = 2;
+	int bundle = 0;
+	for (int b = 0; b < contactRows.m_numBundles; ++b)
+	{
+		const int* contactLanes = &contactRows.m_indices[(b * WIDE_NUM_INDICES + WIDE_ROW) * W];
+		if (b + prefetchBundles < contactRows.m_numBundles)
+		{
+			const int* aheadLanes = &contactRows.m_indices[((b + prefetchBundles) * WIDE_NUM_INDICES + WIDE_ROW) * W];
+			for (int l = 0; l < W; ++l)
+			{
+				const int iContact = aheadLanes[l];
+				for (int i = iContact >= 0 ? m_frictionRowStart[iContact] : 0; iContact >= 0 && i < m_frictionRowStart[iContact + 1]; ++i)
+				{
+					btWidePrefetchRow(pool[m_frictionRowsByContact[i]]);
+				}
+			}
+		}
+		for (int k = 0; k < frictionPerContact; ++k, ++bundle)
+		{
+			btScalar* f = &rows.m_fields[bundle * WIDE_NUM_FIELDS * W];
+			int* n = &rows.m_indices[bundle * WIDE_NUM_INDICES * W];
+			int laneRows[W];
+			int contactSlots[W];
+			for (int l = 0; l < W; ++l)
+			{
+				const int iContact = contactLanes[l];
+				laneRows[l] = -1;
+				contactSlots[l] = 0;
+				if (iContact >= 0 && m_frictionRowStart[iContact] + k < m_frictionRowStart[iContact + 1])
+				{
+					laneRows[l] = m_frictionRowsByContact[m_frictionRowStart[iContact] + k];
+					contactSlots[l] = m_contactImpulseSlots[iContact];
+					m_frictionImpulseSlots[laneRows[l]] = (bundle * WIDE_NUM_FIELDS + WIDE_APPLIED_IMPULSE) * W + l;
+				}
+			}
+			setupWideBundle(f, n, pool, laneRows, contactSlots);
+		}
+	}
+}
+
+void btSequentialImpulseConstraintSolverWide::writeBackWideImpulses(const btWideRows& rows, const btAlignedObjectArray<int>& slots, btConstraintArray& pool)
+{
+	// every row of the pool sits in some lane, go in pool order so the writes stream
+	for (int iRow = 0; iRow < pool.size(); ++iRow)
+	{
+		pool[iRow].m_appliedImpulse = rows.m_fields[slots[iRow]];
+	}
+}
+
+btScalar btSequentialImpulseConstraintSolverWide::solveWideRows(btWideRows& rows, const btScalar* contactFields)
+{
+	if (rows.m_numBundles == 0)
+	{
+		return btScalar(0);
+	}
+	btScalar* bodies = m_bodiesPacked ? &m_bodyVelocities[0] : m_tmpSolverBodyPool[0].m_deltaLinearVelocity.m_floats;
+	const int angularOffset = m_bodiesPacked ? int(WIDE_BODY_ANGULAR) : int(m_tmpSolverBodyPool[0].m_deltaAngularVelocity.m_floats - bodies);
+	btScalar* fields = &rows.m_fields[0];
+	const int* indices = &rows.m_indices[0];
+#ifdef BT_WIDE_SSE
+	if (m_wideKernel == WIDE_KERNEL_AVX2)
+	{
+		return btSolveWideBundlesAvx2(fields, indices, rows.m_numBundles, bodies, angularOffset, contactFields);
+	}
+	if (m_wideKernel == WIDE_KERNEL_SSE2)
+	{
+		return btSolveWideBundlesSse(fields, indices, rows.m_numBundles, bodies, angularOffset, contactFields);
+	}
+#endif
+	return btSolveWideBundlesScalar(fields, indices, rows.m_numBundles, bodies, angularOffset, contactFields);
+}
+
+void btSequentialImpulseConstraintSolverWide::packBodyVelocities()
+{
+	for (int i = 0; i < m_tmpSolverBodyPool.size(); ++i)
+	{
+		const btSolverBody& body = m_tmpSolverBodyPool[i];
+		btScalar* v = &m_bodyVelocities[i * WIDE_BODY_STRIDE];
+		for (int k = 0; k < 3; ++k)
+		{
+			v[k] = body.m_deltaLinearVelocity[k];
+			v[WIDE_BODY_ANGULAR + k] = body.m_deltaAngularVelocity[k];
+		}
+		v[3] = btScalar(0);
+		v[WIDE_BODY_ANGULAR + 3] = btScalar(0);
+	}
+}
+
+void btSequentialImpulseConstraintSolverWide::unpackBodyVelocities()
+{
+	for (int i = 0; i < m_tmpSolverBodyPool.size(); ++i)
+	{
+		btSolverBody& body = m_tmpSolverBodyPool[i];
+		const btScalar* v = &m_bodyVelocities[i * WIDE_BODY_STRIDE];
+		body.m_deltaLinearVelocity.setValue(v[0], v[1], v[2]);
+		body.m_deltaAngularVelocity.setValue(v[WIDE_BODY_ANGULAR], v[WIDE_BODY_ANGULAR + 1], v[WIDE_BODY_ANGULAR + 2]);
+	}
+}
+
+btScalar btSequentialImpulseConstraintSolverWide::solveGroupCacheFriendlySetup(btCollisionObject** bodies, int numBodies, btPersistentManifold** manifoldPtr, int numManifolds, btTypedConstraint** constraints, int numConstraints, const btContactSolverInfo& infoGlobal, btIDebugDraw* debugDrawer)
+{
+	btScalar val = btSequentialImpulseConstraintSolver::solveGroupCacheFriendlySetup(bodies, numBodies, manifoldPtr, numManifolds, constraints, numConstraints, infoGlobal, debugDrawer);
+
+	m_useWideRows = !(infoGlobal.m_solverMode & (SOLVER_RANDMIZE_ORDER | SOLVER_INTERLEAVE_CONTACT_AND_FRICTION_CONSTRAINTS)) &&
+					m_tmpSolverContactConstraintPool.size() >= m_minBatchedRows;
+	if (m_useWideRows)
+	{
+		BT_PROFILE("setupBatchedWideConstraints");
+		// min batch size 1: we want as many independent batches per phase as the grid gives us, never merged
+		const int maxBatchSize = 1 << 30;
+		m_bodiesPacked = m_packBodyVelocities;
+		if (m_bodiesPacked)
+		{
+			m_bodyVelocities.resizeNoInitialize(m_tmpSolverBodyPool.size() * WIDE_BODY_STRIDE);
+		}
+		m_batchedContactConstraints.setup(&m_tmpSolverContactConstraintPool, m_tmpSolverBodyPool, s_batchingMethod, 1, maxBatchSize, &m_scratchMemory);
+		setupWideContactRows(m_batchedContactConstraints);
+		setupWideFrictionRows();
+	}
+	return val;
+}
+
+btScalar btSequentialImpulseConstraintSolverWide::solveSingleIteration(int iteration, btCollisionObject** bodies, int numBodies, btPersistentManifold** manifoldPtr, int numManifolds, btTypedConstraint** constraints, int numConstraints, const btContactSolverInfo& infoGlobal, btIDebugDraw* debugDrawer)
+{
+	if (!m_useWideRows)
+	{
+		return btSequentialImpulseConstraintSolver::solveSingleIteration(iteration, bodies, numBodies, manifoldPtr, numManifolds, constraints, numConstraints, infoGlobal, debugDrawer);
+	}
+
+	BT_PROFILE("solveSingleIterationWide");
+	btScalar leastSquaresResidual = 0.f;
+
+	// the rows solved one at a time work on the btSolverBody pool
+	const bool syncJoints = m_bodiesPacked && (m_tmpSolverNonContactConstraintPool.size() || (numConstraints && iteration < infoGlobal.m_numIterations));
+	if (syncJoints)
+	{
+		unpackBodyVelocities();
+	}
+
+	///solve all joint constraints
+	for (int j = 0; j < m_tmpSolverNonContactConstraintPool.size(); j++)
+	{
+		btSolverConstraint& constraint = m_tmpSolverNonContactConstraintPool[m_orderNonContactConstraintPool[j]];
+		if (iteration < constraint.m_overrideNumSolverIterations)
+		{
+			btScalar residual = resolveSingleConstraintRowGeneric(m_tmpSolverBodyPool[constraint.m_solverBodyIdA], m_tmpSolverBodyPool[constraint.m_solverBodyIdB], constraint);
+			leastSquaresResidual = btMax(leastSquaresResidual, residual * residual);
+		}
+	}
+
+	if (iteration < infoGlobal.m_numIterations)
+	{
+		for (int j = 0; j < numConstraints; j++)
+		{
+			if (constraints[j]->isEnabled())
+			{
+				int bodyAid = getOrInitSolverBody(constraints[j]->getRigidBodyA(), infoGlobal.m_timeStep);
+				int bodyBid = getOrInitSolverBody(constraints[j]->getRigidBodyB(), infoGlobal.m_timeStep);
+				btSolverBody& bodyA = m_tmpSolverBodyPool[bodyAid];
+				btSolverBody& bodyB = m_tmpSolverBodyPool[bodyBid];
+				constraints[j]->solveConstraintObsolete(bodyA, bodyB, infoGlobal.m_timeStep);
+			}
+		}
+	}
+	if (syncJoints)
+	{
+		packBodyVelocities();
+	}
+
+	if (iteration < infoGlobal.m_numIterations)
+	{
+		///solve all contact constraints, then all friction constraints
+		leastSquaresResidual = btMax(leastSquaresResidual, solveWideRows(m_contactRows, NULL));
+		if (m_frictionRows.m_numBundles > 0)
+		{
+			leastSquaresResidual = btMax(leastSquaresResidual, solveWideRows(m_frictionRows, &m_contactRows.m_fields[0]));
+		}
+
+		int numRollingFrictionPoolConstraints = m_tmpSolverContactRollingFrictionConstraintPool.size();
+		if (numRollingFrictionPoolConstraints)
+		{
+			// rolling friction reads the contact impulses from the pool
+			writeBackWideImpulses(m_contactRows, m_contactImpulseSlots, m_tmpSolverContactConstraintPool);
+			if (m_bodiesPacked)
+			{
+				unpackBodyVelocities();
+			}
+		}
+		for (int j = 0; j < numRollingFrictionPoolConstraints; j++)
+		{
+			btSolverConstraint& rollingFrictionConstraint = m_tmpSolverContactRollingFrictionConstraintPool[j];
+			btScalar totalImpulse = m_tmpSolverContactConstraintPool[rollingFrictionConstraint.m_frictionIndex].m_appliedImpulse;
+			if (totalImpulse > btScalar(0))
+			{
+				btScalar rollingFrictionMagnitude = rollingFrictionConstraint.m_friction * totalImpulse;
+				if (rollingFrictionMagnitude > rollingFrictionConstraint.m_friction)
+					rollingFrictionMagnitude = rollingFrictionConstraint.m_friction;
+
+				rollingFrictionConstraint.m_lowerLimit = -rollingFrictionMagnitude;
+				rollingFrictionConstraint.m_upperLimit = rollingFrictionMagnitude;
+
+				btScalar residual = resolveSingleConstraintRowGeneric(m_tmpSolverBodyPool[rollingFrictionConstraint.m_solverBodyIdA], m_tmpSolverBodyPool[rollingFrictionConstraint.m_solverBodyIdB], rollingFrictionConstraint);
+				leastSquaresResidual = btMax(leastSquaresResidual, residual * residual);
+			}
+		}
+		if (numRollingFrictionPoolConstraints && m_bodiesPacked)
+		{
+			packBodyVelocities();
+		}
+	}
+	return leastSquaresResidual;
+}
+
+btScalar btSequentialImpulseConstraintSolverWide::solveGroupCacheFriendlyIterations(btCollisionObject** bodies, int numBodies, btPersistentManifold** manifoldPtr, int numManifolds, btTypedConstraint** constraints, int numConstraints, const btContactSolverInfo& infoGlobal, btIDebugDraw* debugDrawer)
+{
+	if (m_useWideRows && m_bodiesPacked)
+	{
+		packBodyVelocities();
+	}
+	btSequentialImpulseConstraintSolver::solveGroupCacheFriendlyIterations(bodies, numBodies, manifoldPtr, numManifolds, constraints, numConstraints, infoGlobal, debugDrawer);
+	if (m_useWideRows)
+	{
+		if (m_bodiesPacked)
+		{
+			unpackBodyVelocities();
+		}
+		// the finish step warmstarts the manifolds from the pools
+		writeBackWideImpulses(m_contactRows, m_contactImpulseSlots, m_tmpSolverContactConstraintPool);
+		writeBackWideImpulses(m_frictionRows, m_frictionImpulseSlots, m_tmpSolverContactFrictionConstraintPool);
+	}
+	return 0.f;
+}
@@ -0,0 +1,229 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2006 Erwin Coumans  https://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_SEQUENTIAL_IMPULSE_CONSTRAINT_SOLVER_WIDE_H
+#define BT_SEQUENTIAL_IMPULSE_CONSTRAINT_SOLVER_WIDE_H
+
+#include "btSequentialImpulseConstraintSolver.h"
+#include "btBatchedConstraints.h"
+
+///
+/// btSequentialImpulseConstraintSolverWide
+///
+///  A variant of the sequential impulse constraint solver that solves contact and friction rows several at a time.
+///  The contact rows are grouped with btBatchedConstraints and row j of up to 8 different batches of a phase is packed
+///  into one bundle (structure-of-arrays) and solved together: with AVX2 when the CPU has it, as two SSE2 halves
+///  otherwise, or plain scalar code without SSE. Friction rows reuse that layout: each one sits in the same lane as
+///  its contact.
+///
+///  btBatchedConstraints only keeps batches apart on bodies with a linear inverse mass in x, so a bundle can still
+///  end up with two rows on the same moving body (e.g. one with a locked x axis). Those rows are taken out of the
+///  bundle and solved one per bundle after all the phases, so a lane never overwrites another lane's velocities.
+///
+///  The width is fixed and every lane goes through the same sequence of adds, multiplies and divides (no FMA, no
+///  horizontal sums), so the bundles and the result are the same on every machine, whichever kernel runs them. The rows are visited in batch
+///  order though, which is a different order than btSequentialImpulseConstraintSolver uses, so everybody that has to
+///  agree on the simulation needs this solver.
+///
+///  With m_packBodyVelocities the iterations don't touch the btSolverBody pool at all: the delta velocities are copied
+///  into a packed array (8 scalars per body) and the rows only carry what the iterations read, with inverse masses folded
+///  into the linear components. Both arrays are 64-byte aligned and a bundle is a whole number of cache lines.
+///
+///  Joints and rolling friction are still solved one row at a time. SOLVER_RANDMIZE_ORDER,
+///  SOLVER_INTERLEAVE_CONTACT_AND_FRICTION_CONSTRAINTS and islands with fewer than m_minBatchedRows contact rows use
+///  the normal row-by-row solver for the whole island.
+///
+ATTRIBUTE_ALIGNED16(class)
+btSequentialImpulseConstraintSolverWide : public btSequentialImpulseConstraintSolver
+{
+public:
+	enum WideRowField
+	{
+		WIDE_NORMAL1_X,
+		WIDE_NORMAL1_Y,
+		WIDE_NORMAL1_Z,
+		WIDE_RELPOS1_CROSS_NORMAL_X,
+		WIDE_RELPOS1_CROSS_NORMAL_Y,
+		WIDE_RELPOS1_CROSS_NORMAL_Z,
+		WIDE_NORMAL2_X,
+		WIDE_NORMAL2_Y,
+		WIDE_NORMAL2_Z,
+		WIDE_RELPOS2_CROSS_NORMAL_X,
+		WIDE_RELPOS2_CROSS_NORMAL_Y,
+		WIDE_RELPOS2_CROSS_NORMAL_Z,
+		WIDE_ANGULAR_COMPONENT_A_X,
+		WIDE_ANGULAR_COMPONENT_A_Y,
+		WIDE_ANGULAR_COMPONENT_A_Z,
+		WIDE_ANGULAR_COMPONENT_B_X,
+		WIDE_ANGULAR_COMPONENT_B_Y,
+		WIDE_ANGULAR_COMPONENT_B_Z,
+		WIDE_LINEAR_COMPONENT_A_X,  // contactNormal1 * invMassA
+		WIDE_LINEAR_COMPONENT_A_Y,
+		WIDE_LINEAR_COMPONENT_A_Z,
+		WIDE_LINEAR_COMPONENT_B_X,  // contactNormal2 * invMassB
+		WIDE_LINEAR_COMPONENT_B_Y,
+		WIDE_LINEAR_COMPONENT_B_Z,
+		WIDE_RHS,
+		WIDE_CFM,
+		WIDE_JAC_DIAG_AB_INV,
+		WIDE_LOWER_LIMIT,
+		WIDE_UPPER_LIMIT,
+		WIDE_FRICTION,
+		WIDE_APPLIED_IMPULSE,
+		WIDE_UNUSED,  // pads a bundle to a multiple of 64 bytes
+		WIDE_NUM_FIELDS
+	};
+	enum WideRowIndex
+	{
+		WIDE_BODY_A,   // offset of the body's delta linear velocity, in btScalars from the start of the body velocities
+		WIDE_BODY_B,
+		WIDE_ROW,      // index into the constraint pool, -1 for an unused lane
+		WIDE_CONTACT,  // friction rows: index of the contact's applied impulse in the contact rows
+		WIDE_NUM_INDICES
+	};
+
+	// packed body velocities: delta linear velocity at 0, delta angular velocity at WIDE_BODY_ANGULAR
+	enum
+	{
+		WIDE_BODY_ANGULAR = 4,
+		WIDE_BODY_STRIDE = 8
+	};
+
+	// rows per bundle, the same everywhere so the bundles (and the result) don't depend on the CPU
+	enum
+	{
+		WIDE_WIDTH = 8
+	};
+
+	// what runs the bundles: one AVX2 register, two SSE2 registers or scalar code, all with the same result
+	enum WideKernel
+	{
+		WIDE_KERNEL_SCALAR,
+		WIDE_KERNEL_SSE2,
+		WIDE_KERNEL_AVX2
+	};
+
+	// 64-byte aligned storage that is rebuilt every solve, resize doesn't keep the contents
+	template <typename T>
+	struct btWideArray
+	{
+		T* m_data;
+		int m_size;
+		int m_capacity;
+
+		btWideArray() : m_data(0), m_size(0), m_capacity(0) {}
+		~btWideArray()
+		{
+			btAlignedFree(m_data);
+		}
+		void resizeNoInitialize(int size)
+		{
+			if (size > m_capacity)
+			{
+				btAlignedFree(m_data);
+				m_capacity = size + size / 4;
+				m_data = (T*)btAlignedAlloc(sizeof(T) * m_capacity, 64);
+			}
+			m_size = size;
+		}
+		int size() const { return m_size; }
+		T& operator[](int i) { return m_data[i]; }
+		const T& operator[](int i) const { return m_data[i]; }
+
+	private:
+		btWideArray(const btWideArray&);
+		btWideArray& operator=(const btWideArray&);
+	};
+
+	// Bundles of rows, bundle b keeps field f of lane l at m_fields[(b * WIDE_NUM_FIELDS + f) * width + l]
+	struct btWideRows
+	{
+		btWideArray<btScalar> m_fields;
+		btWideArray<int> m_indices;
+		int m_numBundles;
+		int m_numRows;
+
+		btWideRows() : m_numBundles(0), m_numRows(0) {}
+	};
+
+protected:
+	btBatchedConstraints m_batchedContactConstraints;
+	btAlignedObjectArray<char> m_scratchMemory;
+	btWideRows m_contactRows;
+	btWideRows m_frictionRows;
+	// where each contact and friction row's applied impulse lives in m_contactRows.m_fields / m_frictionRows.m_fields
+	btAlignedObjectArray<int> m_contactImpulseSlots;
+	btAlignedObjectArray<int> m_frictionImpulseSlots;
+	btWideArray<btScalar> m_bodyVelocities;
+	// contact row of every lane while the bundles are laid out, then the rows that clashed with an earlier lane
+	btAlignedObjectArray<int> m_bundleRows;
+	btAlignedObjectArray<int> m_conflictRows;
+	// last bundle each moving solver body was put in
+	btAlignedObjectArray<int> m_bodyBundle;
+	// batch that follows each batch in its lane
+	btAlignedObjectArray<int> m_nextLaneBatch;
+	int m_wideKernel;
+	bool m_useWideRows;
+	bool m_bodiesPacked;
+
+	// friction rows of contact c are m_frictionRowsByContact[m_frictionRowStart[c] .. m_frictionRowStart[c + 1])
+	btAlignedObjectArray<int> m_frictionRowStart;
+	btAlignedObjectArray<int> m_frictionRowsByContact;
+
+	// what unused lanes are filled from
+	btSolverConstraint m_unusedRow;
+
+	void setupWideBundle(btScalar * fields, int* indices, const btConstraintArray& pool, const int* rows, const int* contactSlots);
+	void setupWideContactRows(const btBatchedConstraints& batches);
+	void setupWideFrictionRows();
+	void writeBackWideImpulses(const btWideRows& rows, const btAlignedObjectArray<int>& slots, btConstraintArray& pool);
+	btScalar solveWideRows(btWideRows & rows, const btScalar* contactFields);
+	void packBodyVelocities();
+	void unpackBodyVelocities();
+
+	virtual btScalar solveGroupCacheFriendlySetup(btCollisionObject * *bodies, int numBodies, btPersistentManifold** manifoldPtr, int numManifolds, btTypedConstraint** constraints, int numConstraints, const btContactSolverInfo& infoGlobal, btIDebugDraw* debugDrawer) BT_OVERRIDE;
+	virtual btScalar solveGroupCacheFriendlyIterations(btCollisionObject * *bodies, int numBodies, btPersistentManifold** manifoldPtr, int numManifolds, btTypedConstraint** constraints, int numConstraints, const btContactSolverInfo& infoGlobal, btIDebugDraw* debugDrawer) BT_OVERRIDE;
+	virtual btScalar solveSingleIteration(int iteration, btCollisionObject** bodies, int numBodies, btPersistentManifold** manifoldPtr, int numManifolds, btTypedConstraint** constraints, int numConstraints, const btContactSolverInfo& infoGlobal, btIDebugDraw* debugDrawer) BT_OVERRIDE;
+
+public:
+	BT_DECLARE_ALIGNED_ALLOCATOR();
+
+	btSequentialImpulseConstraintSolverWide();
+	virtual ~btSequentialImpulseConstraintSolverWide();
+
+	static btBatchedConstraints::BatchingMethod s_batchingMethod;
+
+	// islands with fewer contact rows than this are solved row by row
+	int m_minBatchedRows;
+
+	// solve against a packed copy of the body velocities instead of the btSolverBody pool, same result either way
+	bool m_packBodyVelocities;
+
+	int getSimdWidth() const
+	{
+		return WIDE_WIDTH;
+	}
+
+	// the best kernel this CPU can run, the constructor picks it
+	static int getMaxWideKernel();
+	// for comparing the kernels, clamped to what the CPU can run
+	void setWideKernel(int kernel);
+	int getWideKernel() const
+	{
+		return m_wideKernel;
+	}
+};
+
+#endif  //BT_SEQUENTIAL_IMPULSE_CONSTRAINT_SOLVER_WIDE_H
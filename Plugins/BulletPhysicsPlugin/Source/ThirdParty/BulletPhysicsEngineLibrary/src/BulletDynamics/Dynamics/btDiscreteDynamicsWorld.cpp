@@ -22,6 +22,7 @@ subject to the following restrictions:
 #include "BulletCollision/CollisionShapes/btCollisionShape.h"
 #include "BulletCollision/CollisionDispatch/btSimulationIslandManager.h"
 #include "LinearMath/btTransformUtil.h"
+#include "LinearMath/btAabbUtil2.h"
 #include "LinearMath/btQuickprof.h"
 
 //rigidbody & constraints
@@ -87,6 +88,7 @@ struct InplaceSolverIslandCallback : public btSimulationIslandManager::IslandCal
 	btAlignedObjectArray<btCollisionObject*> m_bodies;
 	btAlignedObjectArray<btPersistentManifold*> m_manifolds;
 	btAlignedObjectArray<btTypedConstraint*> m_constraints;
+	btAlignedObjectArray<btSolverAnalyticsData> m_islandAnalyticsData;
 
 	InplaceSolverIslandCallback(
 		btConstraintSolver* solver,
@@ -118,6 +120,17 @@ struct InplaceSolverIslandCallback : public btSimulationIslandManager::IslandCal
 		m_bodies.resize(0);
 		m_manifolds.resize(0);
 		m_constraints.resize(0);
+		m_islandAnalyticsData.resize(0);
+	}
+
+	void reportAnalytics(int islandId)
+	{
+		if ((m_solverInfo->m_reportSolverAnalytics & 1) && m_solver->getSolverType() == BT_SEQUENTIAL_IMPULSE_SOLVER)
+		{
+			btSequentialImpulseConstraintSolver* solver = static_cast<btSequentialImpulseConstraintSolver*>(m_solver);
+			solver->m_analyticsData.m_islandId = islandId;
+			m_islandAnalyticsData.push_back(solver->m_analyticsData);
+		}
 	}
 
 	virtual void processIsland(btCollisionObject** bodies, int numBodies, btPersistentManifold** manifolds, int numManifolds, int islandId)
@@ -126,6 +139,7 @@ struct InplaceSolverIslandCallback : public btSimulationIslandManager::IslandCal
 		{
 			///we don't split islands, so all constraints/contact manifolds/bodies are passed into the solver regardless the island id
 			m_solver->solveGroup(bodies, numBodies, manifolds, numManifolds, &m_sortedConstraints[0], m_numConstraints, *m_solverInfo, m_debugDrawer, m_dispatcher);
+			reportAnalytics(islandId);
 		}
 		else
 		{
@@ -155,6 +169,7 @@ struct InplaceSolverIslandCallback : public btSimulationIslandManager::IslandCal
 			if (m_solverInfo->m_minimumSolverBatchSize <= 1)
 			{
 				m_solver->solveGroup(bodies, numBodies, manifolds, numManifolds, startConstraint, numCurConstraints, *m_solverInfo, m_debugDrawer, m_dispatcher);
+				reportAnalytics(islandId);
 			}
 			else
 			{
@@ -182,6 +197,11 @@ struct InplaceSolverIslandCallback : public btSimulationIslandManager::IslandCal
 		btTypedConstraint** constraints = m_constraints.size() ? &m_constraints[0] : 0;
 
 		m_solver->solveGroup(bodies, m_bodies.size(), manifold, m_manifolds.size(), constraints, m_constraints.size(), *m_solverInfo, m_debugDrawer, m_dispatcher);
+		if (bodies || manifold || constraints)
+		{
+			// several islands batched together
+			reportAnalytics(-1);
+		}
 		m_bodies.resize(0);
 		m_manifolds.resize(0);
 		m_constraints.resize(0);
@@ -199,7 +219,8 @@ btDiscreteDynamicsWorld::btDiscreteDynamicsWorld(btDispatcher* dispatcher, btBro
 	  m_synchronizeAllMotionStates(false),
 	  m_applySpeculativeContactRestitution(false),
 	  m_profileTimings(0),
-	  m_latencyMotionStateInterpolation(true)
+	  m_latencyMotionStateInterpolation(true),
+	  m_projectileHitCallback(0)
 
 {
 	if (!m_constraintSolver)
@@ -854,6 +875,10 @@ void btDiscreteDynamicsWorld::createPredictiveContactsInternal(btRigidBody** bod
 		btRigidBody* body = bodies[i];
 		body->setHitFraction(1.f);
 
+		//projectiles are swept together in integrateProjectiles
+		if (body->getFlags() & BT_ENABLE_PROJECTILE_CCD)
+			continue;
+
 		if (body->isActive() && (!body->isStaticOrKinematicObject()))
 		{
 			body->predictIntegratedTransform(timeStep, predictedTrans);
@@ -956,6 +981,10 @@ void btDiscreteDynamicsWorld::integrateTransformsInternal(btRigidBody** bodies,
 		btRigidBody* body = bodies[i];
 		body->setHitFraction(1.f);
 
+		//projectiles are swept together in integrateProjectiles
+		if (body->getFlags() & BT_ENABLE_PROJECTILE_CCD)
+			continue;
+
 		if (body->isActive() && (!body->isStaticOrKinematicObject()))
 		{
 			body->predictIntegratedTransform(timeStep, predictedTrans);
@@ -1044,6 +1073,150 @@ void btDiscreteDynamicsWorld::integrateTransformsInternal(btRigidBody** bodies,
 	}
 }
 
+struct btProjectileCandidateCollector : public btBroadphaseAabbBatchCallback
+{
+	btAlignedObjectArray<btProjectileCandidate>& m_candidates;
+	btProjectileCandidateCollector(btAlignedObjectArray<btProjectileCandidate>& candidates) : m_candidates(candidates) {}
+	virtual void process(int aabbIndex, const btBroadphaseProxy* proxy)
+	{
+		btProjectileCandidate& candidate = m_candidates.expandNonInitializing();
+		candidate.m_projectile = aabbIndex;
+		candidate.m_objectIndex = ((const btCollisionObject*)proxy->m_clientObject)->getWorldArrayIndex();
+	}
+};
+
+struct btProjectileCandidateSortPredicate
+{
+	bool operator()(const btProjectileCandidate& a, const btProjectileCandidate& b) const
+	{
+		if (a.m_projectile != b.m_projectile)
+			return a.m_projectile < b.m_projectile;
+		return a.m_objectIndex < b.m_objectIndex;
+	}
+};
+
+///Moves the BT_ENABLE_PROJECTILE_CCD bodies. Fast ones sweep a sphere of getCcdSweptSphereRadius() from the current to the
+///predicted transform and stop at the earliest hit, like the CCD in integrateTransformsInternal. The swept boxes of all
+///projectiles go to the broadphase in one aabbTestBatch, so the tree is walked once per step instead of once per projectile.
+///All sweeps see the projectiles at the start of the step, and the candidates are visited by world index, so the result
+///does not depend on the order the broadphase reports them in.
+void btDiscreteDynamicsWorld::integrateProjectiles(btScalar timeStep)
+{
+	m_projectileHits.resize(0);
+	m_projectiles.resize(0);
+	m_projectileTargets.resize(0);
+	m_projectileAabbMins.resize(0);
+	m_projectileAabbMaxs.resize(0);
+
+	btTransform predictedTrans;
+	for (int i = 0; i < m_nonStaticRigidBodies.size(); i++)
+	{
+		btRigidBody* body = m_nonStaticRigidBodies[i];
+		if (!(body->getFlags() & BT_ENABLE_PROJECTILE_CCD))
+			continue;
+		if (!body->isActive() || body->isStaticOrKinematicObject())
+			continue;
+
+		body->predictIntegratedTransform(timeStep, predictedTrans);
+		btScalar squareMotion = (predictedTrans.getOrigin() - body->getWorldTransform().getOrigin()).length2();
+		if (!getDispatchInfo().m_useContinuous || !body->getBroadphaseHandle() || body->getCcdSquareMotionThreshold() == btScalar(0) || squareMotion <= body->getCcdSquareMotionThreshold())
+		{
+			body->proceedToTransform(predictedTrans);
+			continue;
+		}
+
+		//the sweep keeps the start orientation, same as the regular CCD
+		btTransform& target = m_projectileTargets.expandNonInitializing();
+		target = predictedTrans;
+		target.setBasis(body->getWorldTransform().getBasis());
+
+		const btVector3& from = body->getWorldTransform().getOrigin();
+		const btVector3 radius(body->getCcdSweptSphereRadius(), body->getCcdSweptSphereRadius(), body->getCcdSweptSphereRadius());
+		btVector3 aabbMin = from;
+		btVector3 aabbMax = from;
+		aabbMin.setMin(target.getOrigin());
+		aabbMax.setMax(target.getOrigin());
+		m_projectileAabbMins.push_back(aabbMin - radius);
+		m_projectileAabbMaxs.push_back(aabbMax + radius);
+		m_projectiles.push_back(body);
+	}
+
+	if (m_projectiles.size() == 0)
+		return;
+
+	BT_PROFILE("integrateProjectiles");
+	m_projectileCandidates.resize(0);
+	btProjectileCandidateCollector collector(m_projectileCandidates);
+	getBroadphase()->aabbTestBatch(&m_projectileAabbMins[0], &m_projectileAabbMaxs[0], m_projectiles.size(), collector);
+	m_projectileCandidates.quickSort(btProjectileCandidateSortPredicate());
+
+	int c = 0;
+	for (int p = 0; p < m_projectiles.size(); p++)
+	{
+		btRigidBody* body = m_projectiles[p];
+		btClosestNotMeConvexResultCallback sweepResults(body, body->getWorldTransform().getOrigin(), m_projectileTargets[p].getOrigin(), getBroadphase()->getOverlappingPairCache(), getDispatcher());
+		sweepResults.m_allowedPenetration = getDispatchInfo().m_allowedCcdPenetration;
+		sweepResults.m_collisionFilterGroup = body->getBroadphaseHandle()->m_collisionFilterGroup;
+		sweepResults.m_collisionFilterMask = body->getBroadphaseHandle()->m_collisionFilterMask;
+		btSphereShape sphere(body->getCcdSweptSphereRadius());
+		const btVector3 radius(body->getCcdSweptSphereRadius(), body->getCcdSweptSphereRadius(), body->getCcdSweptSphereRadius());
+
+		for (; c < m_projectileCandidates.size() && m_projectileCandidates[c].m_projectile == p; c++)
+		{
+			btCollisionObject* obj = m_collisionObjects[m_projectileCandidates[c].m_objectIndex];
+			btBroadphaseProxy* proxy = obj->getBroadphaseHandle();
+			if (!sweepResults.needsCollision(proxy))
+				continue;
+			//the box test only found the swept box, skip objects the path misses or only reaches behind the closest hit so far
+			btScalar param = sweepResults.m_closestHitFraction;
+			btVector3 normal;
+			if (!btRayAabb(body->getWorldTransform().getOrigin(), m_projectileTargets[p].getOrigin(), proxy->m_aabbMin - radius, proxy->m_aabbMax + radius, param, normal))
+				continue;
+			objectQuerySingle(&sphere, body->getWorldTransform(), m_projectileTargets[p], obj, obj->getCollisionShape(), obj->getWorldTransform(), sweepResults, getDispatchInfo().m_allowedCcdPenetration);
+		}
+
+		body->setHitFraction(1.f);
+		if (sweepResults.hasHit() && sweepResults.m_closestHitFraction < 1.f)
+		{
+			btProjectileHit& hit = m_projectileHits.expandNonInitializing();
+			hit.m_projectile = body;
+			hit.m_hitObject = sweepResults.m_hitCollisionObject;
+			hit.m_hitPointWorld = sweepResults.m_hitPointWorld;
+			hit.m_hitNormalWorld = sweepResults.m_hitNormalWorld;
+			hit.m_hitFraction = sweepResults.m_closestHitFraction;
+		}
+	}
+
+	//move everybody only after all sweeps are done
+	int h = 0;
+	for (int p = 0; p < m_projectiles.size(); p++)
+	{
+		btRigidBody* body = m_projectiles[p];
+		if (h < m_projectileHits.size() && m_projectileHits[h].m_projectile == body)
+		{
+			gNumClampedCcdMotions++;
+			body->setHitFraction(m_projectileHits[h].m_hitFraction);
+			body->predictIntegratedTransform(timeStep * body->getHitFraction(), predictedTrans);
+			body->setHitFraction(0.f);
+			body->proceedToTransform(predictedTrans);
+			h++;
+		}
+		else
+		{
+			body->predictIntegratedTransform(timeStep, predictedTrans);
+			body->proceedToTransform(predictedTrans);
+		}
+	}
+
+	if (m_projectileHitCallback)
+	{
+		for (int i = 0; i < m_projectileHits.size(); i++)
+		{
+			m_projectileHitCallback(this, m_projectileHits[i]);
+		}
+	}
+}
+
 void btDiscreteDynamicsWorld::integrateTransforms(btScalar timeStep)
 {
 	BT_PROFILE("integrateTransforms");
@@ -1051,6 +1224,7 @@ void btDiscreteDynamicsWorld::integrateTransforms(btScalar timeStep)
 	{
 		integrateTransformsInternal(&m_nonStaticRigidBodies[0], m_nonStaticRigidBodies.size(), timeStep);
 	}
+	integrateProjectiles(timeStep);
 
 	///this should probably be switched on by default, but it is not well tested yet
 	if (m_applySpeculativeContactRestitution)
@@ -1363,6 +1537,11 @@ btConstraintSolver* btDiscreteDynamicsWorld::getConstraintSolver()
 	return m_constraintSolver;
 }
 
+void btDiscreteDynamicsWorld::getAnalyticsData(btAlignedObjectArray<btSolverAnalyticsData>& islandAnalyticsData) const
+{
+	islandAnalyticsData = m_solverIslandCallback->m_islandAnalyticsData;
+}
+
 int btDiscreteDynamicsWorld::getNumConstraints() const
 {
 	return int(m_constraints.size());
@@ -27,6 +27,27 @@ class btPersistentManifold;
 class btIDebugDraw;
 
 struct InplaceSolverIslandCallback;
+struct btSolverAnalyticsData;
+class btDynamicsWorld;
+
+///earliest hit of a BT_ENABLE_PROJECTILE_CCD body during a step, the body has already been moved to the hit
+struct btProjectileHit
+{
+	btRigidBody* m_projectile;
+	const btCollisionObject* m_hitObject;
+	btVector3 m_hitPointWorld;
+	btVector3 m_hitNormalWorld;
+	btScalar m_hitFraction;
+};
+
+///a collision object whose proxy overlaps the swept box of a projectile
+struct btProjectileCandidate
+{
+	int m_projectile;
+	int m_objectIndex;  // btCollisionObject::getWorldArrayIndex
+};
+
+typedef void (*btProjectileHitCallback)(btDynamicsWorld* world, const btProjectileHit& hit);
 
 #include "LinearMath/btAlignedObjectArray.h"
 #include "LinearMath/btThreads.h"
@@ -69,10 +90,21 @@ protected:
 	btAlignedObjectArray<btPersistentManifold*> m_predictiveManifolds;
 	btSpinMutex m_predictiveManifoldsMutex;  // used to synchronize threads creating predictive contacts
 
+	btProjectileHitCallback m_projectileHitCallback;
+
+	// scratch for integrateProjectiles, kept between steps
+	btAlignedObjectArray<btRigidBody*> m_projectiles;
+	btAlignedObjectArray<btTransform> m_projectileTargets;
+	btAlignedObjectArray<btVector3> m_projectileAabbMins;
+	btAlignedObjectArray<btVector3> m_projectileAabbMaxs;
+	btAlignedObjectArray<btProjectileCandidate> m_projectileCandidates;
+	btAlignedObjectArray<btProjectileHit> m_projectileHits;
+
 	virtual void predictUnconstraintMotion(btScalar timeStep);
 
 	void integrateTransformsInternal(btRigidBody * *bodies, int numBodies, btScalar timeStep);  // can be called in parallel
 	virtual void integrateTransforms(btScalar timeStep);
+	void integrateProjectiles(btScalar timeStep);
 
 	virtual void calculateSimulationIslands();
 
@@ -160,6 +192,10 @@ public:
 
 	virtual btConstraintSolver* getConstraintSolver();
 
+	///per island solver statistics of the last step, only collected with btContactSolverInfo::m_reportSolverAnalytics & 1
+	///and a btSequentialImpulseConstraintSolver
+	virtual void getAnalyticsData(btAlignedObjectArray<btSolverAnalyticsData> & islandAnalyticsData) const;
+
 	virtual int getNumConstraints() const;
 
 	virtual btTypedConstraint* getConstraint(int index);
@@ -229,6 +265,21 @@ public:
 	{
 		return m_latencyMotionStateInterpolation;
 	}
+
+	///called from integrateTransforms for every BT_ENABLE_PROJECTILE_CCD body that got clamped at a hit
+	void setProjectileHitCallback(btProjectileHitCallback callback)
+	{
+		m_projectileHitCallback = callback;
+	}
+	btProjectileHitCallback getProjectileHitCallback() const
+	{
+		return m_projectileHitCallback;
+	}
+	///hits of the last integrateTransforms, i.e. of the last internal step
+	const btAlignedObjectArray<btProjectileHit>& getProjectileHits() const
+	{
+		return m_projectileHits;
+	}
     
     btAlignedObjectArray<btRigidBody*>& getNonStaticRigidBodies()
     {
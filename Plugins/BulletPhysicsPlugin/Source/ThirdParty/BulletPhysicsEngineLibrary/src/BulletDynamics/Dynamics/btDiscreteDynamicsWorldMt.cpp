@@ -130,6 +130,27 @@ btScalar btConstraintSolverPoolMt::solveGroup(btCollisionObject** bodies,
 	return 0.0f;
 }
 
+btScalar btConstraintSolverPoolMt::solveGroupWithAnalytics(btCollisionObject** bodies,
+														   int numBodies,
+														   btPersistentManifold** manifolds,
+														   int numManifolds,
+														   btTypedConstraint** constraints,
+														   int numConstraints,
+														   const btContactSolverInfo& info,
+														   btIDebugDraw* debugDrawer,
+														   btDispatcher* dispatcher,
+														   btSolverAnalyticsData* analyticsData)
+{
+	ThreadSolver* ts = getAndLockThreadSolver();
+	ts->solver->solveGroup(bodies, numBodies, manifolds, numManifolds, constraints, numConstraints, info, debugDrawer, dispatcher);
+	if (analyticsData && (info.m_reportSolverAnalytics & 1) && ts->solver->getSolverType() == BT_SEQUENTIAL_IMPULSE_SOLVER)
+	{
+		*analyticsData = static_cast<btSequentialImpulseConstraintSolver*>(ts->solver)->m_analyticsData;
+	}
+	ts->mutex.unlock();
+	return 0.0f;
+}
+
 void btConstraintSolverPoolMt::reset()
 {
 	for (int i = 0; i < m_solvers.size(); ++i)
@@ -189,6 +210,11 @@ void btDiscreteDynamicsWorldMt::solveConstraints(btContactSolverInfo& solverInfo
 	m_constraintSolver->allSolved(solverInfo, m_debugDrawer);
 }
 
+void btDiscreteDynamicsWorldMt::getAnalyticsData(btAlignedObjectArray<btSolverAnalyticsData>& islandAnalyticsData) const
+{
+	static_cast<const btSimulationIslandManagerMt*>(m_islandManager)->getAnalyticsData(islandAnalyticsData);
+}
+
 struct UpdaterUnconstrainedMotion : public btIParallelForBody
 {
 	btScalar timeStep;
@@ -249,6 +275,7 @@ void btDiscreteDynamicsWorldMt::integrateTransforms(btScalar timeStep)
 		int grainSize = 50;  // num of iterations per task for task scheduler
 		btParallelFor(0, m_nonStaticRigidBodies.size(), grainSize, update);
 	}
+	integrateProjectiles(timeStep);
 }
 
 int btDiscreteDynamicsWorldMt::stepSimulation(btScalar timeStep, int maxSubSteps, btScalar fixedTimeStep)
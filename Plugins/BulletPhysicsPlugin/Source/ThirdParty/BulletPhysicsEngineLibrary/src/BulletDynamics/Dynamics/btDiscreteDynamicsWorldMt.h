@@ -51,6 +51,19 @@ public:
 								btIDebugDraw* debugDrawer,
 								btDispatcher* dispatcher) BT_OVERRIDE;
 
+	///solveGroup that also copies the analytics of the solver it ran on (if that is a btSequentialImpulseConstraintSolver
+	///and info.m_reportSolverAnalytics & 1) before the solver goes back to the pool
+	btScalar solveGroupWithAnalytics(btCollisionObject** bodies,
+									 int numBodies,
+									 btPersistentManifold** manifolds,
+									 int numManifolds,
+									 btTypedConstraint** constraints,
+									 int numConstraints,
+									 const btContactSolverInfo& info,
+									 btIDebugDraw* debugDrawer,
+									 btDispatcher* dispatcher,
+									 btSolverAnalyticsData* analyticsData);
+
 	virtual void reset() BT_OVERRIDE;
 	virtual btConstraintSolverType getSolverType() const BT_OVERRIDE { return m_solverType; }
 
@@ -126,6 +139,9 @@ public:
 	virtual ~btDiscreteDynamicsWorldMt();
 
 	virtual int stepSimulation(btScalar timeStep, int maxSubSteps, btScalar fixedTimeStep) BT_OVERRIDE;
+
+	///per island statistics of the last step, in island dispatch order (largest island first)
+	virtual void getAnalyticsData(btAlignedObjectArray<btSolverAnalyticsData> & islandAnalyticsData) const BT_OVERRIDE;
 };
 
 #endif  //BT_DISCRETE_DYNAMICS_WORLD_H
@@ -46,6 +46,9 @@ enum btRigidBodyFlags
 	BT_ENABLE_GYROSCOPIC_FORCE_IMPLICIT_WORLD = 4,
 	BT_ENABLE_GYROSCOPIC_FORCE_IMPLICIT_BODY = 8,
 	BT_ENABLE_GYROPSCOPIC_FORCE = BT_ENABLE_GYROSCOPIC_FORCE_IMPLICIT_BODY,
+	///small fast bodies: btDiscreteDynamicsWorld sweeps a sphere of getCcdSweptSphereRadius() along the motion of all of them
+	///in one batch, instead of the per-body convexSweepTest of the regular CCD. See btDiscreteDynamicsWorld::integrateProjectiles
+	BT_ENABLE_PROJECTILE_CCD = 16,
 };
 
 ///The btRigidBody is the main class for rigid body objects. It is derived from btCollisionObject, so it keeps a pointer to a btCollisionShape.
@@ -22,6 +22,7 @@ subject to the following restrictions:
 #include "BulletCollision/CollisionDispatch/btCollisionWorld.h"
 #include "BulletDynamics/ConstraintSolver/btTypedConstraint.h"
 #include "BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolverMt.h"  // for s_minimumContactManifoldsForBatching
+#include "btDiscreteDynamicsWorldMt.h"                                               // for btConstraintSolverPoolMt
 
 //#include <stdio.h>
 #include "LinearMath/btQuickprof.h"
@@ -57,7 +58,8 @@ btSimulationIslandManagerMt::~btSimulationIslandManagerMt()
 	m_freeIslands.resize(0);
 }
 
-inline int getIslandId(const btPersistentManifold* lhs)
+// own name so it can share a TU with btSimulationIslandManager.cpp (the plugin compiles all of Bullet in one file)
+inline int btGetManifoldIslandIdMt(const btPersistentManifold* lhs)
 {
 	const btCollisionObject* rcolObj0 = static_cast<const btCollisionObject*>(lhs->getBody0());
 	const btCollisionObject* rcolObj1 = static_cast<const btCollisionObject*>(lhs->getBody1());
@@ -434,7 +436,7 @@ void btSimulationIslandManagerMt::addManifoldsToIslands(btDispatcher* dispatcher
 			if (dispatcher->needsResponse(colObj0, colObj1))
 			{
 				// scatter manifolds into various islands
-				int islandId = getIslandId(manifold);
+				int islandId = btGetManifoldIslandIdMt(manifold);
 				// if island not sleeping,
 				if (Island* island = getIsland(islandId))
 				{
@@ -529,6 +531,22 @@ void btSimulationIslandManagerMt::solveIsland(btConstraintSolver* solver, Island
 {
 	btPersistentManifold** manifolds = island.manifoldArray.size() ? &island.manifoldArray[0] : NULL;
 	btTypedConstraint** constraintsPtr = island.constraintArray.size() ? &island.constraintArray[0] : NULL;
+	island.analyticsData = btSolverAnalyticsData();
+	if (solver == solverParams.m_solverPool)
+	{
+		// the pool hands the island to whichever solver is free, its analytics have to be read before the solver is released
+		static_cast<btConstraintSolverPoolMt*>(solver)->solveGroupWithAnalytics(&island.bodyArray[0],
+																				 island.bodyArray.size(),
+																				 manifolds,
+																				 island.manifoldArray.size(),
+																				 constraintsPtr,
+																				 island.constraintArray.size(),
+																				 *solverParams.m_solverInfo,
+																				 solverParams.m_debugDrawer,
+																				 solverParams.m_dispatcher,
+																				 &island.analyticsData);
+		return;
+	}
 	solver->solveGroup(&island.bodyArray[0],
 					   island.bodyArray.size(),
 					   manifolds,
@@ -538,6 +556,23 @@ void btSimulationIslandManagerMt::solveIsland(btConstraintSolver* solver, Island
 					   *solverParams.m_solverInfo,
 					   solverParams.m_debugDrawer,
 					   solverParams.m_dispatcher);
+	if ((solverParams.m_solverInfo->m_reportSolverAnalytics & 1) && solver->getSolverType() == BT_SEQUENTIAL_IMPULSE_SOLVER)
+	{
+		island.analyticsData = static_cast<btSequentialImpulseConstraintSolver*>(solver)->m_analyticsData;
+	}
+}
+
+void btSimulationIslandManagerMt::getAnalyticsData(btAlignedObjectArray<btSolverAnalyticsData>& islandAnalyticsData) const
+{
+	islandAnalyticsData.resize(0);
+	for (int i = 0; i < m_activeIslands.size(); ++i)
+	{
+		const btSolverAnalyticsData& data = m_activeIslands[i]->analyticsData;
+		if (data.m_numSolverCalls > 0)
+		{
+			islandAnalyticsData.push_back(data);
+		}
+	}
 }
 
 void btSimulationIslandManagerMt::serialIslandDispatch(btAlignedObjectArray<Island*>* islandsPtr, const SolverParams& solverParams)
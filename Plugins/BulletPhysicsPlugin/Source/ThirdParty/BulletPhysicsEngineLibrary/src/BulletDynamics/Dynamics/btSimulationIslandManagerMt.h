@@ -17,6 +17,7 @@ subject to the following restrictions:
 #define BT_SIMULATION_ISLAND_MANAGER_MT_H
 
 #include "BulletCollision/CollisionDispatch/btSimulationIslandManager.h"
+#include "BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolver.h"  // for btSolverAnalyticsData
 
 class btTypedConstraint;
 class btConstraintSolver;
@@ -44,6 +45,7 @@ public:
 		btAlignedObjectArray<btTypedConstraint*> constraintArray;
 		int id;  // island id
 		bool isSleeping;
+		btSolverAnalyticsData analyticsData;  // written by whichever thread solved this island
 
 		void append(const Island& other);  // add bodies, manifolds, constraints to my own
 	};
@@ -98,6 +100,17 @@ public:
 	{
 		m_minimumSolverBatchSize = sz;
 	}
+	int getBatchIslandMinBodyCount() const
+	{
+		return m_batchIslandMinBodyCount;
+	}
+	// islands with fewer bodies than this are packed together into one batch island, so tiny islands don't cost a task each
+	void setBatchIslandMinBodyCount(int count)
+	{
+		m_batchIslandMinBodyCount = count;
+	}
+	///solver statistics of the islands solved in the last step, in the order the islands were dispatched
+	void getAnalyticsData(btAlignedObjectArray<btSolverAnalyticsData>& islandAnalyticsData) const;
 	IslandDispatchFunc getIslandDispatchFunction() const
 	{
 		return m_islandDispatch;
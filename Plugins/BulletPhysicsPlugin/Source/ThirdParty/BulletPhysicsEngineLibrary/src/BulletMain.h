@@ -9,5 +9,12 @@ THIRD_PARTY_INCLUDES_START
 PRAGMA_PUSH_PLATFORM_DEFAULT_PACKING
 #include <btBulletDynamicsCommon.h>
 #include <BulletCollision/CollisionShapes/btBoxShape.h>
+#include <BulletCollision/BroadphaseCollision/btSapBroadphase.h>
+#include <BulletCollision/CollisionShapes/btHeightfieldTerrainShape.h>
+#include <BulletCollision/CollisionShapes/btSdfCollisionShape.h>
+#include <BulletCollision/CollisionShapes/btSdfBrickGrid.h>
+#include <BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolverWide.h>
+#include <BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h>
+#include <LinearMath/btPoolAllocator.h>
 PRAGMA_POP_PLATFORM_DEFAULT_PACKING
 THIRD_PARTY_INCLUDES_END
\ No newline at end of file
@@ -12,6 +12,15 @@
 #endif  //BT_ALLOW_SSE4
 #endif  //USE_SIMD
 
+#if defined(BT_USE_SSE) && (defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__))
+#define BT_CPU_FEATURE_X86_AVX2 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif  //BT_USE_SSE
+
 #if defined BT_USE_NEON
 #define ARM_NEON_GCC_COMPATIBILITY 1
 #include <arm_neon.h>
@@ -19,7 +28,7 @@
 #include <sys/sysctl.h>  //for sysctlbyname
 #endif                   //BT_USE_NEON
 
-///Rudimentary btCpuFeatureUtility for CPU features: only report the features that Bullet actually uses (SSE4/FMA3, NEON_HPFP)
+///Rudimentary btCpuFeatureUtility for CPU features: only report the features that Bullet actually uses (SSE4/FMA3, AVX2, NEON_HPFP)
 ///We assume SSE2 in case BT_USE_SSE2 is defined in LinearMath/btScalar.h
 class btCpuFeatureUtility
 {
@@ -28,9 +37,39 @@ public:
 	{
 		CPU_FEATURE_FMA3 = 1,
 		CPU_FEATURE_SSE4_1 = 2,
-		CPU_FEATURE_NEON_HPFP = 4
+		CPU_FEATURE_NEON_HPFP = 4,
+		CPU_FEATURE_AVX2 = 8
 	};
 
+#ifdef BT_CPU_FEATURE_X86_AVX2
+	static void cpuId(int cpuInfo[4], int leaf, int subLeaf)
+	{
+#ifdef _MSC_VER
+		__cpuidex(cpuInfo, leaf, subLeaf);
+#else
+		unsigned int regs[4] = {0, 0, 0, 0};
+		if (leaf == 0 || leaf <= (int)__get_cpuid_max(0, 0))
+		{
+			__cpuid_count(leaf, subLeaf, regs[0], regs[1], regs[2], regs[3]);
+		}
+		memcpy(cpuInfo, regs, sizeof(regs));
+#endif
+	}
+
+	static unsigned long long xgetbv0()
+	{
+#ifdef _MSC_VER
+		return _xgetbv(0);
+#else
+		unsigned int lo, hi;
+		__asm__ __volatile__("xgetbv"
+							 : "=a"(lo), "=d"(hi)
+							 : "c"(0));
+		return ((unsigned long long)hi << 32) | lo;
+#endif
+	}
+#endif  //BT_CPU_FEATURE_X86_AVX2
+
 	static int getCpuFeatures()
 	{
 		static int capabilities = 0;
@@ -80,6 +119,25 @@ public:
 		}
 #endif  //BT_ALLOW_SSE4
 
+#ifdef BT_CPU_FEATURE_X86_AVX2
+		{
+			// AVX2 needs the CPU bit and the OS saving the ymm state
+			int cpuInfo[4];
+			cpuId(cpuInfo, 0, 0);
+			int maxLeaf = cpuInfo[0];
+			cpuId(cpuInfo, 1, 0);
+			const int OSXSAVEAndAVXFlags = (1 << 27) | (1 << 28);
+			if (maxLeaf >= 7 && (cpuInfo[2] & OSXSAVEAndAVXFlags) == OSXSAVEAndAVXFlags && (xgetbv0() & 6) == 6)
+			{
+				cpuId(cpuInfo, 7, 0);
+				if (cpuInfo[1] & (1 << 5))
+				{
+					capabilities |= btCpuFeatureUtility::CPU_FEATURE_AVX2;
+				}
+			}
+		}
+#endif  //BT_CPU_FEATURE_X86_AVX2
+
 		testedCapabilities = true;
 		return capabilities;
 	}
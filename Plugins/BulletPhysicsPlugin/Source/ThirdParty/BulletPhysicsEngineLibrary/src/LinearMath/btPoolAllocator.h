@@ -17,40 +17,87 @@ subject to the following restrictions:
 
 #include "btScalar.h"
 #include "btAlignedAllocator.h"
+#include "btAlignedObjectArray.h"
 #include "btThreads.h"
 
 ///The btPoolAllocator class allows to efficiently allocate a large pool of objects, instead of dynamically allocating them separately.
+///With a grow size the pool never runs dry: when it is used up it adds another chunk of that many elements, which lives as long
+///as the pool. Without one, allocate returns NULL once the pool is full and the caller has to fall back to the heap.
 class btPoolAllocator
 {
+	struct Chunk
+	{
+		unsigned char* m_memory;
+		int m_numElements;
+	};
+
 	int m_elemSize;
-	int m_maxElements;
+	int m_maxElements;  // over all chunks
 	int m_freeCount;
 	void* m_firstFree;
-	unsigned char* m_pool;
-	btSpinMutex m_mutex;  // only used if BT_THREADSAFE
-
-public:
-	btPoolAllocator(int elemSize, int maxElements)
-		: m_elemSize(elemSize),
-		  m_maxElements(maxElements)
+	unsigned char* m_pool;  // first chunk
+	int m_poolElements;
+	btSpinMutex m_mutex;    // only used if BT_THREADSAFE
+	int m_growElements;
+	int m_overflowCount;
+	int m_peakUsedCount;
+	btAlignedObjectArray<Chunk> m_chunks;
+
+	void addChunk(int numElements)
 	{
-		m_pool = (unsigned char*)btAlignedAlloc(static_cast<unsigned int>(m_elemSize * m_maxElements), 16);
-
-		unsigned char* p = m_pool;
-		m_firstFree = p;
-		m_freeCount = m_maxElements;
-		int count = m_maxElements;
+		unsigned char* p = (unsigned char*)btAlignedAlloc(static_cast<unsigned int>(m_elemSize * numElements), 16);
+		Chunk chunk;
+		chunk.m_memory = p;
+		chunk.m_numElements = numElements;
+		m_chunks.push_back(chunk);
+
+		// the new elements go in front of whatever is still free
+		int count = numElements;
 		while (--count)
 		{
 			*(void**)p = (p + m_elemSize);
 			p += m_elemSize;
 		}
-		*(void**)p = 0;
+		*(void**)p = m_firstFree;
+		m_firstFree = chunk.m_memory;
+		m_freeCount += numElements;
+		m_maxElements += numElements;
+	}
+
+	bool isInPool(const void* ptr) const
+	{
+		for (int i = 0; i < m_chunks.size(); i++)
+		{
+			const unsigned char* memory = m_chunks[i].m_memory;
+			if ((const unsigned char*)ptr >= memory && (const unsigned char*)ptr < memory + m_chunks[i].m_numElements * m_elemSize)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+public:
+	btPoolAllocator(int elemSize, int maxElements, int growElements = 0)
+		: m_elemSize(elemSize),
+		  m_maxElements(0),
+		  m_freeCount(0),
+		  m_firstFree(0),
+		  m_growElements(growElements),
+		  m_overflowCount(0),
+		  m_peakUsedCount(0)
+	{
+		addChunk(maxElements);
+		m_pool = m_chunks[0].m_memory;
+		m_poolElements = maxElements;
 	}
 
 	~btPoolAllocator()
 	{
-		btAlignedFree(m_pool);
+		for (int i = 0; i < m_chunks.size(); i++)
+		{
+			btAlignedFree(m_chunks[i].m_memory);
+		}
 	}
 
 	int getFreeCount() const
@@ -68,6 +115,28 @@ public:
 		return m_maxElements;
 	}
 
+	///highest getUsedCount() so far, a good size for the next pool
+	int getPeakUsedCount() const
+	{
+		return m_peakUsedCount;
+	}
+
+	///how often the pool was empty on allocate: it grew, or returned NULL if it can't grow
+	int getOverflowCount() const
+	{
+		return m_overflowCount;
+	}
+
+	int getGrowElements() const
+	{
+		return m_growElements;
+	}
+
+	void setGrowElements(int growElements)
+	{
+		m_growElements = growElements;
+	}
+
 	void* allocate(int size)
 	{
 		// release mode fix
@@ -75,11 +144,20 @@ public:
 		btMutexLock(&m_mutex);
 		btAssert(!size || size <= m_elemSize);
 		//btAssert(m_freeCount>0);  // should return null if all full
+		if (NULL == m_firstFree)
+		{
+			++m_overflowCount;
+			if (m_growElements > 0)
+			{
+				addChunk(m_growElements);
+			}
+		}
 		void* result = m_firstFree;
 		if (NULL != m_firstFree)
 		{
 			m_firstFree = *(void**)m_firstFree;
 			--m_freeCount;
+			m_peakUsedCount = btMax(m_peakUsedCount, m_maxElements - m_freeCount);
 		}
 		btMutexUnlock(&m_mutex);
 		return result;
@@ -89,10 +167,15 @@ public:
 	{
 		if (ptr)
 		{
-			if (((unsigned char*)ptr >= m_pool && (unsigned char*)ptr < m_pool + m_maxElements * m_elemSize))
+			if (((unsigned char*)ptr >= m_pool && (unsigned char*)ptr < m_pool + m_poolElements * m_elemSize))
 			{
 				return true;
 			}
+			// another thread may be adding a chunk
+			btMutexLock(&m_mutex);
+			bool inPool = isInPool(ptr);
+			btMutexUnlock(&m_mutex);
+			return inPool;
 		}
 		return false;
 	}
@@ -101,9 +184,8 @@ public:
 	{
 		if (ptr)
 		{
-			btAssert((unsigned char*)ptr >= m_pool && (unsigned char*)ptr < m_pool + m_maxElements * m_elemSize);
-
 			btMutexLock(&m_mutex);
+			btAssert(isInPool(ptr));
 			*(void**)ptr = m_firstFree;
 			m_firstFree = ptr;
 			++m_freeCount;
@@ -116,6 +198,7 @@ public:
 		return m_elemSize;
 	}
 
+	///the first chunk only, elements of chunks added later are elsewhere
 	unsigned char* getPoolAddress()
 	{
 		return m_pool;
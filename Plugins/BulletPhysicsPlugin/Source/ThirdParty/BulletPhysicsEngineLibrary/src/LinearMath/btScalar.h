@@ -275,6 +275,39 @@ inline int btIsDoublePrecision()
 				#define btLikely(_c)  _c
 				#define btUnlikely(_c) _c
 
+			#elif defined (__linux__) && (defined (__i386__) || defined (__x86_64__)) && (!defined (BT_USE_DOUBLE_PRECISION))
+				//Linux x86 with GCC/Clang: SSE4.1 is the baseline for our dedicated servers (UE builds Linux x64 with SSE4.2),
+				//and the plugin compiles Bullet with FP contraction off (no fused multiply-add) so the results match the Windows client bit for bit.
+				//Define __BT_DISABLE_SSE__ to fall back to the scalar path.
+				#if defined (__SSE4_1__) && !defined (__BT_DISABLE_SSE__)
+					#define BT_USE_SIMD_VECTOR3
+					#define BT_USE_SSE
+					//BT_USE_SSE_IN_API stays opt-in like on Windows, the inline math has to match the client build.
+					//Every Bullet type is 16-byte aligned below (and btAlignedAllocator/BT_DECLARE_ALIGNED_ALLOCATOR
+					//handle the heap), so it can be defined here and in the Windows build together.
+					//BT_ALLOW_SSE4 is left off, it only selects the FMA3 solver rows at runtime (and needs MSVC's __cpuid).
+					#include <smmintrin.h>
+				#endif //__SSE4_1__
+
+				#define SIMD_FORCE_INLINE inline __attribute__ ((always_inline))
+				#define ATTRIBUTE_ALIGNED16(a) a __attribute__ ((aligned (16)))
+				#define ATTRIBUTE_ALIGNED64(a) a __attribute__ ((aligned (64)))
+				#define ATTRIBUTE_ALIGNED128(a) a __attribute__ ((aligned (128)))
+				#ifndef assert
+				#include <assert.h>
+				#endif
+
+				#if defined(DEBUG) || defined (_DEBUG)
+					#define btAssert assert
+				#else
+					#define btAssert(x)
+				#endif
+
+				//btFullAssert is optional, slows down a lot
+				#define btFullAssert(x)
+				#define btLikely(_c)  __builtin_expect((_c), 1)
+				#define btUnlikely(_c) __builtin_expect((_c), 0)
+
 			#else//__APPLE__
 
 				#define SIMD_FORCE_INLINE inline
@@ -33,6 +33,8 @@ const unsigned int BT_MAX_THREAD_COUNT = 64;  // only if BT_THREADSAFE is 1
 // for internal use only
 bool btIsMainThread();
 bool btThreadsAreRunning();
+void btPushThreadsAreRunning();  // for task schedulers, around every parallel section
+void btPopThreadsAreRunning();
 unsigned int btGetCurrentThreadIndex();
 void btResetThreadIndexCounter();  // notify that all worker threads have been destroyed
 
@@ -7,6 +7,7 @@
 #include "BulletCollision/BroadphaseCollision/btCollisionAlgorithm.cpp"
 #include "BulletCollision/BroadphaseCollision/btDispatcher.cpp"
 #include "BulletCollision/BroadphaseCollision/btSimpleBroadphase.cpp"
+#include "BulletCollision/BroadphaseCollision/btSapBroadphase.cpp"
 #include "BulletCollision/CollisionDispatch/SphereTriangleDetector.cpp"
 #include "BulletCollision/CollisionDispatch/btCompoundCollisionAlgorithm.cpp"
 #include "BulletCollision/CollisionDispatch/btHashedSimplePairCache.cpp"
@@ -22,6 +23,7 @@
 #include "BulletCollision/CollisionDispatch/btBoxBoxDetector.cpp"
 #include "BulletCollision/CollisionDispatch/btConvexConvexAlgorithm.cpp"
 #include "BulletCollision/CollisionDispatch/btSphereBoxCollisionAlgorithm.cpp"
+#include "BulletCollision/CollisionDispatch/btCapsuleBoxCollisionAlgorithm.cpp"
 #include "BulletCollision/CollisionDispatch/btCollisionDispatcher.cpp"
 #include "BulletCollision/CollisionDispatch/btCollisionDispatcherMt.cpp"
 #include "BulletCollision/CollisionDispatch/btConvexPlaneCollisionAlgorithm.cpp"
@@ -81,6 +83,7 @@
 #include "BulletCollision/CollisionShapes/btTriangleMeshShape.cpp"
 #include "BulletCollision/CollisionShapes/btConvexPointCloudShape.cpp"
 #include "BulletCollision/CollisionShapes/btScaledBvhTriangleMeshShape.cpp"
+#include "BulletCollision/CollisionShapes/btSdfBrickGrid.cpp"
 #include "BulletCollision/CollisionShapes/btSdfCollisionShape.cpp"
 #include "BulletCollision/CollisionShapes/btMiniSDF.cpp"
 #include "BulletCollision/CollisionShapes/btUniformScalingShape.cpp"
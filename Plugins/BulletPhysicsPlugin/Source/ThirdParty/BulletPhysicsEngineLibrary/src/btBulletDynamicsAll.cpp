@@ -21,6 +21,7 @@
 #include "BulletDynamics/ConstraintSolver/btGeneric6DofSpring2Constraint.cpp"
 #include "BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolver.cpp"
 #include "BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolverMt.cpp"
+#include "BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolverWide.cpp"
 #include "BulletDynamics/MLCPSolvers/btDantzigLCP.cpp"
 #include "BulletDynamics/MLCPSolvers/btLemkeAlgorithm.cpp"
 #include "BulletDynamics/MLCPSolvers/btMLCPSolver.cpp"
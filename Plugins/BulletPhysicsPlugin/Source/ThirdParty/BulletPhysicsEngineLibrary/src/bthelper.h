@@ -47,6 +47,24 @@ public:
 		else
 			return btVector3(V.X, V.Y, V.Z);
 	}
+	// ToUEPos/ToUEDir for hot loops. btVector3 is four floats on a 16-byte boundary, so it widens to UE's doubles
+	// with one load and a multiply (and add), no FMA, so the result matches the scalar versions bit for bit
+	static FVector ToUEPosVectorized(const btVector3& V, const VectorRegister4Double& WorldOrigin)
+	{
+		FVector Out;
+		VectorStoreDouble3(VectorAdd(VectorMultiply(VectorRegister4Double(VectorLoadAligned(V.m_floats)), UEScale()), WorldOrigin), &Out.X);
+		return Out;
+	}
+	static FVector ToUEDirVectorized(const btVector3& V)
+	{
+		FVector Out;
+		VectorStoreDouble3(VectorMultiply(VectorRegister4Double(VectorLoadAligned(V.m_floats)), UEScale()), &Out.X);
+		return Out;
+	}
+	static VectorRegister4Double UEScale()
+	{
+		return MakeVectorRegisterDouble(BULLET_TO_WORLD_SCALE, BULLET_TO_WORLD_SCALE, BULLET_TO_WORLD_SCALE, BULLET_TO_WORLD_SCALE);
+	}
 	static FQuat ToUE(const btQuaternion& Q)
 	{
 		return FQuat(Q.x(), Q.y(), Q.z(), Q.w());